@@ -1,7 +1,8 @@
 /// \file ijkIO.txx
 /// IO templates for reading/writing meshes.
 /// - Input formats: Geomview .off.
-/// - Output formats: Geomview .off, OpenInventor .iv (3D), Fig .fig (2D).
+/// - Output formats: Geomview .off, OpenInventor .iv (3D), Fig .fig (2D),
+///   binary PLY .ply (3D), binary mesh.
 /// - Version 0.1.1
 
 /*
@@ -26,7 +27,9 @@
 #ifndef _IJKIO_
 #define _IJKIO_
 
+#include <cstring>
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <string>
 
@@ -941,6 +944,254 @@ namespace IJK {
        point_coord.size()/dim, scale, rgba);
   }
 
+  // ******************************************
+  // Write binary PLY and binary mesh files
+  // ******************************************
+
+  // local namespace
+  namespace {
+
+    /// Buffer for binary little-endian output.
+    /// Values are converted to little-endian byte order
+    ///   independent of the machine byte order.
+    /// Buffer is written to the output stream in large blocks.
+    class BINARY_OUTPUT_BUFFER {
+
+    protected:
+      std::ostream & out;
+      std::vector<char> buffer;
+      std::size_t num_bytes;
+
+      void Reserve(const std::size_t n)
+      { if (num_bytes+n > buffer.size()) { Flush(); } }
+
+    public:
+      /// Default buffer size.
+      static const std::size_t DEFAULT_BUFFER_SIZE = (1 << 20);
+
+      BINARY_OUTPUT_BUFFER(std::ostream & output_stream):
+        out(output_stream), buffer(DEFAULT_BUFFER_SIZE)
+      { num_bytes = 0; }
+
+      ~BINARY_OUTPUT_BUFFER() { Flush(); }
+
+      /// Write unsigned integer using nbytes bytes.
+      void WriteUnsigned(const unsigned long long x, const int nbytes)
+      {
+        Reserve(nbytes);
+        for (int i = 0; i < nbytes; i++)
+          { buffer[num_bytes+i] = char((x >> (8*i)) & 0xff); }
+        num_bytes += nbytes;
+      }
+
+      /// Write 1, 4 and 8 byte integers.
+      void WriteUInt8(const unsigned char x) { WriteUnsigned(x, 1); }
+      void WriteUInt32(const unsigned long x) { WriteUnsigned(x, 4); }
+      void WriteUInt64(const unsigned long long x) { WriteUnsigned(x, 8); }
+      void WriteInt32(const long x)
+      { WriteUnsigned((unsigned long long)(x) & 0xffffffffULL, 4); }
+
+      /// Write 32 bit IEEE float.
+      void WriteFloat32(const float x)
+      {
+        unsigned int u;
+        std::memcpy(&u, &x, sizeof(u));
+        WriteUnsigned(u, 4);
+      }
+
+      /// Write string without terminating null character.
+      void WriteString(const std::string & s)
+      {
+        Reserve(s.size());
+        if (s.size() > buffer.size()) {
+          out.write(s.data(), s.size());
+          return;
+        }
+        s.copy(&(buffer[num_bytes]), s.size());
+        num_bytes += s.size();
+      }
+
+      /// Write buffer to output stream.
+      void Flush()
+      {
+        if (num_bytes > 0) { out.write(&(buffer[0]), num_bytes); }
+        num_bytes = 0;
+      }
+    };
+
+    /// Check dimension and type sizes for binary output.
+    inline void check_binary_output
+    (const int dim, IJK::PROCEDURE_ERROR & error)
+    {
+      if (dim <= 0) {
+        error.AddMessage("Illegal dimension: ", dim, ".");
+        throw error;
+      }
+
+      if (sizeof(float) != 4 || sizeof(unsigned int) != 4) {
+        error.AddMessage
+          ("Programming error.  Binary output requires 32 bit float and unsigned int.");
+        throw error;
+      }
+    }
+
+    /// Write polygon vertices as PLY lists.
+    template <typename VTYPE>
+    void ijkoutPolygonVerticesPLY
+    (BINARY_OUTPUT_BUFFER & buffer, const int numv_per_poly,
+     const VTYPE * poly_vert, const int num_poly)
+    {
+      for (int j = 0; j < num_poly; j++) {
+        buffer.WriteUInt8(numv_per_poly);
+        for (int k = 0; k < numv_per_poly; k++)
+          { buffer.WriteInt32(poly_vert[j*numv_per_poly+k]); }
+      }
+    }
+
+  }
+
+  /// Output binary little-endian PLY file.
+  /// Two types of polygons.
+  /// Coordinates are written as 32 bit floats.
+  /// Vertex indices are written as 32 bit integers.
+  /// @param out = Output stream.  Should be opened in binary mode.
+  /// @param dim = Dimension of vertices.  Must be 3.
+  /// @param coord = Array of coordinates. 
+  ///        coord[dim*i+k] = k'th coordinate of vertex i (k < dim).
+  /// @param poly1_vlist = List of vertices of poly 1.
+  /// @param numv_per_poly1 = Number of vertices per polygon in poly1_vlist.
+  /// @param num_poly1 = Number of poly1 polygons.
+  /// @param poly2_vlist = List of vertices of poly 2.
+  /// @param numv_per_poly2 = Number of vertices per polygon in poly2_vlist.
+  /// @param num_poly2 = Number of poly2 polygons.
+  template <typename CTYPE, typename VTYPE1, typename VTYPE2> 
+  void ijkoutPLYbinary
+  (std::ostream & out, const int dim, const CTYPE * coord, const int numv,
+   const VTYPE1 * poly1_vlist, const int numv_per_poly1, const int num_poly1,
+   const VTYPE2 * poly2_vlist, const int numv_per_poly2, const int num_poly2)
+  {
+    const char * axis_name[3] = { "x", "y", "z" };
+    IJK::PROCEDURE_ERROR error("ijkoutPLYbinary");
+
+    check_binary_output(dim, error);
+    if (dim != 3) {
+      error.AddMessage("Illegal dimension: ", dim, ".");
+      error.AddMessage("  PLY output requires dimension 3.");
+      throw error;
+    }
+
+    std::ostringstream header;
+    header << "ply" << std::endl
+           << "format binary_little_endian 1.0" << std::endl
+           << "element vertex " << numv << std::endl;
+    for (int d = 0; d < dim; d++) 
+      { header << "property float " << axis_name[d] << std::endl; }
+    header << "element face " << num_poly1+num_poly2 << std::endl
+           << "property list uchar int vertex_indices" << std::endl
+           << "end_header" << std::endl;
+
+    BINARY_OUTPUT_BUFFER buffer(out);
+    buffer.WriteString(header.str());
+
+    for (int i = 0; i < numv*dim; i++)
+      { buffer.WriteFloat32(coord[i]); }
+
+    ijkoutPolygonVerticesPLY(buffer, numv_per_poly1, poly1_vlist, num_poly1);
+    ijkoutPolygonVerticesPLY(buffer, numv_per_poly2, poly2_vlist, num_poly2);
+    buffer.Flush();
+  }
+
+  /// Output binary little-endian PLY file.
+  /// C++ STL vector format for coord[], poly1_vlist[] and poly2_vlist[].
+  template <typename CTYPE, typename VTYPE1, typename VTYPE2> 
+  void ijkoutPLYbinary
+  (std::ostream & out, const int dim, const std::vector<CTYPE> & coord,
+   const std::vector<VTYPE1> & poly1_vlist, const int numv_per_poly1,
+   const std::vector<VTYPE2> & poly2_vlist, const int numv_per_poly2)
+  {
+    const int numv = coord.size()/dim;
+    const int num_poly1 = poly1_vlist.size()/numv_per_poly1;
+    const int num_poly2 = poly2_vlist.size()/numv_per_poly2;
+
+    ijkoutPLYbinary(out, dim, vector2pointer(coord), numv,
+                    vector2pointer(poly1_vlist), numv_per_poly1, num_poly1,
+                    vector2pointer(poly2_vlist), numv_per_poly2, num_poly2);
+  }
+
+  /// Size in bytes of binary mesh file header.
+  const int BINARY_MESH_HEADER_SIZE = 64;
+
+  /// Output binary mesh file.
+  /// Two types of polygons.
+  /// All values are little-endian.
+  /// Header has BINARY_MESH_HEADER_SIZE bytes:
+  /// - 8 bytes: "IJKBMESH".
+  /// - uint32: Version (1).
+  /// - uint32: Dimension.
+  /// - uint32: Bytes per coordinate (4, IEEE float).
+  /// - uint32: Bytes per vertex index (4, signed integer).
+  /// - uint64: Number of vertices.
+  /// - uint32, uint32: Number of vertices per poly1 and per poly2.
+  /// - uint64, uint64: Number of poly1 and of poly2 polygons.
+  /// - Zero padding.
+  /// Header is followed by the coordinate array,
+  ///   the poly1 vertex array and the poly2 vertex array.
+  /// Arrays start on 4 byte boundaries so the file can be
+  ///   memory mapped and read in place.
+  /// @param out = Output stream.  Should be opened in binary mode.
+  template <typename CTYPE, typename VTYPE1, typename VTYPE2> 
+  void ijkoutBinaryMesh
+  (std::ostream & out, const int dim, const CTYPE * coord, const int numv,
+   const VTYPE1 * poly1_vlist, const int numv_per_poly1, const int num_poly1,
+   const VTYPE2 * poly2_vlist, const int numv_per_poly2, const int num_poly2)
+  {
+    IJK::PROCEDURE_ERROR error("ijkoutBinaryMesh");
+
+    check_binary_output(dim, error);
+
+    BINARY_OUTPUT_BUFFER buffer(out);
+    buffer.WriteString("IJKBMESH");
+    buffer.WriteUInt32(1);
+    buffer.WriteUInt32(dim);
+    buffer.WriteUInt32(4);
+    buffer.WriteUInt32(4);
+    buffer.WriteUInt64(numv);
+    buffer.WriteUInt32(numv_per_poly1);
+    buffer.WriteUInt32(numv_per_poly2);
+    buffer.WriteUInt64(num_poly1);
+    buffer.WriteUInt64(num_poly2);
+    for (int i = 56; i < BINARY_MESH_HEADER_SIZE; i++)
+      { buffer.WriteUInt8(0); }
+
+    for (int i = 0; i < numv*dim; i++)
+      { buffer.WriteFloat32(coord[i]); }
+
+    for (int i = 0; i < num_poly1*numv_per_poly1; i++)
+      { buffer.WriteInt32(poly1_vlist[i]); }
+
+    for (int i = 0; i < num_poly2*numv_per_poly2; i++)
+      { buffer.WriteInt32(poly2_vlist[i]); }
+
+    buffer.Flush();
+  }
+
+  /// Output binary mesh file.
+  /// C++ STL vector format for coord[], poly1_vlist[] and poly2_vlist[].
+  template <typename CTYPE, typename VTYPE1, typename VTYPE2> 
+  void ijkoutBinaryMesh
+  (std::ostream & out, const int dim, const std::vector<CTYPE> & coord,
+   const std::vector<VTYPE1> & poly1_vlist, const int numv_per_poly1,
+   const std::vector<VTYPE2> & poly2_vlist, const int numv_per_poly2)
+  {
+    const int numv = coord.size()/dim;
+    const int num_poly1 = poly1_vlist.size()/numv_per_poly1;
+    const int num_poly2 = poly2_vlist.size()/numv_per_poly2;
+
+    ijkoutBinaryMesh(out, dim, vector2pointer(coord), numv,
+                     vector2pointer(poly1_vlist), numv_per_poly1, num_poly1,
+                     vector2pointer(poly2_vlist), numv_per_poly2, num_poly2);
+  }
+
   // ******************************************
   // Read Geomview OFF file
   // ******************************************
@@ -80,6 +80,73 @@ namespace {
       sdata[iv] = lup(nrrd_data, iv);
   }
 
+  template <> inline void nrrd2scalar<unsigned char>
+  ( Nrrd *nrrd, unsigned char * sdata )
+  // convert nrrd to <unsigned char> data and store in sdata
+  // nrrd = nrrd data structure
+  //   Must have type unsigned char
+  // sdata = array of unsigned char
+  //   Must be preallocated to size at least nrrdElementNumber(nrrd)
+  {
+    if (nrrd->type != nrrdTypeUChar) {
+      std::cerr << "Input error: Nrrd data type must be unsigned char"
+                << " to read into unsigned char array." << std::endl;
+      exit(61);
+    }
+
+    int (*lup) (const void *, size_t iv);
+
+    void * nrrd_data = nrrd->data;
+    int numv = nrrdElementNumber(nrrd);
+    lup = nrrdILookup[nrrd->type];
+
+    nrrd_check_null(numv, sdata);
+
+    for (int iv = 0; iv < numv; iv++)
+      sdata[iv] = lup(nrrd_data, iv);
+  }
+
+  template <> inline void nrrd2scalar<unsigned short>
+  ( Nrrd *nrrd, unsigned short * sdata )
+  // convert nrrd to <unsigned short> data and store in sdata
+  // nrrd = nrrd data structure
+  //   Must have type unsigned char or unsigned short
+  // sdata = array of unsigned short
+  //   Must be preallocated to size at least nrrdElementNumber(nrrd)
+  {
+    if (nrrd->type != nrrdTypeUChar && nrrd->type != nrrdTypeUShort) {
+      std::cerr << "Input error: Nrrd data type must be unsigned char"
+                << " or unsigned short to read into unsigned short array."
+                << std::endl;
+      exit(61);
+    }
+
+    int (*lup) (const void *, size_t iv);
+
+    void * nrrd_data = nrrd->data;
+    int numv = nrrdElementNumber(nrrd);
+    lup = nrrdILookup[nrrd->type];
+
+    nrrd_check_null(numv, sdata);
+
+    for (int iv = 0; iv < numv; iv++)
+      sdata[iv] = lup(nrrd_data, iv);
+  }
+
+  template <typename T> 
+  inline bool nrrd_type_fits(const int nrrd_type, const T * sdata)
+  // return true if values of nrrd_type can be stored in sdata.
+  // float, double and int arrays accept every nrrd type.
+  { return(true); }
+
+  inline bool nrrd_type_fits
+  (const int nrrd_type, const unsigned char * sdata)
+  { return(nrrd_type == nrrdTypeUChar); }
+
+  inline bool nrrd_type_fits
+  (const int nrrd_type, const unsigned short * sdata)
+  { return(nrrd_type == nrrdTypeUChar || nrrd_type == nrrdTypeUShort); }
+
 }
 
 #endif
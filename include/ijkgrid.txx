@@ -546,6 +546,77 @@ namespace IJK {
 
   };
 
+  // **************************************************
+  // TEMPLATE CLASS GRID_NEIGHBORHOOD_STENCIL
+  // **************************************************
+
+  /// \brief Precomputed offsets of vertices in a neighborhood of a vertex.
+  /// \details The neighborhood of vertex iv is all vertices within
+  ///   L-infinity distance \a distance of iv, not including iv.
+  ///   iv + Offset(k) is the k'th neighbor of iv.
+  ///   If IsInterior(coord) is false, some neighbors lie outside the grid
+  ///   and each neighbor must be tested with ContainsNeighbor().
+  /// Neighbors are listed in the same order as 
+  ///   get_grid_vertices_in_neighborhood() returns them.
+  /// @tparam DTYPE  Dimension data type.
+  /// @tparam ATYPE  Axis size type.
+  /// @tparam DIFFTYPE  Index difference type.  Must be signed.
+  /// @tparam NTYPE  Number type.
+  template <typename DTYPE, typename ATYPE, typename DIFFTYPE, typename NTYPE>
+  class GRID_NEIGHBORHOOD_STENCIL {
+
+  protected:
+    DTYPE dimension;                   ///< Grid dimension.
+    DIFFTYPE distance;                 ///< Neighborhood distance.
+    std::vector<ATYPE> axis_size;      ///< Grid axis size.
+
+    /// iv + offset[k] = k'th neighbor of vertex iv.
+    std::vector<DIFFTYPE> offset;
+
+    /// offset_coord[k*dimension+d] = 
+    ///   (d'th coordinate of k'th neighbor of iv) - (d'th coordinate of iv).
+    std::vector<DIFFTYPE> offset_coord;
+
+  public:
+    GRID_NEIGHBORHOOD_STENCIL() 
+    { dimension = 0; distance = 0; };
+
+    /// Set stencil for neighborhoods of vertices of grid.
+    template <typename GTYPE, typename DIST_TYPE>
+    void Set(const GTYPE & grid, const DIST_TYPE distance);
+
+    // get functions
+    DTYPE Dimension() const
+    { return(dimension); }
+
+    DIFFTYPE Distance() const
+    { return(distance); }
+
+    /// Return number of neighbors of an interior vertex.
+    NTYPE NumNeighbors() const
+    { return(offset.size()); }
+
+    /// Return k'th neighbor of vertex iv.
+    template <typename VTYPE>
+    VTYPE Neighbor(const VTYPE iv, const NTYPE k) const
+    { return(iv + offset[k]); }
+
+    /// Return difference between d'th coordinates of k'th neighbor
+    ///   and the vertex.
+    DIFFTYPE OffsetCoord(const NTYPE k, const DTYPE d) const
+    { return(offset_coord[k*dimension+d]); }
+
+    /// Return true if all neighbors of vertex with coordinates coord[]
+    ///   are in the grid.
+    template <typename CTYPE>
+    bool IsInterior(const CTYPE * coord) const;
+
+    /// Return true if k'th neighbor of vertex with coordinates coord[]
+    ///   is in the grid.
+    template <typename CTYPE>
+    bool ContainsNeighbor(const CTYPE * coord, const NTYPE k) const;
+  };
+
   // **************************************************
   // TEMPLATE CLASS GRID_SPACING
   // **************************************************
@@ -4749,6 +4820,96 @@ namespace IJK {
     SetSize(grid2.Dimension(), grid2.AxisSize());
   }
 
+  // **************************************************
+  // TEMPLATE CLASS GRID_NEIGHBORHOOD_STENCIL MEMBER FUNCTIONS
+  // **************************************************
+
+  /// Set stencil for neighborhoods of vertices of grid.
+  template <typename DTYPE, typename ATYPE, typename DIFFTYPE, typename NTYPE>
+  template <typename GTYPE, typename DIST_TYPE>
+  void GRID_NEIGHBORHOOD_STENCIL<DTYPE,ATYPE,DIFFTYPE,NTYPE>::Set
+  (const GTYPE & grid, const DIST_TYPE distance)
+  {
+    const DTYPE dimension = grid.Dimension();
+    const DIFFTYPE width = 2*DIFFTYPE(distance)+1;
+    IJK::ARRAY<DIFFTYPE> coord(dimension);
+    IJK::ARRAY<DIFFTYPE> axis_increment(dimension);
+
+    this->dimension = dimension;
+    this->distance = distance;
+    axis_size.assign(grid.AxisSize(), grid.AxisSize()+dimension);
+    offset.clear();
+    offset_coord.clear();
+
+    if (distance < 0) { return; }
+
+    compute_increment(dimension, grid.AxisSize(), axis_increment.Ptr());
+
+    NTYPE num_box_vertices = 1;
+    for (DTYPE d = 0; d < dimension; d++) 
+      { num_box_vertices *= width; }
+
+    offset.reserve(num_box_vertices);
+    offset_coord.reserve(num_box_vertices*dimension);
+
+    // Enumerate box [-distance,distance]^dimension with
+    //   coordinate 0 varying fastest.
+    for (DTYPE d = 0; d < dimension; d++) 
+      { coord[d] = -DIFFTYPE(distance); }
+
+    for (NTYPE j = 0; j < num_box_vertices; j++) {
+
+      DIFFTYPE inc = 0;
+      bool is_center = true;
+      for (DTYPE d = 0; d < dimension; d++) {
+        inc += coord[d]*axis_increment[d];
+        if (coord[d] != 0) { is_center = false; }
+      }
+
+      if (!is_center) {
+        offset.push_back(inc);
+        for (DTYPE d = 0; d < dimension; d++) 
+          { offset_coord.push_back(coord[d]); }
+      }
+
+      for (DTYPE d = 0; d < dimension; d++) {
+        coord[d]++;
+        if (coord[d] <= DIFFTYPE(distance)) { break; }
+        coord[d] = -DIFFTYPE(distance);
+      }
+    }
+  }
+
+  /// Return true if all neighbors of vertex with coordinates coord[]
+  ///   are in the grid.
+  template <typename DTYPE, typename ATYPE, typename DIFFTYPE, typename NTYPE>
+  template <typename CTYPE>
+  bool GRID_NEIGHBORHOOD_STENCIL<DTYPE,ATYPE,DIFFTYPE,NTYPE>::IsInterior
+  (const CTYPE * coord) const
+  {
+    for (DTYPE d = 0; d < dimension; d++) {
+      if (coord[d] < distance) { return(false); }
+      if (coord[d]+distance >= axis_size[d]) { return(false); }
+    }
+    return(true);
+  }
+
+  /// Return true if k'th neighbor of vertex with coordinates coord[]
+  ///   is in the grid.
+  template <typename DTYPE, typename ATYPE, typename DIFFTYPE, typename NTYPE>
+  template <typename CTYPE>
+  bool GRID_NEIGHBORHOOD_STENCIL<DTYPE,ATYPE,DIFFTYPE,NTYPE>::ContainsNeighbor
+  (const CTYPE * coord, const NTYPE k) const
+  {
+    const DIFFTYPE * kcoord = &(offset_coord[k*dimension]);
+
+    for (DTYPE d = 0; d < dimension; d++) {
+      const CTYPE c = coord[d] + kcoord[d];
+      if (c < 0 || c >= axis_size[d]) { return(false); }
+    }
+    return(true);
+  }
+
   // **************************************************
   // TEMPLATE CLASS GRID_SPACING MEMBER FUNCTIONS
   // **************************************************
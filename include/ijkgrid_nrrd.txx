@@ -24,7 +24,21 @@
 #ifndef _IJKGRID_NRRD_
 #define _IJKGRID_NRRD_
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
 #include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "ijk.txx"
 #include "ijkNrrd.h"
@@ -150,6 +164,194 @@ namespace IJK {
      NRRD_DATA<DTYPE2,ATYPE2> & header, IJK::ERROR & error);
   };
 
+  // **************************************************
+  // TEMPLATE CLASS NRRD_RAW_MAP
+  // **************************************************
+
+  /// Memory map of the data in a nrrd file with raw (uncompressed) data.
+  /// Data may be attached to the header or in a detached data file.
+  /// If the data starts at a multiple of the scalar size in the file,
+  ///   pages of the data file are mapped read-only and shared
+  ///   through the page cache with any other process mapping the same file.
+  /// Otherwise (e.g., attached data following a header of arbitrary length),
+  ///   the data is read into an aligned private buffer.
+  ///   This is one copy of the data and nothing is shared.
+  /// Files which cannot be mapped (compressed data, different scalar type,
+  ///   different endian, multiple data files, ...) are rejected,
+  ///   so that the caller can read them using nrrdLoad.
+  /// MapSlab() maps only a range of slices along the last nrrd axis.
+  template <typename DTYPE, typename ATYPE>
+  class NRRD_RAW_MAP {
+
+  protected:
+    DTYPE dimension;                 ///< Nrrd dimension.
+    std::vector<ATYPE> axis_size;    ///< Axis sizes of mapped data.
+    std::vector<ATYPE> file_axis_size; ///< Nrrd axis sizes in file.
+    std::vector<double> spacing;     ///< Nrrd spacings.  NaN if undefined.
+
+    void * map_ptr;                  ///< Start of mapped region.
+    size_t map_length;               ///< Length of mapped region.
+    const void * data_ptr;           ///< Start of data in mapped region.
+    bool flag_shared;                ///< True if pages are file pages.
+
+    void Init();
+
+    /// Read header fields needed to map raw data.
+    /// Return false if file is not a nrrd file with raw data
+    ///   or has header fields which are not supported.
+    bool ReadHeader
+    (const char * input_filename, std::string & data_filename,
+     long & data_offset, std::string & type, std::string & endian);
+
+  public:
+    NRRD_RAW_MAP() { Init(); };      ///< Constructor.
+    ~NRRD_RAW_MAP() { Unmap(); };    ///< Destructor.
+
+    /// Map data of nrrd file.
+    /// Return true if data has type STYPE and is mapped.
+    /// Return false if data cannot be mapped.
+    template <typename STYPE>
+    bool Map(const char * input_filename);
+
+    /// Map slices z0 to z1 along the last nrrd axis.
+    /// Slices past the last one in the file are not mapped.
+    /// Return true if data has type STYPE and is mapped.
+    /// Return false if data cannot be mapped or if z0 > z1
+    ///   or z0 is not a slice in the file.
+    template <typename STYPE>
+    bool MapSlab
+    (const char * input_filename, const ATYPE z0, const ATYPE z1);
+
+    void Unmap();                    ///< Unmap data.
+
+    // Get functions
+    bool IsMapped() const            ///< Return true if data is mapped.
+    { return(data_ptr != NULL); };
+    bool IsShared() const            ///< Return true if data is file pages.
+    { return(flag_shared); };
+    DTYPE Dimension() const          ///< Return nrrd dimension.
+    { return(dimension); };
+    const ATYPE * AxisSize() const   ///< Return mapped axis sizes.
+    { return(&(axis_size[0])); };
+    ATYPE AxisSize(const DTYPE d) const
+    { return(axis_size[d]); };       ///< Return # vertices on axis d.
+    const ATYPE * FileAxisSize() const ///< Return nrrd axis sizes in file.
+    { return(&(file_axis_size[0])); };
+    const void * DataPtrConst() const ///< Return pointer to mapped data.
+    { return(data_ptr); };
+
+    /// Get grid spacing.
+    template <typename STYPE>
+    void GetSpacing(std::vector<STYPE> & grid_spacing) const;
+
+    // copy constructor and assignment: NOT IMPLEMENTED
+    NRRD_RAW_MAP(const NRRD_RAW_MAP & raw_map);
+    const NRRD_RAW_MAP & operator = (const NRRD_RAW_MAP & right);
+  };
+
+  // **************************************************
+  // TEMPLATE CLASS SCALAR_GRID_NRRD_MAP
+  // **************************************************
+
+  /// Read-only scalar grid whose scalar values are mapped
+  ///   from a nrrd file with raw data.
+  /// Scalar values are copied only if they are misaligned in the file.
+  ///   (See NRRD_RAW_MAP.)
+  template <class SCALAR_GRID_BASE_CLASS>
+  class SCALAR_GRID_NRRD_MAP:public SCALAR_GRID_BASE_CLASS {
+
+  protected:
+    typedef typename SCALAR_GRID_BASE_CLASS::DIMENSION_TYPE DTYPE;
+    typedef typename SCALAR_GRID_BASE_CLASS::AXIS_SIZE_TYPE ATYPE;
+    typedef typename SCALAR_GRID_BASE_CLASS::SCALAR_TYPE STYPE;
+    typedef typename SCALAR_GRID_BASE_CLASS::NUMBER_TYPE NTYPE;
+
+    NRRD_RAW_MAP<DTYPE,ATYPE> raw_map;
+
+  public:
+    SCALAR_GRID_NRRD_MAP() {};
+    ~SCALAR_GRID_NRRD_MAP() { Unmap(); };
+
+    /// Map scalar grid from nrrd file.
+    /// Return false if file cannot be mapped.  Grid is then empty.
+    /// Throw error if grid has too many vertices for the grid index type.
+    bool Map(const char * input_filename);
+
+    /// Map z-slab of scalar grid from nrrd file.
+    /// Slab contains grid vertices whose last coordinate is from z0 to z1.
+    /// Return false if slab cannot be mapped.  Grid is then empty.
+    /// Throw error if full grid has too many vertices 
+    ///   for the grid index type.
+    bool MapSlab(const char * input_filename, const ATYPE z0, const ATYPE z1);
+
+    void Unmap();                    ///< Unmap scalar values.
+
+    /// Return true if scalar values are mapped.
+    bool IsMapped() const { return(raw_map.IsMapped()); };
+
+    /// Return axis sizes of full grid in nrrd file.
+    const ATYPE * FileAxisSize() const { return(raw_map.FileAxisSize()); };
+
+    /// Get grid spacing from nrrd header.
+    template <typename STYPE2>
+    void GetSpacing(std::vector<STYPE2> & grid_spacing) const
+    { raw_map.GetSpacing(grid_spacing); };
+  };
+
+  // **************************************************
+  // TEMPLATE CLASS VECTOR_GRID_NRRD_MAP
+  // **************************************************
+
+  /// Read-only vector grid whose vectors are mapped
+  ///   from a nrrd file with raw data.
+  /// Nrrd axis 0 is the vector coordinate.
+  /// Vectors are copied only if they are misaligned in the file.
+  ///   (See NRRD_RAW_MAP.)
+  template <class VECTOR_GRID_BASE_CLASS>
+  class VECTOR_GRID_NRRD_MAP:public VECTOR_GRID_BASE_CLASS {
+
+  protected:
+    typedef typename VECTOR_GRID_BASE_CLASS::DIMENSION_TYPE DTYPE;
+    typedef typename VECTOR_GRID_BASE_CLASS::AXIS_SIZE_TYPE ATYPE;
+    typedef typename VECTOR_GRID_BASE_CLASS::LENGTH_TYPE LTYPE;
+    typedef typename VECTOR_GRID_BASE_CLASS::VECTOR_COORD_TYPE VCTYPE;
+    typedef typename VECTOR_GRID_BASE_CLASS::NUMBER_TYPE NTYPE;
+
+    NRRD_RAW_MAP<DTYPE,ATYPE> raw_map;
+
+  public:
+    VECTOR_GRID_NRRD_MAP() {};
+    ~VECTOR_GRID_NRRD_MAP() { Unmap(); };
+
+    /// Map vector grid from nrrd file.
+    /// Return false if file cannot be mapped.  Grid is then empty.
+    /// Throw error if grid has too many vertices for the grid index type.
+    bool Map(const char * input_filename);
+
+    /// Map z-slab of vector grid from nrrd file.
+    /// Slab contains grid vertices whose last coordinate is from z0 to z1.
+    /// Return false if slab cannot be mapped.  Grid is then empty.
+    /// Throw error if full grid has too many vertices 
+    ///   for the grid index type.
+    bool MapSlab(const char * input_filename, const ATYPE z0, const ATYPE z1);
+
+    void Unmap();                    ///< Unmap vectors.
+
+    /// Return true if vectors are mapped.
+    bool IsMapped() const { return(raw_map.IsMapped()); };
+
+    /// Return axis sizes of full grid in nrrd file.
+    /// Note: Does not include the vector coordinate axis.
+    const ATYPE * FileAxisSize() const 
+    { return(raw_map.FileAxisSize()+1); };
+
+    /// Get grid spacing from nrrd header.
+    /// Note: grid_spacing[0] is the spacing of the vector coordinate axis.
+    template <typename STYPE2>
+    void GetSpacing(std::vector<STYPE2> & grid_spacing) const
+    { raw_map.GetSpacing(grid_spacing); };
+  };
+
   // **************************************************
   // FUNCTION add_nrrd_message
   // **************************************************
@@ -173,6 +375,32 @@ namespace IJK {
     add_nrrd_message("  Nrrd error: ", error);
   }
 
+  // **************************************************
+  // FUNCTION check_grid_index_range
+  // **************************************************
+
+  /// Return true if number of grid vertices times vector_length
+  ///   can be represented by NTYPE.
+  /// Product is computed in double so that it does not overflow.
+  template <typename NTYPE, typename DTYPE, typename ATYPE>
+  bool check_grid_index_range
+  (const DTYPE dimension, const ATYPE * axis_size,
+   const size_t vector_length, IJK::ERROR & error)
+  {
+    double num_values = vector_length;
+    for (DTYPE d = 0; d < dimension; d++)
+      { num_values *= double(axis_size[d]); }
+
+    if (num_values > double(std::numeric_limits<NTYPE>::max())) {
+      error.AddMessage("Grid is too large.  Number of grid values ",
+                       num_values, " exceeds maximum index ",
+                       std::numeric_limits<NTYPE>::max(), ".");
+      return(false);
+    }
+
+    return(true);
+  }
+
   // **************************************************
   // NRRD SET/COPY FUNCTIONS
   // **************************************************
@@ -889,6 +1117,19 @@ namespace IJK {
 
     size_t size[NRRD_DIM_MAX];
     nrrdAxisInfoGet_nva(this->data, nrrdAxisInfoSize, size);
+
+    IJK::PROCEDURE_ERROR error("GRID_NRRD_IN::ReadScalarGrid");
+    if (!check_grid_index_range<typename SCALAR_GRID::NUMBER_TYPE>
+        (dimension, size, 1, error))
+      { throw error; }
+
+    if (!nrrd_type_fits(this->data->type, grid.ScalarPtrConst())) {
+      error.AddMessage("Nrrd data type of ", input_filename, 
+                       " does not fit in ", 8*sizeof(*grid.ScalarPtrConst()),
+                       "-bit grid scalar values.");
+      throw error;
+    }
+
     grid.SetSize(dimension, size);
     nrrd2scalar(this->data, grid.ScalarPtr());
   }
@@ -935,6 +1176,10 @@ namespace IJK {
       return;
     }
 
+    if (!check_grid_index_range<typename VECTOR_GRID::NUMBER_TYPE>
+        (dimension, size+1, size[0], error))
+      { throw error; }
+
     grid.SetSize(dimension, size+1, size[0]);
     nrrd2scalar(this->data, grid.VectorPtr());
   }
@@ -953,6 +1198,411 @@ namespace IJK {
     header.CopyHeader(this->DataPtrConst());
   }
 
+
+  // **************************************************
+  // NRRD RAW DATA FUNCTIONS
+  // **************************************************
+
+  /// Return true if type_name is the nrrd type name of STYPE.
+  template <typename STYPE>
+  inline bool is_nrrd_type_name(const std::string & type_name)
+  { return(false); }
+
+  template <>
+  inline bool is_nrrd_type_name<float>(const std::string & type_name)
+  { return(type_name == "float"); }
+
+  template <>
+  inline bool is_nrrd_type_name<double>(const std::string & type_name)
+  { return(type_name == "double"); }
+
+  template <>
+  inline bool is_nrrd_type_name<unsigned char>(const std::string & type_name)
+  {
+    return(type_name == "uchar" || type_name == "unsigned char" ||
+           type_name == "uint8" || type_name == "uint8_t");
+  }
+
+  template <>
+  inline bool is_nrrd_type_name<unsigned short>
+  (const std::string & type_name)
+  {
+    return(type_name == "ushort" || type_name == "unsigned short" ||
+           type_name == "unsigned short int" || type_name == "uint16" ||
+           type_name == "uint16_t");
+  }
+
+  /// Return nrrd endian name ("little" or "big") of this machine.
+  inline const char * nrrd_host_endian()
+  {
+    const unsigned int one = 1;
+    if (*((const unsigned char *)(&one)) == 1) { return("little"); }
+    else { return("big"); }
+  }
+
+  // **************************************************
+  // CLASS NRRD_RAW_MAP MEMBER FUNCTIONS
+  // **************************************************
+
+  /// Initialize.
+  template <typename DTYPE, typename ATYPE>
+  void NRRD_RAW_MAP<DTYPE,ATYPE>::Init()
+  {
+    dimension = 0;
+    map_ptr = NULL;
+    map_length = 0;
+    data_ptr = NULL;
+    flag_shared = false;
+  }
+
+  /// Read header fields needed to map raw data.
+  template <typename DTYPE, typename ATYPE>
+  bool NRRD_RAW_MAP<DTYPE,ATYPE>::ReadHeader
+  (const char * input_filename, std::string & data_filename,
+   long & data_offset, std::string & type, std::string & endian)
+  {
+    std::ifstream in(input_filename, std::ios::in | std::ios::binary);
+    if (!in) { return(false); }
+
+    std::string line;
+    if (!std::getline(in, line) || line.compare(0, 4, "NRRD") != 0)
+      { return(false); }
+
+    std::string encoding;
+    std::string data_file;
+    long byte_skip = 0;
+    bool flag_attached = true;
+    bool flag_sizes = false;
+
+    dimension = 0;
+    axis_size.clear();
+    spacing.clear();
+
+    while (std::getline(in, line)) {
+
+      if (!line.empty() && line[line.size()-1] == '\r')
+        { line.erase(line.size()-1); }
+
+      // Empty line separates header from attached data.
+      if (line.empty()) { break; }
+
+      // Skip comments and key/value pairs.
+      if (line[0] == '#') { continue; }
+      if (line.find(":=") != std::string::npos) { continue; }
+
+      const size_t k = line.find(": ");
+      if (k == std::string::npos) { return(false); }
+
+      const std::string field = line.substr(0, k);
+      const std::string value = line.substr(k+2);
+      std::istringstream value_stream(value);
+
+      if (field == "type") { type = value; }
+      else if (field == "dimension") { value_stream >> dimension; }
+      else if (field == "sizes") {
+        ATYPE size;
+        while (value_stream >> size) { axis_size.push_back(size); }
+        flag_sizes = true;
+      }
+      else if (field == "spacings") {
+        // Use strtod, not operator >>, to accept "nan".
+        std::string s;
+        while (value_stream >> s)
+          { spacing.push_back(std::strtod(s.c_str(), NULL)); }
+      }
+      else if (field == "endian") { endian = value; }
+      else if (field == "encoding") { encoding = value; }
+      else if (field == "data file" || field == "datafile") {
+        // Lists or formatted sequences of data files are not supported.
+        if (value.find_first_of(" \t") != std::string::npos) 
+          { return(false); }
+        data_file = value;
+        flag_attached = false;
+      }
+      else if (field == "byte skip" || field == "byteskip")
+        { value_stream >> byte_skip; }
+      else if (field == "line skip" || field == "lineskip") {
+        long line_skip = 0;
+        value_stream >> line_skip;
+        if (line_skip != 0) { return(false); }
+      }
+    }
+
+    if (encoding != "raw" || !flag_sizes) { return(false); }
+    if (dimension < 1 || axis_size.size() != size_t(dimension))
+      { return(false); }
+    if (byte_skip < -1) { return(false); }
+
+    spacing.resize(dimension, std::numeric_limits<double>::quiet_NaN());
+
+    if (flag_attached) {
+      // Header must be followed by an empty line and the data.
+      if (!in) { return(false); }
+      data_filename = input_filename;
+      if (byte_skip == -1) { data_offset = -1; }
+      else { data_offset = long(in.tellg()) + byte_skip; }
+    }
+    else {
+      // Detached data file is relative to the header directory.
+      data_filename = data_file;
+      const std::string header_filename = input_filename;
+      const size_t islash = header_filename.rfind('/');
+      if (data_file[0] != '/' && islash != std::string::npos) 
+        { data_filename = header_filename.substr(0, islash+1) + data_file; }
+      data_offset = byte_skip;
+    }
+
+    return(!in.bad());
+  }
+
+  /// Map data of nrrd file.
+  template <typename DTYPE, typename ATYPE>
+  template <typename STYPE>
+  bool NRRD_RAW_MAP<DTYPE,ATYPE>::Map(const char * input_filename)
+  {
+    return(MapSlab<STYPE>
+           (input_filename, 0, std::numeric_limits<ATYPE>::max()));
+  }
+
+  /// Map slices z0 to z1 along the last nrrd axis.
+  template <typename DTYPE, typename ATYPE>
+  template <typename STYPE>
+  bool NRRD_RAW_MAP<DTYPE,ATYPE>::MapSlab
+  (const char * input_filename, const ATYPE z0, const ATYPE z1)
+  {
+    Unmap();
+
+#if defined(__unix__) || defined(__APPLE__)
+
+    if (input_filename == NULL) { return(false); }
+
+    std::string data_filename, type, endian;
+    long data_offset;
+    if (!ReadHeader(input_filename, data_filename, data_offset, type, endian))
+      { return(false); }
+
+    if (!is_nrrd_type_name<STYPE>(type)) { return(false); }
+    if (sizeof(STYPE) > 1 && endian != nrrd_host_endian()) 
+      { return(false); }
+
+    size_t num_values_in_slice = 1;
+    for (DTYPE d = 0; d < dimension; d++) {
+      if (axis_size[d] < 1) { return(false); }
+      if (d+1 < dimension) 
+        { num_values_in_slice *= size_t(axis_size[d]); }
+    }
+
+    const ATYPE num_slices = axis_size[dimension-1];
+    if (z0 < 0 || z0 > z1 || z0 >= num_slices) { return(false); }
+    const ATYPE slab_size = std::min(z1, ATYPE(num_slices-1)) - z0 + 1;
+
+    file_axis_size = axis_size;
+    axis_size[dimension-1] = slab_size;
+
+    const size_t slice_bytes = num_values_in_slice*sizeof(STYPE);
+    const size_t file_num_bytes = size_t(num_slices)*slice_bytes;
+    const size_t num_bytes = size_t(slab_size)*slice_bytes;
+
+    const int fd = open(data_filename.c_str(), O_RDONLY);
+    if (fd < 0) { return(false); }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) { close(fd); return(false); }
+    const size_t file_size = file_stat.st_size;
+
+    // Byte skip -1 means data is at the end of the file.
+    if (data_offset < 0) {
+      if (file_size < file_num_bytes) { close(fd); return(false); }
+      data_offset = file_size - file_num_bytes;
+    }
+
+    if (size_t(data_offset) + file_num_bytes > file_size) 
+      { close(fd); return(false); }
+
+    // Skip slices before z0.
+    data_offset += long(z0)*long(slice_bytes);
+
+    if (data_offset % sizeof(STYPE) != 0) {
+      // Attached data usually starts at an arbitrary byte offset.
+      // Mapped data would not be aligned, so read it into
+      //   an anonymous mapping instead.
+      map_length = num_bytes;
+      map_ptr = mmap(NULL, map_length, PROT_READ | PROT_WRITE, 
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (map_ptr == MAP_FAILED) { 
+        close(fd);
+        Init();
+        return(false); 
+      }
+
+      size_t num_read = 0;
+      while (num_read < num_bytes) {
+        const ssize_t n = pread(fd, (char *)(map_ptr) + num_read,
+                                num_bytes - num_read, data_offset + num_read);
+        if (n <= 0) { break; }
+        num_read += n;
+      }
+      close(fd);
+
+      if (num_read < num_bytes) {
+        Unmap();
+        return(false);
+      }
+
+      mprotect(map_ptr, map_length, PROT_READ);
+      data_ptr = map_ptr;
+      flag_shared = false;
+
+      return(true);
+    }
+
+    // mmap offset must be a multiple of the page size.
+    // Map read-only, so that the mapping is not counted against
+    //   the system commit limit.
+    const long page_size = sysconf(_SC_PAGESIZE);
+    const long map_offset = (data_offset/page_size)*page_size;
+    const size_t data_shift = data_offset - map_offset;
+    map_length = data_shift + num_bytes;
+    map_ptr = mmap(NULL, map_length, PROT_READ, MAP_PRIVATE, fd, map_offset);
+    close(fd);
+
+    if (map_ptr == MAP_FAILED) { 
+      Init();
+      return(false); 
+    }
+
+    data_ptr = (char *)(map_ptr) + data_shift;
+    flag_shared = true;
+
+    return(true);
+
+#else
+
+    return(false);
+
+#endif
+  }
+
+  /// Unmap data.
+  template <typename DTYPE, typename ATYPE>
+  void NRRD_RAW_MAP<DTYPE,ATYPE>::Unmap()
+  {
+#if defined(__unix__) || defined(__APPLE__)
+    if (map_ptr != NULL) { munmap(map_ptr, map_length); }
+#endif
+
+    Init();
+  }
+
+  /// Get grid spacing.
+  template <typename DTYPE, typename ATYPE>
+  template <typename STYPE>
+  void NRRD_RAW_MAP<DTYPE,ATYPE>::
+  GetSpacing(std::vector<STYPE> & grid_spacing) const
+  {
+    grid_spacing.resize(spacing.size());
+    for (size_t d = 0; d < spacing.size(); d++)
+      { grid_spacing[d] = spacing[d]; }
+  }
+
+  // **************************************************
+  // CLASS SCALAR_GRID_NRRD_MAP MEMBER FUNCTIONS
+  // **************************************************
+
+  /// Map scalar grid from nrrd file.
+  template <class SCALAR_GRID_BASE_CLASS>
+  bool SCALAR_GRID_NRRD_MAP<SCALAR_GRID_BASE_CLASS>::
+  Map(const char * input_filename)
+  {
+    return(MapSlab(input_filename, 0, std::numeric_limits<ATYPE>::max()));
+  }
+
+  /// Map z-slab of scalar grid from nrrd file.
+  template <class SCALAR_GRID_BASE_CLASS>
+  bool SCALAR_GRID_NRRD_MAP<SCALAR_GRID_BASE_CLASS>::
+  MapSlab(const char * input_filename, const ATYPE z0, const ATYPE z1)
+  {
+    Unmap();
+
+    if (!raw_map.template MapSlab<STYPE>(input_filename, z0, z1)) 
+      { return(false); }
+
+    // Reading the grid would fail, so do not return false.
+    IJK::PROCEDURE_ERROR error("SCALAR_GRID_NRRD_MAP::MapSlab");
+    if (!check_grid_index_range<NTYPE>
+        (raw_map.Dimension(), raw_map.FileAxisSize(), 1, error)) {
+      Unmap();
+      throw error;
+    }
+
+    SCALAR_GRID_BASE_CLASS::SetSize
+      (raw_map.Dimension(), raw_map.AxisSize());
+    this->scalar = (STYPE *)(raw_map.DataPtrConst());
+
+    return(true);
+  }
+
+  /// Unmap scalar values.
+  template <class SCALAR_GRID_BASE_CLASS>
+  void SCALAR_GRID_NRRD_MAP<SCALAR_GRID_BASE_CLASS>::Unmap()
+  {
+    this->scalar = NULL;
+    raw_map.Unmap();
+    SCALAR_GRID_BASE_CLASS::SetSize(0, (ATYPE *)(NULL));
+  }
+
+  // **************************************************
+  // CLASS VECTOR_GRID_NRRD_MAP MEMBER FUNCTIONS
+  // **************************************************
+
+  /// Map vector grid from nrrd file.
+  template <class VECTOR_GRID_BASE_CLASS>
+  bool VECTOR_GRID_NRRD_MAP<VECTOR_GRID_BASE_CLASS>::
+  Map(const char * input_filename)
+  {
+    return(MapSlab(input_filename, 0, std::numeric_limits<ATYPE>::max()));
+  }
+
+  /// Map z-slab of vector grid from nrrd file.
+  template <class VECTOR_GRID_BASE_CLASS>
+  bool VECTOR_GRID_NRRD_MAP<VECTOR_GRID_BASE_CLASS>::
+  MapSlab(const char * input_filename, const ATYPE z0, const ATYPE z1)
+  {
+    Unmap();
+
+    if (!raw_map.template MapSlab<VCTYPE>(input_filename, z0, z1)) 
+      { return(false); }
+
+    if (raw_map.Dimension() < 2) {
+      Unmap();
+      return(false);
+    }
+
+    // Reading the grid would fail, so do not return false.
+    IJK::PROCEDURE_ERROR error("VECTOR_GRID_NRRD_MAP::MapSlab");
+    if (!check_grid_index_range<NTYPE>
+        (raw_map.Dimension()-1, raw_map.FileAxisSize()+1, 
+         raw_map.AxisSize(0), error)) {
+      Unmap();
+      throw error;
+    }
+
+    VECTOR_GRID_BASE_CLASS::SetSize
+      (raw_map.Dimension()-1, raw_map.AxisSize()+1, raw_map.AxisSize(0));
+    this->vec = (VCTYPE *)(raw_map.DataPtrConst());
+
+    return(true);
+  }
+
+  /// Unmap vectors.
+  template <class VECTOR_GRID_BASE_CLASS>
+  void VECTOR_GRID_NRRD_MAP<VECTOR_GRID_BASE_CLASS>::Unmap()
+  {
+    this->vec = NULL;
+    raw_map.Unmap();
+    VECTOR_GRID_BASE_CLASS::SetSize(0, (ATYPE *)(NULL), 0);
+  }
+
 }
 
 #endif
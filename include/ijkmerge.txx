@@ -24,6 +24,8 @@
 #define _IJKMERGE_
 
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 #include "ijk.txx"
 
@@ -53,6 +55,12 @@ namespace IJK {
     void Init(const INTEGER_TYPE max_num_int) { Init(0, max_num_int); };
     void FreeListLoc();
 
+    /// Set range of integers without allocating list_loc[] and in_list[].
+    /// Memory is allocated by Allocate().
+    void SetRange(const INTEGER_TYPE min_int, const INTEGER_TYPE max_num_int);
+    void SetRange(const INTEGER_TYPE max_num_int) 
+    { SetRange(0, max_num_int); };
+
     INTEGER_LIST() { Init(0, 0);}; // for derived classes
 
   public:
@@ -77,7 +85,14 @@ namespace IJK {
     INTEGER_TYPE List(const int i) const 
     { return(list[i]); };
 
+    /// Return true if memory of size max_num_int is allocated.
+    bool IsAllocated() const { return(in_list != NULL); };
+
     // set functions
+
+    /// Allocate and initialize memory of size max_num_int,
+    ///   if not already allocated.
+    void Allocate();
     LOC_TYPE Insert(const INTEGER_TYPE i)
     {
       INTEGER_TYPE j = Index(i);
@@ -116,7 +131,18 @@ namespace IJK {
   void INTEGER_LIST<INTEGER_TYPE,LOC_TYPE>::
   Init(const INTEGER_TYPE min_int, const INTEGER_TYPE max_num_int)
   {
-    IJK::PROCEDURE_ERROR error("INTEGER_LIST::Init");
+    SetRange(min_int, max_num_int);
+    Allocate();
+  }
+
+  /// Set range of integers in list.  Do not allocate memory.
+  /// @param min_int = Minimum value of any integer in list. Precondition: min_int is non-negative.
+  /// @param max_num_int Maximum number of integers that can be inserted.  Precondition: max_num_int is non-negative.
+  template < class INTEGER_TYPE, class LOC_TYPE> 
+  void INTEGER_LIST<INTEGER_TYPE,LOC_TYPE>::
+  SetRange(const INTEGER_TYPE min_int, const INTEGER_TYPE max_num_int)
+  {
+    IJK::PROCEDURE_ERROR error("INTEGER_LIST::SetRange");
     if (min_int < 0) { 
       error.AddMessage("Programming error. Parameter min_int must be non-negative.");
       throw error;
@@ -131,6 +157,13 @@ namespace IJK {
     this->max_num_int = max_num_int;
     list_loc = NULL;
     in_list = NULL;
+  }
+
+  /// Allocate list_loc[] and in_list[] if not already allocated.
+  template < class INTEGER_TYPE, class LOC_TYPE> 
+  void INTEGER_LIST<INTEGER_TYPE,LOC_TYPE>::Allocate()
+  {
+    if (IsAllocated()) { return; }
 
     if (max_num_int > 0) { 
       list_loc = new LOC_TYPE[max_num_int]; 
@@ -138,7 +171,6 @@ namespace IJK {
       for (INTEGER_TYPE i = 0; i < max_num_int; i++) 
         { in_list[i] = false; };
     };
-
   }
 
   /// Free list loc.
@@ -236,7 +268,56 @@ namespace IJK {
   // TEMPLATE merge_identical
   // **************************************************
 
+  /// Merge identical values in an integer list using sorting.
+  /// Output is identical to merge_identical using INTEGER_LIST.
+  ///   (list1_nodup is in order of first occurrence in list0.)
+  /// Requires memory proportional to list0_length, not to the range
+  ///   of values in list0.
+  /// @param list0 List of integers.
+  /// @param list0_length Length of list0.
+  /// @param[out] list1_nodup List without any duplicate values.
+  /// @param[out] list0_map Mapping from list0 to locations in list1_nodup.
+  /// @pre Array list0_map is preallocated to length at least list0_length.
+  template <typename ITYPE, typename NTYPE, typename MTYPE>
+  void merge_identical_using_sort
+  (const ITYPE * list0, const NTYPE list0_length,
+   std::vector<ITYPE> & list1_nodup, MTYPE * list0_map)
+  {
+    typedef std::pair<ITYPE,NTYPE> VALUE_LOC;
+
+    list1_nodup.clear();
+    if (list0_length < 1) { return; }
+
+    // Pairs are distinct, so identical values are sorted
+    //   by increasing location in list0.
+    std::vector<VALUE_LOC> sorted(list0_length);
+    for (NTYPE i = 0; i < list0_length; i++)
+      { sorted[i] = VALUE_LOC(list0[i], i); }
+    std::sort(sorted.begin(), sorted.end());
+
+    // first[k] = (location of first occurrence in list0, 
+    //             location in sorted) of k'th distinct value.
+    std::vector< std::pair<NTYPE,NTYPE> > first;
+    for (NTYPE j = 0; j < list0_length; j++) {
+      if (j == 0 || sorted[j].first != sorted[j-1].first)
+        { first.push_back(std::make_pair(sorted[j].second, j)); }
+    }
+    std::sort(first.begin(), first.end());
+
+    list1_nodup.resize(first.size());
+    for (NTYPE k = 0; k < NTYPE(first.size()); k++) {
+      const ITYPE x = sorted[first[k].second].first;
+      list1_nodup[k] = x;
+      for (NTYPE j = first[k].second;
+           j < list0_length && sorted[j].first == x; j++)
+        { list0_map[sorted[j].second] = k; }
+    }
+  }
+
   /// Merge identical values in an integer list
+  /// If memory for int_list is not allocated and list0_length is
+  ///   small compared to int_list.MaxNumInt(), use merge_identical_using_sort.
+  ///   Otherwise, allocate int_list and use int_list.
   /// @param list0 List of integers.
   /// @param list0_length Length of list0.
   /// @param[out] list1_nodup List without any duplicate values.
@@ -253,6 +334,20 @@ namespace IJK {
    std::vector<ITYPE> & list1_nodup,
    MTYPE * list0_map, INTEGER_LIST_TYPE & int_list)
   {
+    // Use sorting if list0 has fewer than one value per
+    //   MERGE_IDENTICAL_SPARSE_RATIO integers in int_list.
+    const int MERGE_IDENTICAL_SPARSE_RATIO = 8;
+
+    if (!int_list.IsAllocated()) {
+      if (list0_length <
+          NTYPE(int_list.MaxNumInt()/MERGE_IDENTICAL_SPARSE_RATIO)) {
+        merge_identical_using_sort(list0, list0_length, list1_nodup, list0_map);
+        return;
+      }
+
+      int_list.Allocate();
+    }
+
     // initialize data structures
     int_list.ClearList();
     list1_nodup.clear();
@@ -279,7 +374,7 @@ namespace IJK {
   ///      for all elements list0[i] of list0.
   template <typename ITYPE, typename MTYPE, typename INTEGER_LIST_TYPE>
   void merge_identical
-  (const std::vector<ITYPE> list0, std::vector<ITYPE> & list1_nodup,
+  (const std::vector<ITYPE> & list0, std::vector<ITYPE> & list1_nodup,
    std::vector<MTYPE> & list0_map, INTEGER_LIST_TYPE & int_list)
   {
     list0_map.resize(list0.size());
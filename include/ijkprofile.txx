@@ -0,0 +1,284 @@
+/// \file ijkprofile.txx
+/// Wall clock profiling of program stages.
+/// Requires C++11.  Without C++11, IJK_PROFILE_SCOPE does nothing.
+/// Version 0.1.0
+
+/*
+  IJK: Isosurface Jeneration Kode
+  Copyright (C) 2013 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#ifndef _IJKPROFILE_
+#define _IJKPROFILE_
+
+#if __cplusplus < 201103L && !defined(_MSC_VER)
+
+#define IJK_PROFILE_SCOPE(timer_name,stage_name)
+#define IJK_PROFILE_SCOPE_N(timer_name,stage_name,num_calls)
+
+#else
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace IJK {
+
+  // **************************************************
+  // PEAK RESIDENT SET SIZE
+  // **************************************************
+
+  /// Return peak resident set size of the process in kilobytes.
+  /// Return 0 if not available on this platform.
+  inline long get_peak_rss_kb()
+  {
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) { return(0); }
+#if defined(__APPLE__)
+    // ru_maxrss is in bytes on Mac OS X.
+    return(long(usage.ru_maxrss/1024));
+#else
+    return(long(usage.ru_maxrss));
+#endif
+#else
+    return(0);
+#endif
+  }
+
+
+  // **************************************************
+  // CLASS PROFILE_STAGE
+  // **************************************************
+
+  /// Wall clock time and number of calls of one program stage.
+  /// Also records the peak resident set size of the whole process,
+  ///   as seen at the end of the stage calls.
+  ///   This is not memory used by the stage.  It is the largest
+  ///   process peak RSS sampled when a call to the stage ended,
+  ///   including memory allocated by earlier stages and other threads.
+  /// Counters are atomic so one stage may be timed by several threads.
+  /// Times of concurrent calls are added.
+  class PROFILE_STAGE {
+
+  protected:
+    std::string name;
+    std::atomic<long long> nanoseconds;
+    std::atomic<long long> num_calls;
+    std::atomic<long long> num_timed;
+    std::atomic<long> process_peak_rss_kb;
+
+    void UpdateProcessPeakRSS()
+    {
+      const long rss = get_peak_rss_kb();
+      long old_rss = process_peak_rss_kb.load();
+      while (rss > old_rss &&
+             !process_peak_rss_kb.compare_exchange_weak(old_rss, rss)) {}
+    }
+
+  public:
+    /// Process peak RSS is sampled once every RSS_SAMPLE_PERIOD
+    ///   timed intervals since getrusage() is a system call.
+    static const long long RSS_SAMPLE_PERIOD = 1024;
+
+    PROFILE_STAGE(const char * stage_name):name(stage_name)
+    { Clear(); }
+
+    /// Add ncalls calls taking a total of ns nanoseconds.
+    /// Use ncalls > 1 when one timed interval processes several items,
+    ///   e.g., a batch of cubes.
+    void Add(const long long ns, const long long ncalls = 1)
+    {
+      nanoseconds += ns;
+      num_calls += ncalls;
+      const long long k = num_timed++;
+      if (k % RSS_SAMPLE_PERIOD == 0) { UpdateProcessPeakRSS(); }
+    }
+
+    /// Clear all counters.
+    void Clear()
+    {
+      nanoseconds = 0;
+      num_calls = 0;
+      num_timed = 0;
+      process_peak_rss_kb = 0;
+    }
+
+    // Get functions.
+    const std::string & Name() const { return(name); }
+    long long NumCalls() const { return(num_calls.load()); }
+    long ProcessPeakRSS() const { return(process_peak_rss_kb.load()); }
+    double Seconds() const { return(nanoseconds.load()*1.0e-9); }
+  };
+
+
+  // **************************************************
+  // CLASS PROFILER
+  // **************************************************
+
+  /// List of profiled stages.
+  /// Stages are timed only when the profiler is enabled.
+  class PROFILER {
+
+  protected:
+    std::atomic<bool> flag_enabled;
+    std::mutex stage_mutex;
+
+    /// Deque so references to stages remain valid.
+    std::deque<PROFILE_STAGE> stage_list;
+
+  public:
+    PROFILER() { flag_enabled = false; }
+
+    /// Enable or disable profiling.
+    void Enable(const bool flag) { flag_enabled = flag; }
+
+    /// Return true if profiling is enabled.
+    bool IsEnabled() const
+    { return(flag_enabled.load(std::memory_order_relaxed)); }
+
+    /// Return stage with given name.  Create stage if necessary.
+    /// Store the returned reference to avoid a search on each call.
+    PROFILE_STAGE & Stage(const char * stage_name)
+    {
+      std::lock_guard<std::mutex> lock(stage_mutex);
+      for (std::deque<PROFILE_STAGE>::iterator stage_iter =
+             stage_list.begin(); stage_iter != stage_list.end(); stage_iter++)
+        {
+          if (stage_iter->Name() == stage_name) { return(*stage_iter); }
+        }
+      stage_list.emplace_back(stage_name);
+      return(stage_list.back());
+    }
+
+    /// Clear counters of all stages.
+    void Clear()
+    {
+      std::lock_guard<std::mutex> lock(stage_mutex);
+      for (std::deque<PROFILE_STAGE>::iterator stage_iter =
+             stage_list.begin(); stage_iter != stage_list.end(); stage_iter++)
+        { stage_iter->Clear(); }
+    }
+
+    /// Write stages with at least one call in a human readable table.
+    void Write(std::ostream & out, const std::string & prefix)
+    {
+      std::lock_guard<std::mutex> lock(stage_mutex);
+      for (std::deque<PROFILE_STAGE>::const_iterator stage_iter =
+             stage_list.begin(); stage_iter != stage_list.end(); stage_iter++)
+        {
+          if (stage_iter->NumCalls() == 0) { continue; }
+          out << prefix << stage_iter->Name() << ": "
+              << stage_iter->Seconds() << " seconds, "
+              << stage_iter->NumCalls() << " calls, process peak RSS "
+              << stage_iter->ProcessPeakRSS() << " KB." << std::endl;
+        }
+    }
+
+    /// Write all stages in JSON format.
+    void WriteJSON(std::ostream & out)
+    {
+      std::lock_guard<std::mutex> lock(stage_mutex);
+      out << "{" << std::endl;
+      out << "  \"peak_rss_kb\": " << get_peak_rss_kb() << "," << std::endl;
+      out << "  \"stages\": [";
+      for (std::deque<PROFILE_STAGE>::const_iterator stage_iter =
+             stage_list.begin(); stage_iter != stage_list.end(); stage_iter++)
+        {
+          if (stage_iter != stage_list.begin()) { out << ","; }
+          out << std::endl;
+          out << "    { \"name\": \"" << stage_iter->Name() << "\""
+              << ", \"seconds\": " << stage_iter->Seconds()
+              << ", \"calls\": " << stage_iter->NumCalls()
+              << ", \"process_peak_rss_kb\": " 
+              << stage_iter->ProcessPeakRSS() << " }";
+        }
+      out << std::endl << "  ]" << std::endl;
+      out << "}" << std::endl;
+    }
+  };
+
+  /// Return the program profiler.
+  inline PROFILER & profiler()
+  {
+    static PROFILER program_profiler;
+    return(program_profiler);
+  }
+
+
+  // **************************************************
+  // CLASS SCOPED_TIMER
+  // **************************************************
+
+  /// Add wall clock time from construction to destruction to a stage.
+  /// Count ncalls calls to the stage.
+  /// Does nothing if the profiler is disabled at construction.
+  class SCOPED_TIMER {
+
+  protected:
+    typedef std::chrono::steady_clock CLOCK;
+
+    PROFILE_STAGE & stage;
+    long long num_calls;
+    bool flag_timing;
+    CLOCK::time_point start_time;
+
+  public:
+    SCOPED_TIMER(PROFILE_STAGE & profile_stage, const long long ncalls = 1):
+      stage(profile_stage), num_calls(ncalls)
+    {
+      flag_timing = profiler().IsEnabled();
+      if (flag_timing) { start_time = CLOCK::now(); }
+    }
+
+    ~SCOPED_TIMER()
+    {
+      if (flag_timing) {
+        const CLOCK::duration t = CLOCK::now() - start_time;
+        stage.Add(std::chrono::duration_cast<std::chrono::nanoseconds>
+                  (t).count(), num_calls);
+      }
+    }
+  };
+
+}
+
+/// Time the rest of the enclosing scope as profile stage stage_name.
+/// Stage lookup happens once, at the first call.
+#define IJK_PROFILE_SCOPE(timer_name,stage_name)                   \
+  static IJK::PROFILE_STAGE & timer_name ## _stage =               \
+    IJK::profiler().Stage(stage_name);                             \
+  IJK::SCOPED_TIMER timer_name(timer_name ## _stage)
+
+/// Time the rest of the enclosing scope as profile stage stage_name.
+/// Count num_calls calls, e.g., one call per cube of a batch.
+#define IJK_PROFILE_SCOPE_N(timer_name,stage_name,num_calls)       \
+  static IJK::PROFILE_STAGE & timer_name ## _stage =               \
+    IJK::profiler().Stage(stage_name);                             \
+  IJK::SCOPED_TIMER timer_name(timer_name ## _stage, num_calls)
+
+#endif
+
+#endif
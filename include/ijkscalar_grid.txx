@@ -174,6 +174,11 @@ namespace IJK {
     template <typename GTYPE>
     void Copy(const GTYPE & scalar_grid);
 
+    /// Move scalar values of scalar_grid2 to current grid
+    ///   without copying them.
+    /// scalar_grid2 is left empty.  Grid spacing is not moved.
+    void Move(SCALAR_GRID_ALLOC & scalar_grid2);
+
     SCALAR_GRID_ALLOC(const SCALAR_GRID_BASE_CLASS & scalar_grid2) 
     { Copy(scalar_grid2); }
 
@@ -1271,6 +1276,20 @@ namespace IJK {
     this->CopyScalar(scalar_grid2);
   }
 
+  /// Move scalar values of scalar_grid2 to current grid.
+  template <typename BASE_CLASS>
+  void SCALAR_GRID_ALLOC<BASE_CLASS>::Move(SCALAR_GRID_ALLOC & scalar_grid2)
+  {
+    if (&scalar_grid2 == this) { return; }
+
+    delete [] this->scalar;
+    this->scalar = NULL;
+    BASE_CLASS::SetSize(scalar_grid2.Dimension(), scalar_grid2.AxisSize());
+    this->scalar = scalar_grid2.scalar;
+    scalar_grid2.scalar = NULL;
+    scalar_grid2.FreeAll();
+  }
+
   template <typename BASE_CLASS>
   const SCALAR_GRID_ALLOC<BASE_CLASS> &
   SCALAR_GRID_ALLOC<BASE_CLASS>::operator =
@@ -1399,7 +1418,7 @@ namespace IJK {
     subgrid_axis_size[0] = 1;
 
     subsample_subgrid_vertices
-      (*this, 0, subgrid_axis_size.PtrConst(), period, vlist1.Ptr());
+      (*this, VTYPE(0), subgrid_axis_size.PtrConst(), period, vlist1.Ptr());
 
     for (VTYPE x0 = 0; x0 < scalar_grid2.AxisSize(0); x0++) {
       VTYPE x1 = x0*supersample_period;
@@ -1440,7 +1459,7 @@ namespace IJK {
 
       IJK::ARRAY<VTYPE> vlist(numv);
       subsample_subgrid_vertices
-        (*this, 0, subgrid_axis_size.PtrConst(),
+        (*this, VTYPE(0), subgrid_axis_size.PtrConst(),
          subsample_period.PtrConst(), vlist.Ptr());
 
       for (VTYPE x = 0; x+1 < this->AxisSize(d); x += supersample_period) {
@@ -1621,12 +1640,12 @@ namespace IJK {
         (this->dimension, this->axis_size, elength.PtrConst(), vlist.Ptr());
 
       ATYPE num_subsample_vertices_along_axis =
-        compute_subsample_size(AxisSize(d), region_edge_length);
+        compute_subsample_size(this->AxisSize(d), region_edge_length);
 
       for (ATYPE j = 0; j < num_subsample_vertices_along_axis; j++) {
         ATYPE num_edges = region_edge_length;
-        if ((j+1)*region_edge_length +1 > AxisSize(d)) {
-          num_edges = AxisSize(d) - j*region_edge_length - 1;
+        if ((j+1)*region_edge_length +1 > this->AxisSize(d)) {
+          num_edges = this->AxisSize(d) - j*region_edge_length - 1;
         }
 
         VTYPE facet_increment = (j*region_edge_length)*axis_increment[d];
@@ -1692,13 +1711,13 @@ namespace IJK {
         (this->dimension, this->axis_size, elength.PtrConst(), vlist.Ptr());
 
       ATYPE num_subsample_vertices_along_axis =
-        compute_subsample_size(AxisSize(d), region_edge_length);
+        compute_subsample_size(this->AxisSize(d), region_edge_length);
 
       for (ATYPE j = 0; j < num_subsample_vertices_along_axis; j++) {
         ATYPE istart = 0;
         if (j > 0) { istart = j*region_edge_length - offset_edge_length; };
         ATYPE iend = (j+1)*region_edge_length+offset_edge_length+1;
-        if (iend > AxisSize(d)) { iend = AxisSize(d); };
+        if (iend > this->AxisSize(d)) { iend = this->AxisSize(d); };
         ATYPE ionto = j*region_edge_length;
 
         for (VTYPE k = 0; k < subsample_size; k++) {
@@ -1863,7 +1882,7 @@ namespace IJK {
         compute_num_regions_along_axis(axis_size[d], region_edge_length);
     }
 
-    SetSize(dimension, num_regions_along_axis.PtrConst());
+    this->SetSize(dimension, num_regions_along_axis.PtrConst());
 
     compute_region_minmax
       (dimension, axis_size, scalar, region_edge_length,
@@ -1886,7 +1905,7 @@ namespace IJK {
         compute_num_regions_along_axis(axis_size[d], region_edge_length);
     }
 
-    SetSize(dimension, num_regions_along_axis.PtrConst());
+    this->SetSize(dimension, num_regions_along_axis.PtrConst());
 
     compute_region_minmax
       (dimension, axis_size, scalar, region_edge_length, offset_edge_length,
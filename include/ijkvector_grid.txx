@@ -178,6 +178,10 @@ namespace IJK {
     /// Copy vector grid
     template <typename GTYPE>
     void Copy(const GTYPE & vector_grid);
+    /// Move vectors of vector_grid2 to current grid without copying them.
+    /// vector_grid2 is left empty.  Grid spacing is not moved.
+    void Move(VECTOR_GRID_ALLOC & vector_grid2);
+
     VECTOR_GRID_ALLOC                                   ///< Copy VECTOR_GRID
     (const VECTOR_GRID_BASE_CLASS & vector_grid2)
     { Copy(vector_grid2); }
@@ -468,6 +472,21 @@ namespace IJK {
     this->CopyVector(vector_grid2);
   }
 
+  /// Move vectors of vector_grid2 to current grid.
+  template <typename BASE_CLASS>
+  void VECTOR_GRID_ALLOC<BASE_CLASS>::Move(VECTOR_GRID_ALLOC & vector_grid2)
+  {
+    if (&vector_grid2 == this) { return; }
+
+    delete [] this->vec;
+    this->vec = NULL;
+    BASE_CLASS::SetSize(vector_grid2.Dimension(), vector_grid2.AxisSize(),
+                        vector_grid2.VectorLength());
+    this->vec = vector_grid2.vec;
+    vector_grid2.vec = NULL;
+    vector_grid2.FreeAll();
+  }
+
   template <typename BASE_CLASS>
   const VECTOR_GRID_ALLOC<BASE_CLASS> &
   VECTOR_GRID_ALLOC<BASE_CLASS>::operator =
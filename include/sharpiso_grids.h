@@ -55,11 +55,11 @@ namespace SHARPISO {
   typedef IJK::GRID_SPACING<COORD_TYPE, GRID_NEIGHBORS>
     SHARPISO_GRID_NEIGHBORS;        ///< Grid with neighbor and spacing info.
 
-  typedef IJK::SCALAR_GRID_BASE<SHARPISO_GRID, SCALAR_TYPE>
+  typedef IJK::SCALAR_GRID_BASE<SHARPISO_GRID, GRID_SCALAR_TYPE>
     SHARPISO_SCALAR_GRID_BASE;              ///< sharpiso base scalar grid.
-  typedef IJK::SCALAR_GRID_WRAPPER<SHARPISO_GRID, SCALAR_TYPE>
+  typedef IJK::SCALAR_GRID_WRAPPER<SHARPISO_GRID, GRID_SCALAR_TYPE>
     SHARPISO_SCALAR_GRID_WRAPPER;   ///< sharpiso scalar grid wrapper.
-  typedef IJK::SCALAR_GRID<SHARPISO_GRID, SCALAR_TYPE>
+  typedef IJK::SCALAR_GRID<SHARPISO_GRID, GRID_SCALAR_TYPE>
     SHARPISO_SCALAR_GRID;           ///< sharpiso scalar grid.
   typedef IJK::VECTOR_GRID_BASE
     <SHARPISO_GRID, GRADIENT_LENGTH_TYPE, GRADIENT_COORD_TYPE>
@@ -81,6 +81,9 @@ namespace SHARPISO {
   typedef IJK::BOOL_GRID<SHARPISO_GRID> 
     SHARPISO_BOOL_GRID;             ///< Boolean grid.
 
+  typedef IJK::MINMAX_REGIONS<SHARPISO_GRID, GRID_SCALAR_TYPE>
+    SHARPISO_MINMAX_REGIONS;        ///< Min and max scalar of grid regions.
+
 
   // **************************************************
   // BIN_GRID
@@ -24,6 +24,7 @@
 #ifndef _SHARPISO_TYPES_
 #define _SHARPISO_TYPES_
 
+#include <cstdint>
 #include <utility>
 
 /// Definitions for sharp isosurface processing.
@@ -34,6 +35,20 @@ namespace SHARPISO {
   // **************************************************
 
   typedef float SCALAR_TYPE;
+
+  /// Type of scalar values stored in scalar grids.
+  /// Grid scalar values are widened to SCALAR_TYPE in computations.
+  /// Define SHARPISO_GRID_SCALAR_UINT8 or SHARPISO_GRID_SCALAR_UINT16
+  ///   to store 8-bit or 16-bit volumes without widening them to float.
+  ///   (mergesharp_uint8 and mergesharp_uint16 are built this way.)
+#if defined(SHARPISO_GRID_SCALAR_UINT8)
+  typedef unsigned char GRID_SCALAR_TYPE;
+#elif defined(SHARPISO_GRID_SCALAR_UINT16)
+  typedef unsigned short GRID_SCALAR_TYPE;
+#else
+  typedef float GRID_SCALAR_TYPE;
+#endif
+
   typedef float COORD_TYPE;
   typedef float GRADIENT_COORD_TYPE;
   typedef int GRID_COORD_TYPE;
@@ -47,11 +62,22 @@ namespace SHARPISO {
   /// (Note: COORD_TYPE may be signed or unsigned.)
   typedef float SIGNED_COORD_TYPE;
 
+  /// Vertex, cube and count types.
+  /// 32-bit by default.  Define SHARPISO_INDEX64 to use 64-bit indices
+  ///   for grids with 2^31 or more vertices, edges or isosurface vertices.
+#ifdef SHARPISO_INDEX64
+  typedef std::int64_t NUM_TYPE;
+  typedef std::int64_t VERTEX_INDEX;
+
+  /// Index difference type.  Must be signed.
+  typedef std::int64_t INDEX_DIFF_TYPE;
+#else
   typedef int NUM_TYPE;
   typedef int VERTEX_INDEX;
 
   /// Index difference type.  Must be signed.
   typedef int INDEX_DIFF_TYPE;
+#endif
 
   typedef std::pair<VERTEX_INDEX, VERTEX_INDEX> VERTEX_PAIR;
 
@@ -92,6 +118,9 @@ namespace SHARPISO {
   /// Number of vertices in two cubes sharing a facet.
   const NUM_TYPE NUM_TWO_CUBE_VERTICES3D = DIM3 * NUM_CUBE_VERTICES3D;
 
+  /// Number of cubes whose Lindstrom normal equations are solved together.
+  const NUM_TYPE LINDSTROM_BATCH_SIZE = 64;
+
 
   // *** NOTE:  SHOULD BE REPLACED BY PARAMETER ***
   // clamp very small values to the cube.
@@ -21,6 +21,10 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+#include <thread>
+#include <vector>
+
 #include "anisograd.h"
 
 #include "ijkcoord.txx"
@@ -90,6 +94,105 @@ void anisotropic_diff_per_vert
 }
 
 
+// Compute one iteration of anisotropic diffusion
+// for vertices in slabs z0,...,z1-1.
+// Reads gradient_grid and writes normalized gradients to new_gradient_grid.
+void anisotropic_diff_slabs
+(
+		const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+		const float mu,
+		const float lambda,
+		const int flag_aniso,
+		const int icube,
+		const GRADIENT_GRID & gradient_grid,
+		const GRID_COORD_TYPE z0,
+		const GRID_COORD_TYPE z1,
+		GRADIENT_GRID & new_gradient_grid
+)
+{
+	const AXIS_SIZE_TYPE * axis_size = scalar_grid.AxisSize();
+	const VERTEX_INDEX yinc = scalar_grid.AxisIncrement(1);
+	const VERTEX_INDEX zinc = scalar_grid.AxisIncrement(2);
+
+	// Vertices at distance less than 2 from the grid boundary
+	//   are boundary vertices.
+	const GRID_COORD_TYPE x0 = std::min(GRID_COORD_TYPE(2), axis_size[0]);
+	const GRID_COORD_TYPE x1 = std::max(axis_size[0]-2, x0);
+
+	for (GRID_COORD_TYPE z = z0; z < z1; z++) {
+		for (GRID_COORD_TYPE y = 0; y < axis_size[1]; y++) {
+			const VERTEX_INDEX iv_row = y*yinc + z*zinc;
+
+			if (2 <= y && y+2 < axis_size[1] && 2 <= z && z+2 < axis_size[2]) {
+				for (GRID_COORD_TYPE x = 0; x < x0; x++) {
+					compute_boundary_gradient
+					(scalar_grid, iv_row+x, new_gradient_grid.VectorPtr(iv_row+x));
+				}
+				for (GRID_COORD_TYPE x = x0; x < x1; x++) {
+					anisotropic_diff_per_vert
+					(scalar_grid, mu, lambda, iv_row+x, flag_aniso, icube,
+					 gradient_grid, new_gradient_grid);
+				}
+				for (GRID_COORD_TYPE x = x1; x < axis_size[0]; x++) {
+					compute_boundary_gradient
+					(scalar_grid, iv_row+x, new_gradient_grid.VectorPtr(iv_row+x));
+				}
+			}
+			else {
+				for (GRID_COORD_TYPE x = 0; x < axis_size[0]; x++) {
+					compute_boundary_gradient
+					(scalar_grid, iv_row+x, new_gradient_grid.VectorPtr(iv_row+x));
+				}
+			}
+
+			for (GRID_COORD_TYPE x = 0; x < axis_size[0]; x++)
+			{ normalize(new_gradient_grid.VectorPtr(iv_row+x), DIM3, EPSILON); }
+		}
+	}
+}
+
+
+// Compute one iteration of anisotropic diffusion.
+// Reads gradient_grid and writes normalized gradients to new_gradient_grid.
+// Slabs of the grid are split among num_threads threads.
+void anisotropic_diff_iter
+(
+		const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+		const float mu,
+		const float lambda,
+		const int flag_aniso,
+		const int icube,
+		const int num_threads,
+		const GRADIENT_GRID & gradient_grid,
+		GRADIENT_GRID & new_gradient_grid
+)
+{
+	const GRID_COORD_TYPE num_slabs = scalar_grid.AxisSize(2);
+	const int nthreads = std::max(1, std::min(num_threads, int(num_slabs)));
+
+	if (nthreads <= 1) {
+		anisotropic_diff_slabs
+		(scalar_grid, mu, lambda, flag_aniso, icube, gradient_grid,
+		 0, num_slabs, new_gradient_grid);
+		return;
+	}
+
+	std::vector<std::thread> thread_list;
+	for (int i = 0; i < nthreads; i++) {
+		const GRID_COORD_TYPE z0 = (num_slabs*i)/nthreads;
+		const GRID_COORD_TYPE z1 = (num_slabs*(i+1))/nthreads;
+		thread_list.push_back(std::thread([&, z0, z1]() {
+			anisotropic_diff_slabs
+			(scalar_grid, mu, lambda, flag_aniso, icube, gradient_grid,
+			 z0, z1, new_gradient_grid);
+		}));
+	}
+
+	for (int i = 0; i < nthreads; i++)
+	{ thread_list[i].join(); }
+}
+
+
 /// calculate the anisotropic diff of the gradients per iteration
 void anisotropic_diff_iter_k
 (
@@ -103,39 +206,19 @@ void anisotropic_diff_iter_k
 		GRADIENT_GRID & gradient_grid
 )
 {
-	// create a temporary grid for each iteration
 	GRADIENT_GRID temp_gradient_grid;
 	temp_gradient_grid.SetSize(scalar_grid, dimension);
 
-	for (VERTEX_INDEX iv = 0; iv<scalar_grid.NumVertices(); iv++)
-	{
-		GRID_COORD_TYPE coord[DIM3];
-		scalar_grid.ComputeCoord(iv, coord);
-
-		if (2 <= coord[0] && coord[0]+2 < scalar_grid.AxisSize(0) &&
-				2 <= coord[1] && coord[1]+2 < scalar_grid.AxisSize(1) &&
-				2 <= coord[2] && coord[2]+2 < scalar_grid.AxisSize(2)) {
-
-			// Store new gradient values in temp_gradient_grid
-			anisotropic_diff_per_vert
-			(scalar_grid, mu, lambda, iv, flag_aniso, icube, gradient_grid, temp_gradient_grid );
-		}
-		else {
-			compute_boundary_gradient
-			(scalar_grid, iv, temp_gradient_grid.VectorPtr(iv));
-		}
-	}
+	anisotropic_diff_iter
+	(scalar_grid, mu, lambda, flag_aniso, icube, 1,
+	 gradient_grid, temp_gradient_grid);
 
-	// Copy temp_gradient_grid to gradient_grid.
-	for (int l=0; l<scalar_grid.NumVertices(); l++) {
-		GRADIENT_COORD_TYPE * grad = temp_gradient_grid.VectorPtr(l);
-		// debug normalize
-		normalize(grad, DIM3, EPSILON);
-		gradient_grid.Set(l, grad);
-	}
+	gradient_grid.CopyVector(temp_gradient_grid);
 }
 
 // Calculate the anisotropic diffusion of the gradients.
+// Alternate between gradient_grid and a single buffer grid,
+//   so no grid is allocated or copied in each iteration.
 void anisotropic_diff
 (
 		const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
@@ -144,6 +227,7 @@ void anisotropic_diff
 		const int num_iter,
 		const int flag_aniso,
 		const int icube,
+		const int num_threads,
 		GRADIENT_GRID & gradient_grid
 )
 {
@@ -151,13 +235,23 @@ void anisotropic_diff
 	const int dimension = scalar_grid.Dimension();
 	gradient_grid.SetSize(scalar_grid, dimension);
 
+	GRADIENT_GRID buffer_grid;
+	buffer_grid.SetSize(scalar_grid, dimension);
+
+	GRADIENT_GRID * current_grid = &gradient_grid;
+	GRADIENT_GRID * next_grid = &buffer_grid;
 
 	for (int k=0; k<num_iter; k++) {
 		// DEBUG
 			cout <<" iteration ["<<num_iter<<"] of ["<<num_iter<<"]."<<endl;
-		anisotropic_diff_iter_k
-		(scalar_grid, mu, lambda, k, flag_aniso, icube, dimension, gradient_grid);
+		anisotropic_diff_iter
+		(scalar_grid, mu, lambda, flag_aniso, icube, num_threads,
+		 *current_grid, *next_grid);
+		std::swap(current_grid, next_grid);
 	}
+
+	if (current_grid != &gradient_grid)
+	{ gradient_grid.CopyVector(*current_grid); }
 };
 
 
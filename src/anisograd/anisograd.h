@@ -40,6 +40,7 @@ void compute_gradient_central_difference
  const int icube, GRADIENT_GRID & gradient_grid);
 
 // Calculate the anisotropic diff of the gradients.
+// Each iteration is split among num_threads threads.
 void anisotropic_diff
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const float mu,
@@ -47,6 +48,7 @@ void anisotropic_diff
  const int num_iter,
  const int flag_aniso,
  const int icube,
+ const int num_threads,
  GRADIENT_GRID & gradient_grid);
 
 
@@ -46,6 +46,7 @@ float large_magnitude = 2.0;
 float mu(0.1);
 float lambda(1.0);
 int num_iter = 10;
+int num_threads = 1;
 VERTEX_INDEX icube = 0;
 
 bool debug = true;
@@ -108,12 +109,12 @@ int main(int argc, char **argv)
 			if (flag_iso)
 			{
 				cout << "isotropic diffusion called "<<endl;
-				anisotropic_diff (full_scalar_grid,  mu, lambda, num_iter, 0, icube, gradient_grid);
+				anisotropic_diff (full_scalar_grid,  mu, lambda, num_iter, 0, icube, num_threads, gradient_grid);
 			}
 			else
 			{
 				// Compute the anisotropic diffusion of the gradients
-				anisotropic_diff (full_scalar_grid,  mu, lambda, num_iter, 1, icube, gradient_grid);
+				anisotropic_diff (full_scalar_grid,  mu, lambda, num_iter, 1, icube, num_threads, gradient_grid);
 			}
 			//reset the magnitudes
 			reset_gradient_magnitudes
@@ -196,6 +197,12 @@ void parse_command_line(int argc, char **argv)
 			if (iarg >= argc) { usage_error(); };
 			sscanf(argv[iarg], "%d", &num_iter);
 		}
+		else if (string(argv[iarg]) == "-threads")
+		{
+			iarg++;
+			if (iarg >= argc) { usage_error(); };
+			sscanf(argv[iarg], "%d", &num_threads);
+		}
 		else if (string(argv[iarg]) == "-icube")
 		{
 			iarg++;
@@ -223,6 +230,7 @@ void usage_msg()
 	cerr <<"                 [-mu]       extent of anisotropic diffusion"<< endl;
 	cerr <<"                 [-lambda]   extent of diffusion in each iteration " <<endl;
 	cerr <<"                 [-num_iter] number of iterations "<<endl;
+	cerr <<"                 [-threads]  number of threads "<<endl;
 	cerr << endl;
 }
 
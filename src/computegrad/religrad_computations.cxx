@@ -8,6 +8,8 @@
 #include "ijkgrid_macros.h"
 #include "sharpiso_types.h"
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include <vector>
 using namespace RELIGRADIENT;
 using namespace std;
@@ -19,6 +21,93 @@ namespace {
 
 	typedef IJK::BOOL_GRID_BASE<RELIGRADIENT_GRID> BOOL_GRID_BASE;
 	typedef IJK::BOOL_GRID<RELIGRADIENT_GRID> BOOL_GRID;
+	typedef IJK::GRID_NEIGHBORHOOD_STENCIL
+		<int, AXIS_SIZE_TYPE, VERTEX_INDEX, NUM_TYPE> NEIGHBORHOOD_STENCIL;
+
+	/// Number of vertices processed by a thread before
+	///   it takes the next block of vertices.
+	const VERTEX_INDEX VERTEX_BLOCK_SIZE = 4096;
+
+	/// Counts accumulated by a reliable gradient filter.
+	/// Each thread keeps its own counts.
+	class RELIGRAD_COUNT {
+	public:
+		unsigned long num_reliable;
+		unsigned long num_unreliable;
+		unsigned long grad_mag_zero;
+		unsigned long num_vertices_mag_grt_zero;
+
+		RELIGRAD_COUNT()
+		{
+			num_reliable = 0;
+			num_unreliable = 0;
+			grad_mag_zero = 0;
+			num_vertices_mag_grt_zero = 0;
+		}
+
+		void Add(const RELIGRAD_COUNT & count)
+		{
+			num_reliable += count.num_reliable;
+			num_unreliable += count.num_unreliable;
+			grad_mag_zero += count.grad_mag_zero;
+			num_vertices_mag_grt_zero += count.num_vertices_mag_grt_zero;
+		}
+	};
+
+	/*
+	* Apply filter to all vertices using io_info.num_threads threads.
+	* Threads take blocks of VERTEX_BLOCK_SIZE consecutive vertices.
+	* filter(iv_begin, iv_end, count) processes vertices [iv_begin,iv_end)
+	*   and may only change reliable_grid at those vertices.
+	* Counts from all threads are added to io_info after the threads finish.
+	*/
+	template <typename FILTER_TYPE>
+	void apply_reliable_gradient_filter
+	(const VERTEX_INDEX num_vertices, const FILTER_TYPE & filter,
+	 INPUT_INFO & io_info)
+	{
+		RELIGRAD_COUNT total_count;
+		int num_threads = io_info.num_threads;
+
+		if (num_threads > num_vertices/VERTEX_BLOCK_SIZE)
+			{ num_threads = num_vertices/VERTEX_BLOCK_SIZE; }
+
+		if (num_threads <= 1) {
+			filter(0, num_vertices, total_count);
+		}
+		else {
+			std::atomic<VERTEX_INDEX> next_block(0);
+			std::vector<RELIGRAD_COUNT> thread_count(num_threads);
+			std::vector<std::thread> thread_list;
+
+			for (int k = 0; k < num_threads; k++) {
+				thread_list.push_back(std::thread([&, k]()
+				{
+					RELIGRAD_COUNT count;
+					while (true) {
+						const VERTEX_INDEX iv_begin =
+							next_block.fetch_add(VERTEX_BLOCK_SIZE);
+						if (iv_begin >= num_vertices) { break; }
+						const VERTEX_INDEX iv_end =
+							std::min(iv_begin+VERTEX_BLOCK_SIZE, num_vertices);
+						filter(iv_begin, iv_end, count);
+					}
+					thread_count[k] = count;
+				}));
+			}
+
+			for (int k = 0; k < num_threads; k++) {
+				thread_list[k].join();
+				total_count.Add(thread_count[k]);
+			}
+		}
+
+		io_info.out_info.num_reliable += total_count.num_reliable;
+		io_info.out_info.num_unreliable += total_count.num_unreliable;
+		io_info.out_info.grad_mag_zero += total_count.grad_mag_zero;
+		io_info.num_vertices_mag_grt_zero +=
+			total_count.num_vertices_mag_grt_zero;
+	}
 
 };
 
@@ -263,15 +352,18 @@ bool gradients_agree(
 * Compute reliable gradients by comparing with neighboring gradients
 * neighboring gradients are defined by "angle_based_dist"
 */
-void compute_reliable_gradients_angle(
+void compute_reliable_gradients_angle_in_range(
 	const RELIGRADIENT_SCALAR_GRID_BASE & scalar_grid,
-	GRADIENT_GRID & gradient_grid,
-	GRADIENT_MAGNITUDE_GRID & grad_mag_grid,
+	const GRADIENT_GRID & gradient_grid,
+	const GRADIENT_MAGNITUDE_GRID & grad_mag_grid,
+	const VERTEX_INDEX iv_begin,
+	const VERTEX_INDEX iv_end,
 	BOOL_GRID & reliable_grid,
-	INPUT_INFO & io_info) 
+	const INPUT_INFO & io_info,
+	RELIGRAD_COUNT & count)
 {
 	int numAgree = 0;
-	for (VERTEX_INDEX iv = 0; iv < scalar_grid.NumVertices(); iv++) {
+	for (VERTEX_INDEX iv = iv_begin; iv < iv_end; iv++) {
 		numAgree = 0;
 		GRADIENT_COORD_TYPE gradient_iv[DIM3] = { 0.0, 0.0, 0.0 };
 		GRADIENT_COORD_TYPE gradient_iv_mag = grad_mag_grid.Scalar(iv);
@@ -312,20 +404,39 @@ void compute_reliable_gradients_angle(
 			if (numAgree < io_info.min_num_agree) 
 			{
 				reliable_grid.Set(iv, false);
-				io_info.out_info.num_unreliable++;
+				count.num_unreliable++;
 			} 
 			else 
 			{
-				io_info.out_info.num_reliable++;
+				count.num_reliable++;
 			}
 		} 
 		else 
 		{
-			io_info.out_info.grad_mag_zero++;
+			count.grad_mag_zero++;
 		}
 	}
 }
 
+// Angle based test on all vertices.
+// Process vertices in parallel using io_info.num_threads threads.
+void compute_reliable_gradients_angle(
+	const RELIGRADIENT_SCALAR_GRID_BASE & scalar_grid,
+	GRADIENT_GRID & gradient_grid,
+	GRADIENT_MAGNITUDE_GRID & grad_mag_grid,
+	BOOL_GRID & reliable_grid,
+	INPUT_INFO & io_info)
+{
+	apply_reliable_gradient_filter(scalar_grid.NumVertices(),
+		[&](const VERTEX_INDEX iv_begin, const VERTEX_INDEX iv_end,
+			RELIGRAD_COUNT & count)
+		{
+			compute_reliable_gradients_angle_in_range
+				(scalar_grid, gradient_grid, grad_mag_grid, iv_begin, iv_end,
+				reliable_grid, io_info, count);
+		}, io_info);
+}
+
 // scalar based 
 void compute_plane_point_dist(
 	const GRADIENT_COORD_TYPE * normal,
@@ -341,12 +452,16 @@ void compute_plane_point_dist(
 }
 
 // Scalar based prediction
-void compute_reliable_gradients_SBP
-	(const RELIGRADIENT_SCALAR_GRID_BASE & scalar_grid,
+void compute_reliable_gradients_SBP_in_range(
+	const RELIGRADIENT_SCALAR_GRID_BASE & scalar_grid,
 	const GRADIENT_GRID & gradient_grid,
-	const  GRADIENT_MAGNITUDE_GRID & grad_mag_grid,
-	IJK::BOOL_GRID<RELIGRADIENT_GRID> & reliable_grid,
-	INPUT_INFO & io_info) 
+	const GRADIENT_MAGNITUDE_GRID & grad_mag_grid,
+	const NEIGHBORHOOD_STENCIL & stencil,
+	const VERTEX_INDEX iv_begin,
+	const VERTEX_INDEX iv_end,
+	BOOL_GRID & reliable_grid,
+	const INPUT_INFO & io_info,
+	RELIGRAD_COUNT & count)
 {
 	GRADIENT_COORD_TYPE grad_iv[DIM3];  // unscaled gradient vector
 	GRADIENT_COORD_TYPE normalized_grad_iv[DIM3]; // normalized grad_iv
@@ -357,7 +472,7 @@ void compute_reliable_gradients_SBP
 
 
 	bool debug = false;
-	for (VERTEX_INDEX iv = 0; iv < scalar_grid.NumVertices(); iv++) {
+	for (VERTEX_INDEX iv = iv_begin; iv < iv_end; iv++) {
 
 		
 		// only run the test if gradient at vertex iv is reliable
@@ -388,20 +503,22 @@ void compute_reliable_gradients_SBP
 				// set up a vector to keep track of the distances
 				vector<SCALAR_TYPE> vec_scalar_dists;
 
-				io_info.num_vertices_mag_grt_zero++;
+				count.num_vertices_mag_grt_zero++;
 				// find the normalized gradient
 				// point on the plane
 				// find neighbor vertices
-				vector<VERTEX_INDEX> near_vertices;
-				scalar_grid.GetVertexNeighbors
-					(iv, io_info.scalar_prediction_dist, near_vertices);
+				const bool is_interior = stencil.IsInterior(coord_iv);
 
 				// for all the neighboring points find the distance of points to plane
 				bool flag_correct = true;
-				for (int nv_ind = 0; nv_ind < near_vertices.size(); nv_ind++) {
+				for (NUM_TYPE k = 0; k < stencil.NumNeighbors(); k++) {
 
-					VERTEX_INDEX nv = near_vertices[nv_ind];
-					scalar_grid.ComputeCoord(nv, coord_nv);
+					if (!is_interior && !stencil.ContainsNeighbor(coord_iv, k))
+						{ continue; }
+
+					VERTEX_INDEX nv = stencil.Neighbor(iv, k);
+					for (int d = 0; d < DIM3; d++)
+						{ coord_nv[d] = coord_iv[d] + stencil.OffsetCoord(k, d); }
 
 					// compute distance to plane
 
@@ -429,16 +546,39 @@ void compute_reliable_gradients_SBP
 
 				if (!flag_correct) {
 					reliable_grid.Set(iv, false);
-					io_info.out_info.num_unreliable++;
+					count.num_unreliable++;
 				}
 				else {
-					io_info.out_info.num_reliable++;
+					count.num_reliable++;
 				}
 			}
 		}
 	}
 }
 
+// Scalar based prediction on all vertices.
+// Process vertices in parallel using io_info.num_threads threads.
+void compute_reliable_gradients_SBP
+	(const RELIGRADIENT_SCALAR_GRID_BASE & scalar_grid,
+	const GRADIENT_GRID & gradient_grid,
+	const  GRADIENT_MAGNITUDE_GRID & grad_mag_grid,
+	IJK::BOOL_GRID<RELIGRADIENT_GRID> & reliable_grid,
+	INPUT_INFO & io_info)
+{
+	NEIGHBORHOOD_STENCIL stencil;
+	stencil.Set(scalar_grid, io_info.scalar_prediction_dist);
+
+	apply_reliable_gradient_filter(scalar_grid.NumVertices(),
+		[&](const VERTEX_INDEX iv_begin, const VERTEX_INDEX iv_end,
+			RELIGRAD_COUNT & count)
+		{
+			compute_reliable_gradients_SBP_in_range
+				(scalar_grid, gradient_grid, grad_mag_grid, stencil,
+				iv_begin, iv_end,
+				reliable_grid, io_info, count);
+		}, io_info);
+}
+
 // Compute vector between two grid coords
 // parameters
 // scalar_grid, 
@@ -509,13 +649,17 @@ bool update_tangent_vertex_list(
 * @return grad_mag_grid. Gradient magnitude grid. 
 * @return reliable_grid. Reliable gradients  grid.
 */
-void compute_reliable_gradients_advangle(
+void compute_reliable_gradients_advangle_in_range(
 	const RELIGRADIENT_SCALAR_GRID_BASE & scalar_grid,
 	const GRADIENT_GRID & gradient_grid,
 	const GRADIENT_MAGNITUDE_GRID & grad_mag_grid,
-	IJK::BOOL_GRID<RELIGRADIENT_GRID> &reliable_grid,
-	INPUT_INFO & io_info)
+	const VERTEX_INDEX iv_begin,
+	const VERTEX_INDEX iv_end,
+	BOOL_GRID & reliable_grid,
+	const INPUT_INFO & io_info,
+	RELIGRAD_COUNT & count)
 {
+	vector<VERTEX_INDEX> tangent_vertex_list;
 	bool debug = false;
 
 	//float degree_param = 30*M_PI/180.0;
@@ -529,7 +673,7 @@ void compute_reliable_gradients_advangle(
 
 	cout <<" axis increment  "<<  scalar_grid.AxisIncrement(0)
 	<<", " <<scalar_grid.AxisIncrement(1) <<"," <<scalar_grid.AxisIncrement(2);*/
-	for (VERTEX_INDEX iv = 0; iv < scalar_grid.NumVertices(); iv++) 
+	for (VERTEX_INDEX iv = iv_begin; iv < iv_end; iv++) 
 	{
 		COORD_TYPE coord_iv[DIM3] = {0.0,0.0,0.0};
 		COORD_TYPE coord1[DIM3] = {0.0,0.0,0.0};
@@ -540,7 +684,7 @@ void compute_reliable_gradients_advangle(
 		}
 		int numAgree = 0;
 
-		vector<VERTEX_INDEX> tangent_vertex_list;
+		tangent_vertex_list.clear();
 
 		GRADIENT_COORD_TYPE gradient_iv[DIM3] = { 0.0, 0.0, 0.0 };
 		GRADIENT_COORD_TYPE gradient_iv_mag = grad_mag_grid.Scalar(iv);
@@ -626,7 +770,7 @@ void compute_reliable_gradients_advangle(
 				}*/
 			}
 			//cout <<"tangent neighbor sizes " << tangent_vertex_list.size() << endl;
-			for (int v = 0; v < tangent_vertex_list.size(); v++)
+			for (int v = 0; v < int(tangent_vertex_list.size()); v++)
 			{
 				if(gradients_agree(gradient_grid, iv, tangent_vertex_list[v], io_info))
 				{
@@ -634,31 +778,54 @@ void compute_reliable_gradients_advangle(
 				}
 			}
 
-			if(numAgree != tangent_vertex_list.size())
+			if(numAgree != int(tangent_vertex_list.size()))
 			{
 				//cout <<"not reliable "<< tangent_vertex_list.size()<<" vs "<< numAgree<<endl;
 
 				reliable_grid.Set(iv, false);
-				io_info.out_info.num_unreliable++;
+				count.num_unreliable++;
 			}
 			else
 			{
 				//cout <<"reliable\n";
-				io_info.out_info.num_reliable++;
+				count.num_reliable++;
 			}
 
 		}// if end 
 	}
 }
 
+// Advanced angle based test on all vertices.
+// Process vertices in parallel using io_info.num_threads threads.
+void compute_reliable_gradients_advangle(
+	const RELIGRADIENT_SCALAR_GRID_BASE & scalar_grid,
+	const GRADIENT_GRID & gradient_grid,
+	const GRADIENT_MAGNITUDE_GRID & grad_mag_grid,
+	IJK::BOOL_GRID<RELIGRADIENT_GRID> &reliable_grid,
+	INPUT_INFO & io_info)
+{
+	apply_reliable_gradient_filter(scalar_grid.NumVertices(),
+		[&](const VERTEX_INDEX iv_begin, const VERTEX_INDEX iv_end,
+			RELIGRAD_COUNT & count)
+		{
+			compute_reliable_gradients_advangle_in_range
+				(scalar_grid, gradient_grid, grad_mag_grid, iv_begin, iv_end,
+				reliable_grid, io_info, count);
+		}, io_info);
+}
 
 
-void compute_reliable_gradients_advangle_version2(
+
+void compute_reliable_gradients_advangle_version2_in_range(
 	const RELIGRADIENT_SCALAR_GRID_BASE & scalar_grid,
 	const GRADIENT_GRID & gradient_grid,
-	const  GRADIENT_MAGNITUDE_GRID & grad_mag_grid,
-	IJK::BOOL_GRID<RELIGRADIENT_GRID> & reliable_grid,
-	INPUT_INFO & io_info) 
+	const GRADIENT_MAGNITUDE_GRID & grad_mag_grid,
+	const NEIGHBORHOOD_STENCIL & stencil,
+	const VERTEX_INDEX iv_begin,
+	const VERTEX_INDEX iv_end,
+	BOOL_GRID & reliable_grid,
+	const INPUT_INFO & io_info,
+	RELIGRAD_COUNT & count)
 {
 	GRADIENT_COORD_TYPE grad_iv[DIM3];  // unscaled gradient vector
 	GRADIENT_COORD_TYPE normalized_grad_iv[DIM3]; // normalized grad_iv
@@ -668,8 +835,9 @@ void compute_reliable_gradients_advangle_version2(
 	COORD_TYPE err_distance;
 
 
+	vector<VERTEX_INDEX> tangent_vertex_list;
 	bool debug = false;
-	for (VERTEX_INDEX iv = 0; iv < scalar_grid.NumVertices(); iv++) {
+	for (VERTEX_INDEX iv = iv_begin; iv < iv_end; iv++) {
 		int numAgree = 0;
 		// only run the test if gradient at vertex iv is reliable
 		if (reliable_grid.Scalar(iv)) {
@@ -700,21 +868,23 @@ void compute_reliable_gradients_advangle_version2(
 				// set up a vector to keep track of the distances
 				vector<SCALAR_TYPE> vec_scalar_dists;
 
-				io_info.num_vertices_mag_grt_zero++;
+				count.num_vertices_mag_grt_zero++;
 				// find the normalized gradient
 				// point on the plane
 				// find neighbor vertices
-				vector<VERTEX_INDEX> near_vertices;
-				scalar_grid.GetVertexNeighbors
-					(iv, io_info.scalar_prediction_dist, near_vertices);
+				const bool is_interior = stencil.IsInterior(coord_iv);
 
 				// for all the neighboring points find the distance of points to plane
 				bool flag_correct = true;
-				vector<VERTEX_INDEX> tangent_vertex_list;
-				for (int nv_ind = 0; nv_ind < near_vertices.size(); nv_ind++) 
+				tangent_vertex_list.clear();
+				for (NUM_TYPE k = 0; k < stencil.NumNeighbors(); k++) 
 				{
-					VERTEX_INDEX nv = near_vertices[nv_ind];
-					scalar_grid.ComputeCoord(nv, coord_nv);
+					if (!is_interior && !stencil.ContainsNeighbor(coord_iv, k))
+						{ continue; }
+
+					VERTEX_INDEX nv = stencil.Neighbor(iv, k);
+					for (int d = 0; d < DIM3; d++)
+						{ coord_nv[d] = coord_iv[d] + stencil.OffsetCoord(k, d); }
 
 					// compute distance to plane
 
@@ -731,7 +901,7 @@ void compute_reliable_gradients_advangle_version2(
 				}//neighbor loop ends
 
 
-				for (int v = 0; v < tangent_vertex_list.size(); v++)
+				for (int v = 0; v < int(tangent_vertex_list.size()); v++)
 				{
 					if(gradients_agree(gradient_grid, iv, tangent_vertex_list[v], io_info))
 					{
@@ -739,21 +909,44 @@ void compute_reliable_gradients_advangle_version2(
 					}
 				}
 
-				if(numAgree != tangent_vertex_list.size())
+				if(numAgree != int(tangent_vertex_list.size()))
 				{
 					if(debug)
 						cout <<"not reliable "<< tangent_vertex_list.size()<<" vs "<< numAgree<<endl;
 
 					reliable_grid.Set(iv, false);
-					io_info.out_info.num_unreliable++;
+					count.num_unreliable++;
 				}
 				else
 				{
 					if(debug)
 						cout <<"reliable\n"<< tangent_vertex_list.size()<<" vs "<< numAgree<<endl;
-					io_info.out_info.num_reliable++;
+					count.num_reliable++;
 				}
 			}
 		}
 	}
 }
+
+// Advanced angle based test, version 2, on all vertices.
+// Process vertices in parallel using io_info.num_threads threads.
+void compute_reliable_gradients_advangle_version2(
+	const RELIGRADIENT_SCALAR_GRID_BASE & scalar_grid,
+	const GRADIENT_GRID & gradient_grid,
+	const  GRADIENT_MAGNITUDE_GRID & grad_mag_grid,
+	IJK::BOOL_GRID<RELIGRADIENT_GRID> & reliable_grid,
+	INPUT_INFO & io_info)
+{
+	NEIGHBORHOOD_STENCIL stencil;
+	stencil.Set(scalar_grid, io_info.scalar_prediction_dist);
+
+	apply_reliable_gradient_filter(scalar_grid.NumVertices(),
+		[&](const VERTEX_INDEX iv_begin, const VERTEX_INDEX iv_end,
+			RELIGRAD_COUNT & count)
+		{
+			compute_reliable_gradients_advangle_version2_in_range
+				(scalar_grid, gradient_grid, grad_mag_grid, stencil,
+				iv_begin, iv_end,
+				reliable_grid, io_info, count);
+		}, io_info);
+}
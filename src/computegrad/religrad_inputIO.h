@@ -58,6 +58,7 @@ public:
 	int num_vertices_mag_grt_zero;
 	float neighbor_angle_parameter; // threshold for angle between gradient at vertex v
 			// and the vector connecting the neighbor vertex.
+	int num_threads; // number of threads used by reliable gradient tests
 
 
 
@@ -70,6 +71,9 @@ public:
 		//angle based 
 		angle_based = false;
 		angle_based_dist = 1;
+		//advanced angle based
+		adv_angle_based = false;
+		adv_angle_based_v2 = false;
 		//scalar_based
 		flag_reliable_scalar_prediction = false;
 
@@ -88,6 +92,7 @@ public:
 		min_cos_of_angle = cos((param_angle*M_PI/180.0)); // 20 degrees=0.34906585, 30 degrees=0.523598776;
 		out_info.set_defaults();
 		num_vertices_mag_grt_zero=0;
+		num_threads = 1;
 
 	}
 
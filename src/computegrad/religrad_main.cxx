@@ -427,6 +427,15 @@ void parse_command_line(int argc, char **argv, INPUT_INFO & io_info) {
 			io_info.adv_angle_based = true;
 			io_info.neighbor_angle_parameter = atof(argv[iarg]);
 		}
+		else if (s == "-threads") {
+			iarg++;
+			if (iarg >= argc) { usage_error(); }
+			io_info.num_threads = atoi(argv[iarg]);
+			if (io_info.num_threads < 1) {
+				cerr << "Number of threads must be at least 1." << endl;
+				usage_error();
+			}
+		}
 		else if (s == "-gzip") {
 			flag_gzip = true;
 		} 
@@ -457,7 +466,7 @@ void usage_msg() {
 	cerr << "  [-angle_based_dist {D}] [-reliable_scalar_pred_dist {D}]" << endl;
 	cerr << "  [-neighbor_angle {A}]"<< endl;
 	cerr << "  [-scalar_pred_err {E}]" << endl;
-	cerr << "  [-gzip]" << endl;
+	cerr << "  [-threads {N}] [-gzip]" << endl;
 	cerr << "  [-out_param] [-print_info {V}] [-print_grad_loc] [-help]" << endl;
 }
 
@@ -485,6 +494,9 @@ void help_msg() {
 		<< endl;
 	cerr << "     Errors above the threshold fail the test. (Default 0.4.)" 
 		<< endl;
+	cerr << "  -threads {N}: Run reliable gradient tests using {N} threads."
+		<< endl;
+	cerr << "     (Default 1.)" << endl;
 	cerr << "  -gzip: Store gradients in compressed (gzip) format." << endl;
 	cerr << "  -out_param:  Print parameters." << endl;
 	cerr << "  -print_info {V} : Print information about vertex {IV}." << endl;
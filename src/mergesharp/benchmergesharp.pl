@@ -0,0 +1,514 @@
+#!/usr/bin/perl
+# benchmark mergesharp and isodual3D on the data/ volumes
+#   and on large synthetic volumes generated by ijkgenscalar.
+# Results are written one measurement per line and may be compared
+#   against a saved baseline.
+
+use strict;
+
+my $testdir = "data";
+my $outfile = "bench_temp.off";
+my $json_file = "bench_temp.json";
+my $synthetic_file = "bench_synthetic.nrrd";
+my $results_file = "bench_results.txt";
+my $baseline_file = "";
+my $threshold = 0.10;
+my $min_seconds = 0.01;
+my $num_repeat = 1;
+my $large_flag = 0;
+my @synthetic_asize;
+my $fastflag = 0;
+my $found_regression = 0;
+
+my @proglist = @ARGV;
+my @input_options;
+
+# mergesharp arguments which take an input value/string.
+my @mergesharp_options = ( "-subsample",  "-position", "-round",
+                          "-max_dist", "-max_grad_dist",
+                          "-max_eigen", "-merge_linf_th",
+                          "-threads", "-isovalue_threads",
+                          "-minmax_region", "-slab", "-min_gradient_mag" );
+
+while (scalar(@proglist) > 0 &&
+       $proglist[0] =~ /^\-.*/) {
+
+  my $new_option = shift(@proglist);
+
+  if ($new_option eq "-help") {
+    help();
+  }
+
+  if ($new_option eq "-fast") {
+    $fastflag = 1;
+    next;
+  }
+
+  if ($new_option eq "-data") {
+    $testdir = shift(@proglist);
+    next;
+  }
+
+  if ($new_option eq "-large") {
+    $large_flag = 1;
+    next;
+  }
+
+  if ($new_option eq "-asize") {
+    $large_flag = 1;
+    push(@synthetic_asize, shift(@proglist));
+    next;
+  }
+
+  if ($new_option eq "-repeat") {
+    $num_repeat = shift(@proglist);
+    next;
+  }
+
+  if ($new_option eq "-o") {
+    $results_file = shift(@proglist);
+    next;
+  }
+
+  if ($new_option eq "-baseline") {
+    $baseline_file = shift(@proglist);
+    next;
+  }
+
+  if ($new_option eq "-threshold") {
+    $threshold = shift(@proglist);
+    next;
+  }
+
+  if ($new_option eq "-min_seconds") {
+    $min_seconds = shift(@proglist);
+    next;
+  }
+
+  push(@input_options, $new_option);
+
+  if (scalar(@proglist) > 0) {
+    if (is_mergesharp_option("$new_option")) {
+      $new_option = shift(@proglist);
+      push(@input_options, $new_option);
+    }
+  }
+}
+
+if (scalar(@proglist) < 1 || scalar(@proglist) > 2) { usage_error(); };
+
+my $mergesharp = $proglist[0];
+my $isodual3D = "";
+if (scalar(@proglist) > 1) { $isodual3D = $proglist[1]; }
+
+if (scalar(@synthetic_asize) == 0) {
+  @synthetic_asize = ( 256, 512, 1024 );
+}
+
+# Test data.  isovalue lists isovalues.
+# grad is the gradient file if it is not {fname}.grad.nrrd.
+my %testdata;
+
+$testdata{cube3D_A10x}{fname} = "cube3D.A10x.nrrd";
+$testdata{cube3D_A10x}{isovalue} = [ 3 ];
+
+$testdata{cylinder3D_A10x}{fname} = "cylinder3D.A10x.nrrd";
+$testdata{cylinder3D_A10x}{isovalue} = [ 2.5 ];
+
+$testdata{saddleA_4x}{fname} = "saddleA.4x.nrrd";
+$testdata{saddleA_4x}{isovalue} = [ 1.5 ];
+
+$testdata{edgeA_4x}{fname} = "edgeA.4x.nrrd";
+$testdata{edgeA_4x}{isovalue} = [ 2 ];
+
+$testdata{cornerA_4x}{fname} = "cornerA.4x.nrrd";
+$testdata{cornerA_4x}{isovalue} = [ 2 ];
+
+if (!$fastflag) {
+
+  $testdata{cube3D_A10x_gnoiseA}{fname} = "cube3D.A10x.gnoiseA.nrrd";
+  $testdata{cube3D_A10x_gnoiseA}{grad} = "cube3D.A10x.grad.nrrd";
+  $testdata{cube3D_A10x_gnoiseA}{isovalue} = [ 3 ];
+
+  $testdata{cube3D_A10x_unoiseB}{fname} = "cube3D.A10x.unoiseB.nrrd";
+  $testdata{cube3D_A10x_unoiseB}{grad} = "cube3D.A10x.grad.nrrd";
+  $testdata{cube3D_A10x_unoiseB}{isovalue} = [ 3 ];
+
+  $testdata{half_cubeA_10x}{fname} = "half_cubeA.10x.nrrd";
+  $testdata{half_cubeA_10x}{isovalue} = [ 3 ];
+
+  $testdata{saddleB_4x}{fname} = "saddleB.4x.nrrd";
+  $testdata{saddleB_4x}{isovalue} = [ 2 ];
+
+  $testdata{saddleC_4x}{fname} = "saddleC.4x.nrrd";
+  $testdata{saddleC_4x}{isovalue} = [ 2 ];
+
+  $testdata{edgeB_4x}{fname} = "edgeB.4x.nrrd";
+  $testdata{edgeB_4x}{isovalue} = [ 3 ];
+
+  $testdata{edgeC_4x}{fname} = "edgeC.4x.nrrd";
+  $testdata{edgeC_4x}{isovalue} = [ 5 ];
+
+  $testdata{edgeD_4x}{fname} = "edgeD.4x.nrrd";
+  $testdata{edgeD_4x}{isovalue} = [ 3 ];
+
+  $testdata{cornerB_4x}{fname} = "cornerB.4x.nrrd";
+  $testdata{cornerB_4x}{isovalue} = [ 2 ];
+
+  foreach my $k (0, 1, 3, 4, 7) {
+    $testdata{"corner_$k\_A10"}{fname} = "corner.$k.A10.nrrd";
+    $testdata{"corner_$k\_A10"}{isovalue} = [ 3 ];
+  }
+}
+
+# results{"$prog $tdata $isoval $metric"} = value
+my %results;
+
+foreach my $tdata (sort(keys %testdata)) {
+
+  my $tfile = "$testdir"."/"."$testdata{$tdata}{fname}";
+  my $gfile = $tfile;
+  $gfile =~ s/\.nrrd$/.grad.nrrd/;
+  if (exists $testdata{$tdata}{grad}) {
+    $gfile = "$testdir"."/"."$testdata{$tdata}{grad}";
+  }
+
+  foreach my $isoval (@{$testdata{$tdata}{isovalue}}) {
+    bench_volume($tdata, $tfile, $gfile, $isoval);
+  }
+}
+
+if ($large_flag) {
+
+  my $gfile = $synthetic_file;
+  $gfile =~ s/\.nrrd$/.grad.nrrd/;
+
+  foreach my $asize (@synthetic_asize) {
+
+    # Five randomly placed and oriented cubes.
+    # Cube size grows with the grid so active cubes scale as asize^2.
+    my $command_line =
+      "ijkgenscalar -grad -dim 3 -asize $asize -randompos 1 -randomdir 10001 -n 5 -field cube -dir \"1 1 1\" -side_dir \"1 0 0\" -s $synthetic_file";
+    print "$command_line\n";
+    system("$command_line") == 0 ||
+      die "Program ijkgenscalar abnormally terminated.\n";
+
+    my $isoval = $asize/5;
+    bench_volume("cube_n5_$asize", $synthetic_file, $gfile, $isoval);
+
+    unlink($synthetic_file, $gfile);
+  }
+}
+
+write_results();
+
+if ($baseline_file ne "") {
+  compare_with_baseline();
+}
+
+unlink($outfile, $json_file);
+
+if ($found_regression) { exit(1); }
+
+# ***********************************
+
+sub usage_error {
+  print "Usage: benchmergesharp.pl [OPTIONS] {mergesharp} [{isodual3D}]\n";
+  print "OPTIONS:\n";
+  print "  [-data {dir}] [-fast] [-large] [-asize {N}] [-repeat {R}]\n";
+  print "  [-o {results_file}] [-baseline {baseline_file}]\n";
+  print "  [-threshold {fraction}] [-min_seconds {S}] [-help]\n";
+  print "  [mergesharp options]\n";
+  exit(10);
+}
+
+sub help {
+  print "Usage: benchmergesharp.pl [OPTIONS] {mergesharp} [{isodual3D}]\n";
+  print "  Run mergesharp (and isodual3D) on the test volumes and report\n";
+  print "  throughput and peak memory.  Results are written one measurement\n";
+  print "  per line as: {program} {data} {isovalue} {metric} {value}\n";
+  print "  -data {dir}:  Directory containing test volumes. (Default data.)\n";
+  print "  -fast:  Run only a few small test volumes.\n";
+  print "  -large: Also run synthetic volumes generated by ijkgenscalar\n";
+  print "          with axis sizes 256, 512 and 1024.\n";
+  print "          Note: A 1024^3 volume with gradients needs 16 GB.\n";
+  print "  -asize {N}: Run synthetic volume with axis size N.\n";
+  print "          Replaces the default synthetic axis sizes.  May be repeated.\n";
+  print "  -repeat {R}: Run each volume R times and keep the fastest run.\n";
+  print "  -o {results_file}: Write results to results_file.\n";
+  print "          (Default bench_results.txt.)\n";
+  print "  -baseline {baseline_file}: Compare results with baseline_file.\n";
+  print "          Exit with status 1 if any measurement regressed.\n";
+  print "  -threshold {fraction}: Report regressions larger than fraction.\n";
+  print "          (Default 0.10.)\n";
+  print "  -min_seconds {S}: Ignore time and throughput regressions of runs\n";
+  print "          or stages shorter than S seconds in the baseline.\n";
+  print "          (Default 0.01.)\n";
+  print "  Other options are passed to mergesharp.\n";
+  exit(0);
+}
+
+# return true (1) if $_[0] is an mergesharp option which takes an
+#   input value/string
+sub is_mergesharp_option {
+
+  scalar(@_) == 1 ||
+    die "Error in sub is_mergesharp_option. Requires exactly 1 parameter.\n";
+
+  foreach my $option (@mergesharp_options) {
+    if ($_[0] eq $option) { return(1); }
+  }
+
+  return(0);
+}
+
+# return program command.
+sub prog_command {
+  my $prog = $_[0];
+  if ($prog =~ /\//) { return($prog); }
+  return("./$prog");
+}
+
+# run mergesharp and isodual3D on one volume and record results.
+sub bench_volume {
+
+  scalar(@_) == 4 ||
+    die "Error in sub bench_volume. Requires exactly 4 parameters.\n";
+
+  my ($tdata, $tfile, $gfile, $isoval) = @_;
+
+  my %best;
+  for (my $i = 0; $i < $num_repeat; $i++) {
+    my %run = run_mergesharp($tfile, $gfile, $isoval);
+    keep_fastest(\%best, \%run);
+  }
+  record_results("mergesharp", $tdata, $isoval, \%best);
+
+  if ($isodual3D ne "") {
+    my %best_isodual;
+    for (my $i = 0; $i < $num_repeat; $i++) {
+      my %run = run_isodual3D($tfile, $gfile, $isoval);
+      keep_fastest(\%best_isodual, \%run);
+    }
+    record_results("isodual3D", $tdata, $isoval, \%best_isodual);
+  }
+}
+
+# keep the run with smallest total time.
+sub keep_fastest {
+  my ($best, $run) = @_;
+  if (!exists $best->{total_seconds} ||
+      $run->{total_seconds} < $best->{total_seconds}) {
+    %$best = %$run;
+  }
+}
+
+# run mergesharp with -info and -time_json.
+# return hash of measurements.
+sub run_mergesharp {
+
+  my ($tfile, $gfile, $isoval) = @_;
+  my %run;
+
+  # -compute_gradient replaces the gradient file.
+  my $gradient_option = "-gradient $gfile";
+  if (grep { $_ eq "-compute_gradient" } @input_options)
+    { $gradient_option = ""; }
+
+  my $command_line = prog_command($mergesharp) .
+    " @input_options -info -time_json $json_file $gradient_option" .
+    " -o $outfile $isoval $tfile";
+  print "$command_line\n";
+
+  my @output = `$command_line`;
+  $? == 0 || die "Program mergesharp abnormally terminated.\n";
+
+  parse_info_output(\@output, \%run);
+
+  open(my $json, "<", "$json_file") ||
+    die "Unable to open file $json_file.\n";
+  while (my $line = <$json>) {
+    if ($line =~ /"total_seconds": *([0-9.eE+-]+)/) {
+      $run{total_seconds} = $1;
+    }
+    elsif ($line =~ /^ *"peak_rss_kb": *([0-9]+)/) {
+      $run{peak_rss_kb} = $1;
+    }
+    elsif ($line =~
+           /"name": *"([^"]+)", *"seconds": *([0-9.eE+-]+), *"calls": *([0-9]+), *"process_peak_rss_kb": *([0-9]+)/) {
+      $run{"stage.$1.seconds"} = $2;
+      $run{"stage.$1.calls"} = $3;
+      $run{"stage.$1.process_peak_rss_kb"} = $4;
+    }
+  }
+  close($json);
+
+  set_throughput(\%run);
+
+  return(%run);
+}
+
+# run isodual3D with -info and -time.
+# return hash of measurements.
+sub run_isodual3D {
+
+  my ($tfile, $gfile, $isoval) = @_;
+  my %run;
+
+  my $command_line = prog_command($isodual3D) .
+    " -info -time -gradient $gfile -o $outfile $isoval $tfile";
+
+  # Use GNU time for peak memory, if available.
+  my $flag_gnu_time = (-x "/usr/bin/time");
+  if ($flag_gnu_time) {
+    $command_line = "/usr/bin/time -f \"peak_rss_kb %M\" " .
+      "$command_line 2>&1";
+  }
+  print "$command_line\n";
+
+  my @output = `$command_line`;
+  $? == 0 || die "Program isodual3D abnormally terminated.\n";
+
+  parse_info_output(\@output, \%run);
+
+  foreach my $line (@output) {
+    if ($line =~ /^peak_rss_kb ([0-9]+)/) {
+      $run{peak_rss_kb} = $1;
+    }
+    elsif ($line =~ /Total elapsed time: *([0-9.eE+-]+)/) {
+      $run{total_seconds} = $1;
+    }
+    elsif ($line =~ /Time to ([a-z ]+?)(?: isosurface| interval volume)?(?: [a-z]+)?: *([0-9.eE+-]+) seconds/) {
+      my $stage = $1;
+      $stage =~ s/ /_/g;
+      $run{"stage.$stage.seconds"} = $2;
+    }
+  }
+
+  set_throughput(\%run);
+
+  return(%run);
+}
+
+# parse mesh and active cube counts from -info output.
+sub parse_info_output {
+
+  my ($output, $run) = @_;
+
+  $run->{active_cubes} = 0;
+  foreach my $line (@$output) {
+    if ($line =~ /([0-9]+) isosurface triangles\. +([0-9]+) isosurface quadrilaterals/) {
+      $run->{triangles} = $1;
+      $run->{quadrilaterals} = $2;
+    }
+    elsif ($line =~ /([0-9]+) isosurface triangles/) {
+      $run->{triangles} = $1;
+      $run->{quadrilaterals} = 0;
+    }
+    elsif ($line =~ /([0-9]+) isosurface quadrilaterals/) {
+      # Quadrilaterals only.  Each counts as two triangles in throughput.
+      $run->{triangles} = 0;
+      $run->{quadrilaterals} = $1;
+    }
+    elsif ($line =~ /# of cubes with (single|multi) isov: *([0-9]+)/) {
+      $run->{active_cubes} += $2;
+    }
+  }
+}
+
+# compute active cubes/s and triangles/s.
+# Each quadrilateral counts as two triangles.
+sub set_throughput {
+
+  my $run = $_[0];
+  my $seconds = $run->{total_seconds};
+
+  if (!defined($seconds) || $seconds <= 0) { return; }
+
+  my $num_tri = $run->{triangles} + 2*$run->{quadrilaterals};
+  $run->{triangles_per_sec} = $num_tri/$seconds;
+  if ($run->{active_cubes} > 0) {
+    $run->{active_cubes_per_sec} = $run->{active_cubes}/$seconds;
+  }
+}
+
+sub record_results {
+
+  my ($prog, $tdata, $isoval, $run) = @_;
+
+  foreach my $metric (keys %$run) {
+    $results{"$prog $tdata $isoval $metric"} = $run->{$metric};
+  }
+}
+
+sub write_results {
+
+  open(my $out, ">", "$results_file") ||
+    die "Unable to open file $results_file.\n";
+  foreach my $key (sort(keys %results)) {
+    print $out "$key $results{$key}\n";
+  }
+  close($out);
+
+  print "Wrote benchmark results to $results_file.\n";
+}
+
+# compare results with baseline.
+# Report throughput decreases and time or memory increases
+#   larger than threshold.
+sub compare_with_baseline {
+
+  my %baseline;
+
+  open(my $in, "<", "$baseline_file") ||
+    die "Unable to open file $baseline_file.\n";
+  while (my $line = <$in>) {
+    chomp($line);
+    my @field = split(' ', $line);
+    if (scalar(@field) != 5) { next; }
+    $baseline{"$field[0] $field[1] $field[2] $field[3]"} = $field[4];
+  }
+  close($in);
+
+  print "\n";
+  foreach my $key (sort(keys %results)) {
+
+    if (!exists $baseline{$key}) { next; }
+
+    my $old = $baseline{$key};
+    my $new = $results{$key};
+    my $flag_regress = 0;
+
+    if ($key =~ /^(.* )[a-z_]+_per_sec$/) {
+      # Throughput of runs shorter than min_seconds is mostly noise.
+      my $old_seconds = $baseline{"$1total_seconds"};
+      if (defined($old_seconds) && $old_seconds >= $min_seconds &&
+          $new < $old*(1.0-$threshold)) { $flag_regress = 1; }
+    }
+    elsif ($key =~ /seconds$/) {
+      if ($old >= $min_seconds && $new > $old*(1.0+$threshold))
+        { $flag_regress = 1; }
+    }
+    elsif ($key =~ /peak_rss_kb$/) {
+      if ($new > $old*(1.0+$threshold)) { $flag_regress = 1; }
+    }
+    elsif ($key =~ /(triangles|quadrilaterals|active_cubes|calls)$/) {
+      if ($new != $old) {
+        print "Changed: $key $old -> $new\n";
+      }
+    }
+
+    if ($flag_regress) {
+      print "*** Regression: $key $old -> $new ***\n";
+      $found_regression = 1;
+    }
+  }
+
+  print "\n";
+  if ($found_regression) {
+    print "*** Regressions detected. ***\n";
+  }
+  else {
+    print "No regressions detected.\n";
+  }
+}
@@ -65,6 +65,8 @@ void MERGESHARP::dual_contouring
 
 	ISO_MERGE_DATA merge_data(dimension, axis_size);
 
+	isovert.sharp_ind_grid.SetSparse(mergesharp_data.flag_sparse_gcube_index);
+
 	if (mergesharp_data.IsGradientGridSet() &&
 		(mergesharp_data.flag_grad2hermite || mergesharp_data.flag_grad2hermiteI)) {
 			const GRADIENT_COORD_TYPE max_small_magnitude 
@@ -96,13 +98,15 @@ void MERGESHARP::dual_contouring
 
 			if (mergesharp_data.flag_merge_sharp) {
 				dual_contouring_merge_sharp_from_grad
-					(mergesharp_data.ScalarGrid(), mergesharp_data.GradientGrid(),
+					(mergesharp_data.ScalarGrid(), mergesharp_data.MinMaxRegions(),
+					mergesharp_data.GradientGrid(),
 					isovalue, mergesharp_data, dual_isosurface, isovert,
 					mergesharp_info);
 			}
 			else {
 				dual_contouring_sharp_from_grad
-					(mergesharp_data.ScalarGrid(), mergesharp_data.GradientGrid(),
+					(mergesharp_data.ScalarGrid(), mergesharp_data.MinMaxRegions(),
+					mergesharp_data.GradientGrid(),
 					isovalue, mergesharp_data, dual_isosurface,
 					isovert, mergesharp_info);
 			}
@@ -329,6 +333,7 @@ void MERGESHARP::dual_contouring_centroid_multiv
 // Use gradients to place isosurface vertices on sharp features. 
 void MERGESHARP::dual_contouring_sharp_from_grad
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const SHARPISO_MINMAX_REGIONS & minmax_regions,
 	const GRADIENT_GRID_BASE & gradient_grid,
 	const SCALAR_TYPE isovalue,
 	const MERGESHARP_PARAM & mergesharp_param,
@@ -351,8 +356,9 @@ void MERGESHARP::dual_contouring_sharp_from_grad
 	t0 = clock();
 
 	compute_dual_isovert
-		(scalar_grid, gradient_grid, isovalue, mergesharp_param, 
-		mergesharp_param.vertex_position_method, isovert, isovert_info);
+		(scalar_grid, minmax_regions, gradient_grid, isovalue, 
+		mergesharp_param, mergesharp_param.vertex_position_method, 
+		isovert, isovert_info);
 
 	select_non_smooth(isovert);
 
@@ -581,12 +587,33 @@ void MERGESHARP::dual_contouring_extract_isopoly_multi
 */
 void MERGESHARP::dual_contouring_merge_sharp_from_grad
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const SHARPISO_MINMAX_REGIONS & minmax_regions,
 	const GRADIENT_GRID_BASE & gradient_grid,
 	const SCALAR_TYPE isovalue,
 	const MERGESHARP_PARAM & mergesharp_param,
 	DUAL_ISOSURFACE & dual_isosurface,
 	ISOVERT & isovert,
 	MERGESHARP_INFO & mergesharp_info)
+{
+	dual_contouring_merge_sharp_from_grad
+		(scalar_grid, minmax_regions, gradient_grid, isovalue, mergesharp_param,
+		MERGE_SHARP_HOOKS(), dual_isosurface, isovert, mergesharp_info);
+}
+
+
+// Extract dual contouring isosurface by merging grid cubes
+//   around sharp vertices.
+// Call hooks to fix cubes and select output quadrilaterals.
+void MERGESHARP::dual_contouring_merge_sharp_from_grad
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const SHARPISO_MINMAX_REGIONS & minmax_regions,
+	const GRADIENT_GRID_BASE & gradient_grid,
+	const SCALAR_TYPE isovalue,
+	const MERGESHARP_PARAM & mergesharp_param,
+	const MERGE_SHARP_HOOKS & hooks,
+	DUAL_ISOSURFACE & dual_isosurface,
+	ISOVERT & isovert,
+	MERGESHARP_INFO & mergesharp_info)
 {
 	ISOVERT_INFO isovert_info;
 	PROCEDURE_ERROR error("dual_contouring");
@@ -603,8 +630,12 @@ void MERGESHARP::dual_contouring_merge_sharp_from_grad
 	t0 = clock();
 
 	compute_dual_isovert
-		(scalar_grid, gradient_grid, isovalue, mergesharp_param, 
-		mergesharp_param.vertex_position_method, isovert, isovert_info);
+		(scalar_grid, minmax_regions, gradient_grid, isovalue, 
+		mergesharp_param, mergesharp_param.vertex_position_method, 
+		isovert, isovert_info);
+
+	if (hooks.fix_gcubes && mergesharp_param.allow_multiple_iso_vertices)
+		{ hooks.fix_gcubes(isovert); }
 
 	t1 = clock();
 
@@ -651,7 +682,7 @@ void MERGESHARP::dual_contouring_merge_sharp_from_grad
 
 	mergesharp_info.time.merge_sharp = 0;
 	dual_contouring_merge_sharp
-		(scalar_grid, isovalue, mergesharp_param, dual_isosurface, isovert,
+		(scalar_grid, isovalue, mergesharp_param, hooks, dual_isosurface, isovert,
 		mergesharp_info, isovert_info);
 
 	t4 = clock();
@@ -738,6 +769,25 @@ void MERGESHARP::dual_contouring_merge_sharp
 	ISOVERT & isovert,
 	MERGESHARP_INFO & mergesharp_info,
 	ISOVERT_INFO & isovert_info)
+{
+	dual_contouring_merge_sharp
+		(scalar_grid, isovalue, mergesharp_param, MERGE_SHARP_HOOKS(),
+		dual_isosurface, isovert, mergesharp_info, isovert_info);
+}
+
+// Extract dual contouring isosurface by merging grid cubes
+//   around sharp vertices.
+// Call hooks to store merged cubes and select output quadrilaterals.
+// @pre isovert contains isovert locations.
+void MERGESHARP::dual_contouring_merge_sharp
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const SCALAR_TYPE isovalue,
+	const MERGESHARP_PARAM & mergesharp_param,
+	const MERGE_SHARP_HOOKS & hooks,
+	DUAL_ISOSURFACE & dual_isosurface,
+	ISOVERT & isovert,
+	MERGESHARP_INFO & mergesharp_info,
+	ISOVERT_INFO & isovert_info)
 {
 	const int dimension = scalar_grid.Dimension();
 	const bool flag_separate_neg = mergesharp_param.flag_separate_neg;
@@ -763,6 +813,13 @@ void MERGESHARP::dual_contouring_merge_sharp
 		for (NUM_TYPE i = 0; i < isovert.gcube_list.size(); i++) 
 		{ cube_list[i] = isovert.gcube_list[i].cube_index; }
 
+		std::vector<GRID_CUBE_FLAG> select_flag;
+		if (hooks.store_gcubes) {
+			select_flag.resize(num_gcube);
+			for (NUM_TYPE i = 0; i < num_gcube; i++)
+			{ select_flag[i] = isovert.gcube_list.Flag(i); }
+		}
+
 		bool flag_separate_opposite(true);
 		IJKDUALTABLE::ISODUAL_CUBE_TABLE 
 			isodual_table(dimension, flag_separate_neg, flag_separate_opposite);
@@ -771,7 +828,8 @@ void MERGESHARP::dual_contouring_merge_sharp
 		std::vector<FACET_VERTEX_INDEX> facet_vertex;
 
 		extract_dual_isopoly
-			(scalar_grid, isovalue, isoquad_cube, facet_vertex, mergesharp_info);
+			(scalar_grid, isovalue, mergesharp_param.num_threads,
+			isoquad_cube, facet_vertex, mergesharp_info);
 
 		map_isopoly_vert(isovert, isoquad_cube);
 		t1 = clock();
@@ -810,9 +868,37 @@ void MERGESHARP::dual_contouring_merge_sharp
 
 		store_table_index(table_index, isovert.gcube_list);
 
+		// Decide which quadrilaterals to output before vertices are merged.
+		const NUM_TYPE num_quad = quad_vert.size()/NUM_VERT_PER_QUAD;
+		std::vector<bool> flag_output_quad;
+		if (hooks.output_quad) {
+			flag_output_quad.resize(num_quad);
+			for (NUM_TYPE j = 0; j < num_quad; j++) {
+				flag_output_quad[j] = 
+					hooks.output_quad(iso_vlist, &(quad_vert[j*NUM_VERT_PER_QUAD]));
+			}
+		}
+
+		std::vector<VERTEX_INDEX> gcube_map(num_gcube);
 		merge_sharp_iso_vertices_multi
 			(scalar_grid, isodual_table, isovalue, iso_vlist, isovert, 
-			mergesharp_param, quad_vert, mergesharp_info.sharpiso);
+			mergesharp_param, quad_vert, gcube_map, mergesharp_info.sharpiso);
+
+		if (hooks.store_gcubes) 
+		{ hooks.store_gcubes(isovert, select_flag, gcube_map); }
+
+		if (hooks.output_quad) {
+			NUM_TYPE num_output_quad = 0;
+			for (NUM_TYPE j = 0; j < num_quad; j++) {
+				if (flag_output_quad[j]) {
+					std::copy(quad_vert.begin()+j*NUM_VERT_PER_QUAD, 
+						quad_vert.begin()+(j+1)*NUM_VERT_PER_QUAD,
+						quad_vert.begin()+num_output_quad*NUM_VERT_PER_QUAD);
+					num_output_quad++;
+				}
+			}
+			quad_vert.resize(num_output_quad*NUM_VERT_PER_QUAD);
+		}
 
 		IJK::get_non_degenerate_quad_btlr
 			(quad_vert, dual_isosurface.tri_vert, dual_isosurface.quad_vert);
@@ -823,7 +909,9 @@ void MERGESHARP::dual_contouring_merge_sharp
 	}
 	else {
 
-		extract_dual_isopoly(scalar_grid, isovalue, quad_vert, mergesharp_info);
+		extract_dual_isopoly
+			(scalar_grid, isovalue, mergesharp_param.num_threads,
+			quad_vert, mergesharp_info);
 
 		map_isopoly_vert(isovert, quad_vert);
 		t1 = clock();
@@ -30,6 +30,7 @@
 #ifndef _MERGESHARP_
 #define _MERGESHARP_
 
+#include <functional>
 #include <string>
 
 #include "ijk.txx"
@@ -56,7 +57,8 @@ namespace MERGESHARP {
   /// Dual Contouring Algorithm using only scalar data.
   /// Represents each grid edge by a single integer.
   /// @param merge_data = Data structure for merging edges.
-  /// Requires memory of size(MERGE_INDEX) for each grid edge.
+  /// Requires memory of size(MERGE_INDEX) for each grid edge
+  ///   only if the isosurface intersects a large fraction of grid edges.
   void dual_contouring
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const SCALAR_TYPE isovalue,
@@ -68,7 +70,8 @@ namespace MERGESHARP {
   /// Dual contouring algorithm.
   /// Position isosurface vertices at cube centers.
   /// @param merge_data = Data structure for merging edges.
-  /// Requires memory of size(MERGE_INDEX) for each grid edge.
+  /// Requires memory of size(MERGE_INDEX) for each grid edge
+  ///   only if the isosurface intersects a large fraction of grid edges.
   void dual_contouring_cube_center
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const SCALAR_TYPE isovalue,
@@ -110,6 +113,7 @@ namespace MERGESHARP {
   /// Use gradients to place isosurface vertices on sharp features. 
   void dual_contouring_sharp_from_grad
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SHARPISO_MINMAX_REGIONS & minmax_regions,
    const GRADIENT_GRID_BASE & gradient_grid,
    const SCALAR_TYPE isovalue,
    const MERGESHARP_PARAM & mergesharp_param,
@@ -168,6 +172,34 @@ namespace MERGESHARP {
   // MERGE SHARP
   // **************************************************
 
+  /// Steps added to dual_contouring_merge_sharp by routines
+  ///   which construct only part of the isosurface, e.g., one slab.
+  /// Empty functions are not called.
+  /// Called only if multiple isosurface vertices per cube are allowed.
+  class MERGE_SHARP_HOOKS {
+
+  public:
+
+    /// Set selection and merge of grid cubes fixed by a previous call.
+    /// Called after isosurface vertices are positioned
+    ///   and before sharp cubes are selected.
+    std::function<void(ISOVERT & isovert)> fix_gcubes;
+
+    /// Return true if isosurface quadrilateral should be output.
+    /// @param quad_vert[] Quadrilateral vertices before merging.
+    ///   Indices into iso_vlist.
+    std::function<bool
+    (const std::vector<DUAL_ISOVERT> & iso_vlist,
+     const VERTEX_INDEX quad_vert[])> output_quad;
+
+    /// Store selection and merge of grid cubes.
+    /// @param select_flag[i] Flag of isovert.gcube_list[i] after selection.
+    /// @param gcube_map[i] Grid cube which isovert.gcube_list[i] merges into.
+    std::function<void
+    (const ISOVERT & isovert, const std::vector<GRID_CUBE_FLAG> & select_flag,
+     const std::vector<VERTEX_INDEX> & gcube_map)> store_gcubes;
+  };
+
   /// Extract dual contouring isosurface by merging grid cubes
   ///   around sharp vertices.
   /// Dual Contouring algorithm for sharp isosurface features.
@@ -177,6 +209,7 @@ namespace MERGESHARP {
   /// Use gradients to place isosurface vertices on sharp features. 
   void dual_contouring_merge_sharp_from_grad
     (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+     const SHARPISO_MINMAX_REGIONS & minmax_regions,
      const GRADIENT_GRID_BASE & gradient_grid,
      const SCALAR_TYPE isovalue,
      const MERGESHARP_PARAM & mergesharp_param,
@@ -184,6 +217,21 @@ namespace MERGESHARP {
      ISOVERT & isovert,
      MERGESHARP_INFO & mergesharp_info);
 
+  /// Extract dual contouring isosurface by merging grid cubes
+  ///   around sharp vertices.
+  /// Use gradients to place isosurface vertices on sharp features. 
+  /// Call hooks to fix cubes and select output quadrilaterals.
+  void dual_contouring_merge_sharp_from_grad
+    (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+     const SHARPISO_MINMAX_REGIONS & minmax_regions,
+     const GRADIENT_GRID_BASE & gradient_grid,
+     const SCALAR_TYPE isovalue,
+     const MERGESHARP_PARAM & mergesharp_param,
+     const MERGE_SHARP_HOOKS & hooks,
+     DUAL_ISOSURFACE & dual_isosurface,
+     ISOVERT & isovert,
+     MERGESHARP_INFO & mergesharp_info);
+
   /// Extract dual contouring isosurface by merging grid cubes
   ///   around sharp vertices.
   /// Returns list of isosurface triangle and quad vertices
@@ -213,6 +261,20 @@ namespace MERGESHARP {
    ISOVERT & isovert,
    MERGESHARP_INFO & mergesharp_info,
    ISOVERT_INFO & isovert_info);
+
+  /// Extract dual contouring isosurface by merging grid cubes
+  ///   around sharp vertices.
+  /// Call hooks to store merged cubes and select output quadrilaterals.
+  /// @pre isovert contains isovert locations.
+  void dual_contouring_merge_sharp
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SCALAR_TYPE isovalue,
+   const MERGESHARP_PARAM & mergesharp_param,
+   const MERGE_SHARP_HOOKS & hooks,
+   DUAL_ISOSURFACE & dual_isosurface,
+   ISOVERT & isovert,
+   MERGESHARP_INFO & mergesharp_info,
+   ISOVERT_INFO & isovert_info);
 }
 
 #endif
@@ -24,6 +24,7 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <string>
 
@@ -33,6 +34,7 @@
 #include "ijkgrid_nrrd.txx"
 #include "ijkIO.txx"
 #include "ijkmesh.txx"
+#include "ijkprofile.txx"
 #include "ijkstring.txx"
 
 using namespace IJK;
@@ -67,7 +69,7 @@ namespace {
     USE_LINDSTROM_PARAM,
     USE_LINDSTROM2_PARAM,
     USE_LINDSTROM_FAST,
-    NO_LINDSTROM_PARAM,
+    NO_LINDSTROM_PARAM, EIGEN_SVD_PARAM, BATCH_SVD_PARAM,
     SINGLE_ISOV_PARAM, MULTI_ISOV_PARAM,
     SPLIT_NON_MANIFOLD_PARAM, SELECT_SPLIT_PARAM,
     SEP_NEG_PARAM, SEP_POS_PARAM, RESOLVE_AMBIG_PARAM,
@@ -77,10 +79,14 @@ namespace {
     KEEPV_PARAM,
     MINC_PARAM, MAXC_PARAM,
 	MAP_EXTENDED,
-    HELP_PARAM, OFF_PARAM, IV_PARAM, OUTPUT_PARAM_PARAM,
+    THREADS_PARAM, ISOVALUE_THREADS_PARAM, MINMAX_REGION_PARAM,
+    COMPUTE_GRADIENT_PARAM, MIN_GRADIENT_MAG_PARAM,
+    SPARSE_INDEX_PARAM, DENSE_INDEX_PARAM, SLAB_PARAM,
+    HELP_PARAM, OFF_PARAM, IV_PARAM, PLY_PARAM, BIN_PARAM,
+    OUTPUT_PARAM_PARAM,
     OUTPUT_FILENAME_PARAM, STDOUT_PARAM,
     NOWRITE_PARAM, OUTPUT_INFO_PARAM, WRITE_ISOV_INFO_PARAM, SILENT_PARAM,
-    TIME_PARAM, UNKNOWN_PARAM} PARAMETER;
+    TIME_PARAM, TIME_JSON_PARAM, UNKNOWN_PARAM} PARAMETER;
   const char * parameter_string[] =
     { "-subsample",
       "-gradient", "-normal", "-position", "-pos", "-trimesh", "-uniform_trimesh",
@@ -96,6 +102,7 @@ namespace {
       "-dist2center", "-dist2centroid",
       "-Linf", "-no_Linf",
       "-lindstrom", "-lindstrom2","-lindstrom_fast", "-no_lindstrom",
+      "-eigen_svd", "-batch_svd",
       "-single_isov", "-multi_isov", "-split_non_manifold", "-select_split",
       "-sep_neg", "-sep_pos", "-resolve_ambig", 
       "-check_disk", "-no_check_disk",
@@ -104,9 +111,13 @@ namespace {
       "-keepv",
       "-minc", "-maxc",
 	  "-map_extended",
-      "-help", "-off", "-iv", "-out_param",
+      "-threads", "-isovalue_threads", "-minmax_region",
+      "-compute_gradient", "-min_gradient_mag",
+      "-sparse_index", "-dense_index", "-slab",
+      "-help", "-off", "-iv", "-ply", "-bin", "-out_param",
       "-o", "-stdout",
-      "-nowrite", "-info", "-write_isov_info", "-s", "-time", "-unknown"};
+      "-nowrite", "-info", "-write_isov_info", "-s", "-time", "-time_json",
+      "-unknown"};
 
   PARAMETER get_parameter_token(const char * s)
   // convert string s into parameter token
@@ -275,6 +286,14 @@ namespace {
       input_info.use_lindstrom_fast = false;
       break;
 
+    case EIGEN_SVD_PARAM:
+      input_info.use_eigen_svd = true;
+      break;
+
+    case BATCH_SVD_PARAM:
+      input_info.use_eigen_svd = false;
+      break;
+
     case SINGLE_ISOV_PARAM:
       input_info.allow_multiple_iso_vertices = false;
       break;
@@ -394,6 +413,14 @@ namespace {
       input_info.output_format = IV;
       break;
 
+    case PLY_PARAM:
+      input_info.output_format = PLY;
+      break;
+
+    case BIN_PARAM:
+      input_info.output_format = BINARY_MESH;
+      break;
+
     case KEEPV_PARAM:
       input_info.flag_delete_isolated_vertices = false;
       break;
@@ -426,6 +453,18 @@ namespace {
       input_info.report_time_flag = true;
       break;
 
+    case COMPUTE_GRADIENT_PARAM:
+      input_info.flag_compute_gradient = true;
+      break;
+
+    case SPARSE_INDEX_PARAM:
+      input_info.flag_sparse_gcube_index = true;
+      break;
+
+    case DENSE_INDEX_PARAM:
+      input_info.flag_sparse_gcube_index = false;
+      break;
+
     default:
       return(false);
     }
@@ -518,10 +557,40 @@ namespace {
         (option_string, value_string, input_info.maxc);
 	  break;
 
+    case THREADS_PARAM:
+      input_info.num_threads =
+        get_option_int(option_string, value_string);
+      break;
+
+    case ISOVALUE_THREADS_PARAM:
+      input_info.num_isovalue_threads =
+        get_option_int(option_string, value_string);
+      break;
+
+    case MINMAX_REGION_PARAM:
+      input_info.minmax_region_edge_length =
+        get_option_int(option_string, value_string);
+      break;
+
+    case SLAB_PARAM:
+      input_info.slab_thickness =
+        get_option_int(option_string, value_string);
+      break;
+
+    case MIN_GRADIENT_MAG_PARAM:
+      input_info.min_gradient_mag =
+        get_option_float(option_string, value_string);
+      break;
+
     case OUTPUT_FILENAME_PARAM:
       input_info.output_filename = value_string;
       break;
 
+    case TIME_JSON_PARAM:
+      input_info.time_json_filename = value_string;
+      input_info.report_time_flag = true;
+      break;
+
     default:
       return(false);
     }
@@ -718,6 +787,58 @@ void MERGESHARP::check_input_info(const INPUT_INFO & input_info)
       exit(560);
     }
   }
+
+  if (input_info.num_threads < 1) {
+    cerr << "Error.  Illegal -threads <N> parameter. Integer <N> must be positive." << endl;
+    exit(561);
+  }
+
+  if (input_info.num_isovalue_threads < 1) {
+    cerr << "Error.  Illegal -isovalue_threads <N> parameter. Integer <N> must be positive." << endl;
+    exit(561);
+  }
+
+  if (input_info.minmax_region_edge_length < 0) {
+    cerr << "Error.  Illegal -minmax_region <L> parameter. Integer <L> must be non-negative." << endl;
+    exit(562);
+  }
+
+  if (input_info.flag_compute_gradient && 
+      input_info.gradient_filename != NULL) {
+    cerr << "Error.  Can't use both -compute_gradient and -gradient parameters."
+         << endl;
+    exit(564);
+  }
+
+  if (input_info.min_gradient_mag < 0) {
+    cerr << "Error.  Illegal -min_gradient_mag {M} parameter. {M} must be non-negative." << endl;
+    exit(564);
+  }
+
+  if (input_info.slab_thickness < 0) {
+    cerr << "Error.  Illegal -slab <Z> parameter. Integer <Z> must be non-negative." << endl;
+    exit(563);
+  }
+
+  if (input_info.slab_thickness > 0) {
+    if (input_info.flag_subsample || input_info.flag_supersample) {
+      cerr << "Error.  Can't use -slab with -subsample or -supersample."
+           << endl;
+      exit(563);
+    }
+
+    if (!input_info.GradientsRequired() || !input_info.flag_merge_sharp ||
+        input_info.flag_grad2hermite || input_info.flag_grad2hermiteI) {
+      cerr << "Error.  -slab requires merging around sharp vertices"
+           << " located using gradients." << endl;
+      exit(563);
+    }
+
+    if (!input_info.allow_multiple_iso_vertices) {
+      cerr << "Error.  Can't use -slab with -single_isov." << endl;
+      exit(563);
+    }
+  }
 }
 
 // Parse the command line.
@@ -751,7 +872,7 @@ void MERGESHARP::parse_command_line
 // Check input information/flags.
 bool MERGESHARP::check_input
 (const INPUT_INFO & input_info,
- const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const SHARPISO_GRID & scalar_grid,
  IJK::ERROR & error)
 {
   // Construct isosurface
@@ -767,6 +888,29 @@ bool MERGESHARP::check_input
     return(false);
   }
 
+  if (input_info.flag_supersample &&
+      std::numeric_limits<GRID_SCALAR_TYPE>::is_integer) {
+    error.AddMessage
+      ("Error.  Supersampling requires a scalar grid with float values.");
+    error.AddMessage
+      ("  mergesharp_uint8 and mergesharp_uint16 store 8-bit and 16-bit");
+    error.AddMessage
+      ("  scalar grid values.  Use mergesharp for supersampling.");
+    return(false);
+  }
+
+  // Grid edges are indexed by dimension*iv + edge_direction.
+  const double num_grid_edges =
+    double(scalar_grid.NumVertices())*scalar_grid.Dimension();
+  if (num_grid_edges > double(std::numeric_limits<VERTEX_INDEX>::max())) {
+    error.AddMessage
+      ("Error.  Grid is too large for ", 8*sizeof(VERTEX_INDEX),
+       "-bit vertex indices.");
+    error.AddMessage
+      ("  Rebuild mergesharp with INDEX_TYPE=int64.");
+    return(false);
+  }
+
   return(true);
 }
 
@@ -783,7 +927,20 @@ void MERGESHARP::read_nrrd_file
   IJK::GRID_NRRD_IN<int, int> nrrd_in;
   IJK::NRRD_DATA<int,int> nrrd_header;
 
-  nrrd_in.ReadScalarGrid(input_filename, scalar_grid, nrrd_header, error);
+  try {
+    nrrd_in.ReadScalarGrid(input_filename, scalar_grid, nrrd_header, error);
+  }
+  catch (IJK::ERROR & read_error) {
+    if (std::numeric_limits<GRID_SCALAR_TYPE>::is_integer) {
+      // Each mergesharp binary stores one grid scalar type.
+      read_error.AddMessage
+        ("  mergesharp_uint8 reads only 8-bit unsigned volumes.");
+      read_error.AddMessage
+        ("  mergesharp_uint16 reads only 8-bit and 16-bit unsigned volumes.");
+      read_error.AddMessage("  mergesharp reads all volumes.");
+    }
+    throw read_error;
+  }
   if (nrrd_in.ReadFailed()) { 
     char *err = biffGetDone(NRRD);
     cerr << "Error reading: " << input_filename << endl;
@@ -849,6 +1006,131 @@ void MERGESHARP::read_nrrd_file
   io_time.read_nrrd_time = wall_time.getElapsed();
 }
 
+void MERGESHARP::read_nrrd_file
+(const char * input_filename, SHARPISO_SCALAR_GRID & scalar_grid,
+ SHARPISO_SCALAR_GRID_NRRD_MAP & mapped_scalar_grid,
+ NRRD_INFO & nrrd_info, IO_TIME & io_time)
+{
+  ELAPSED_TIME wall_time;
+  bool flag_mapped = false;
+
+  try {
+    flag_mapped = mapped_scalar_grid.Map(input_filename);
+  }
+  catch (IJK::ERROR & error) {
+    // Map throws only if the grid is too large for the index type.
+    error.AddMessage("  Rebuild mergesharp with INDEX_TYPE=int64.");
+    throw error;
+  }
+
+  if (flag_mapped) {
+
+    std::vector<COORD_TYPE> grid_spacing;
+    mapped_scalar_grid.GetSpacing(grid_spacing);
+
+    nrrd_info.dimension = mapped_scalar_grid.Dimension();
+    for (int d = 0; d < mapped_scalar_grid.Dimension(); d++) {
+      nrrd_info.grid_spacing.push_back(grid_spacing[d]); 
+      mapped_scalar_grid.SetSpacing(d, grid_spacing[d]);
+    };
+  }
+  else {
+    read_nrrd_file(input_filename, scalar_grid, nrrd_info);
+  }
+
+  io_time.read_nrrd_time = wall_time.getElapsed();
+}
+
+void MERGESHARP::read_nrrd_file
+(const char * input_filename, GRADIENT_GRID & gradient_grid,
+ GRADIENT_GRID_NRRD_MAP & mapped_gradient_grid,
+ NRRD_INFO & nrrd_info)
+{
+  bool flag_mapped = false;
+
+  try {
+    flag_mapped = mapped_gradient_grid.Map(input_filename);
+  }
+  catch (IJK::ERROR & error) {
+    // Map throws only if the grid is too large for the index type.
+    error.AddMessage("  Rebuild mergesharp with INDEX_TYPE=int64.");
+    throw error;
+  }
+
+  if (flag_mapped) {
+
+    std::vector<COORD_TYPE> grid_spacing;
+    mapped_gradient_grid.GetSpacing(grid_spacing);
+
+    nrrd_info.dimension = mapped_gradient_grid.Dimension();
+    for (int d = 0; d < mapped_gradient_grid.Dimension(); d++) {
+      nrrd_info.grid_spacing.push_back(grid_spacing[d+1]); 
+      mapped_gradient_grid.SetSpacing(d, grid_spacing[d+1]);
+    };
+  }
+  else {
+    read_nrrd_file(input_filename, gradient_grid, nrrd_info);
+  }
+}
+
+bool MERGESHARP::map_nrrd_slab
+(const char * input_filename, 
+ const AXIS_SIZE_TYPE z0, const AXIS_SIZE_TYPE z1,
+ SHARPISO_SCALAR_GRID_NRRD_MAP & mapped_scalar_slab,
+ NRRD_INFO & nrrd_info)
+{
+  try {
+    if (!mapped_scalar_slab.MapSlab(input_filename, z0, z1)) 
+      { return(false); }
+  }
+  catch (IJK::ERROR & error) {
+    // MapSlab throws only if the grid is too large for the index type.
+    error.AddMessage("  Rebuild mergesharp with INDEX_TYPE=int64.");
+    throw error;
+  }
+
+  std::vector<COORD_TYPE> grid_spacing;
+  mapped_scalar_slab.GetSpacing(grid_spacing);
+
+  nrrd_info.grid_spacing.clear();
+  nrrd_info.dimension = mapped_scalar_slab.Dimension();
+  for (int d = 0; d < mapped_scalar_slab.Dimension(); d++) {
+    nrrd_info.grid_spacing.push_back(grid_spacing[d]); 
+    mapped_scalar_slab.SetSpacing(d, grid_spacing[d]);
+  };
+
+  return(true);
+}
+
+bool MERGESHARP::map_nrrd_slab
+(const char * input_filename, 
+ const AXIS_SIZE_TYPE z0, const AXIS_SIZE_TYPE z1,
+ GRADIENT_GRID_NRRD_MAP & mapped_gradient_slab,
+ NRRD_INFO & nrrd_info)
+{
+  try {
+    if (!mapped_gradient_slab.MapSlab(input_filename, z0, z1)) 
+      { return(false); }
+  }
+  catch (IJK::ERROR & error) {
+    // MapSlab throws only if the grid is too large for the index type.
+    error.AddMessage("  Rebuild mergesharp with INDEX_TYPE=int64.");
+    throw error;
+  }
+
+  std::vector<COORD_TYPE> grid_spacing;
+  mapped_gradient_slab.GetSpacing(grid_spacing);
+
+  nrrd_info.grid_spacing.clear();
+  nrrd_info.dimension = mapped_gradient_slab.Dimension();
+  for (int d = 0; d < mapped_gradient_slab.Dimension(); d++) {
+    nrrd_info.grid_spacing.push_back(grid_spacing[d+1]); 
+    mapped_gradient_slab.SetSpacing(d, grid_spacing[d+1]);
+  };
+
+  return(true);
+}
+
 // **************************************************
 // READ OFF FILE
 // **************************************************
@@ -937,7 +1219,12 @@ void MERGESHARP::write_dual_mesh3D
     throw error;
   }
 
-  output_file.open(output_filename.c_str(), ios::out);
+  if (output_info.output_format == PLY ||
+      output_info.output_format == BINARY_MESH)
+    { output_file.open(output_filename.c_str(), ios::out | ios::binary); }
+  else
+    { output_file.open(output_filename.c_str(), ios::out); }
+
   if (!output_file.good()) {
     cerr << "Unable to open output file " << output_filename << "." << endl;
     exit(65);
@@ -946,12 +1233,12 @@ void MERGESHARP::write_dual_mesh3D
   if (flag_reorder_quad_vertices) {
     std::vector<VERTEX_INDEX> quad_vert2(quad_vert);
     IJK::reorder_quad_vertices(quad_vert2);
-    ijkoutOFF(output_file, DIM3, vertex_coord, 
-              tri_vert, NUM_VERT_PER_TRI, quad_vert2, NUM_VERT_PER_QUAD);
+    write_dual_mesh3D(output_info, output_file, vertex_coord, 
+                      tri_vert, quad_vert2);
   }
   else {
-    ijkoutOFF(output_file, DIM3, vertex_coord, 
-              tri_vert, NUM_VERT_PER_TRI, quad_vert, NUM_VERT_PER_QUAD);
+    write_dual_mesh3D(output_info, output_file, vertex_coord, 
+                      tri_vert, quad_vert);
   }
 
   output_file.close();
@@ -960,6 +1247,34 @@ void MERGESHARP::write_dual_mesh3D
     cout << "Wrote output to file: " << output_filename << endl;
 }
 
+// Write dual mesh to output stream in output_info.output_format.
+// Triangles and quadrilaterals are written as separate polygons.
+// Open Inventor output is not supported; write OFF instead.
+void MERGESHARP::write_dual_mesh3D
+(const OUTPUT_INFO & output_info, std::ostream & out,
+ const std::vector<COORD_TYPE> & vertex_coord, 
+ const std::vector<VERTEX_INDEX> & tri_vert,
+ const std::vector<VERTEX_INDEX> & quad_vert)
+{
+  switch (output_info.output_format) {
+
+  case PLY:
+    ijkoutPLYbinary(out, DIM3, vertex_coord, 
+                    tri_vert, NUM_VERT_PER_TRI, quad_vert, NUM_VERT_PER_QUAD);
+    break;
+
+  case BINARY_MESH:
+    ijkoutBinaryMesh(out, DIM3, vertex_coord, 
+                     tri_vert, NUM_VERT_PER_TRI, quad_vert, NUM_VERT_PER_QUAD);
+    break;
+
+  default:
+    ijkoutOFF(out, DIM3, vertex_coord, 
+              tri_vert, NUM_VERT_PER_TRI, quad_vert, NUM_VERT_PER_QUAD);
+    break;
+  }
+}
+
 // Write dual mesh.
 // Time write.
 void MERGESHARP::write_dual_mesh3D
@@ -1121,8 +1436,8 @@ void MERGESHARP::report_num_cubes
 (const SHARPISO_GRID & full_scalar_grid, const INPUT_INFO & input_info,
  const MERGESHARP_DATA & mergesharp_data)
 {
-  const int num_grid_cubes = full_scalar_grid.ComputeNumCubes();
-  const int num_cubes_in_mergesharp_data =
+  const NUM_TYPE num_grid_cubes = full_scalar_grid.ComputeNumCubes();
+  const NUM_TYPE num_cubes_in_mergesharp_data =
     mergesharp_data.ScalarGrid().ComputeNumCubes();
 
   if (!input_info.use_stdout && !input_info.flag_silent) {
@@ -1399,6 +1714,13 @@ void MERGESHARP::report_iso_info3D
         }
       }
 
+      if (output_info.slab_thickness > 0) {
+        cout << "  # of open isosurface edges: "
+             << mergesharp_info.sharpiso.num_open_edges << endl;
+        cout << "  # of non-manifold isosurface edges: "
+             << mergesharp_info.sharpiso.num_non_manifold_edges << endl;
+      }
+
 
       cout << endl;
     }
@@ -1483,6 +1805,38 @@ void MERGESHARP::report_time
   };
   cout << "Total elapsed time: " << total_elapsed_time
        << " seconds." << endl;
+
+  if (IJK::profiler().IsEnabled()) {
+    cout << "Wall clock time of profiled stages:" << endl;
+    IJK::profiler().Write(cout, "    ");
+  }
+}
+
+// Write wall clock time of profiled stages in JSON format.
+void MERGESHARP::write_time_json
+(const INPUT_INFO & input_info, const double total_elapsed_time)
+{
+  ofstream json_file;
+  IJK::PROCEDURE_ERROR error("write_time_json");
+
+  if (input_info.time_json_filename == NULL) {
+    error.AddMessage("Programming error.  Missing JSON file name.");
+    throw error;
+  }
+
+  json_file.open(input_info.time_json_filename, ios::out);
+  if (!json_file.good()) {
+    cerr << "Unable to open time file " << input_info.time_json_filename
+         << "." << endl;
+    exit(96);
+  };
+
+  json_file << "{" << endl;
+  json_file << "\"total_seconds\": " << total_elapsed_time << "," << endl;
+  json_file << "\"profile\": ";
+  IJK::profiler().WriteJSON(json_file);
+  json_file << "}" << endl;
+  json_file.close();
 }
 
 // **************************************************
@@ -1571,6 +1925,7 @@ namespace {
          << endl
          << "              gradES|gradEC}]" << endl;
     cerr << "  [-gradient {gradient_nrrd_filename}]" << endl;
+    cerr << "  [-compute_gradient] [-min_gradient_mag {M}]" << endl;
     cerr << "  [-normal {normal_off_filename}]" << endl;
     cerr << "  [-merge_sharp | -no_merge_sharp] [-merge_linf_th <D>]" << endl;
     cerr << "  [-grad2hermite | -grad2hermiteI]" << endl;
@@ -1579,7 +1934,7 @@ namespace {
     cerr << "  [-max_dist {D}] [-gradS_offset {offset}] [-max_mag {M}] [-snap_dist {D}]" << endl;
     cerr << "  [-max_grad_dist {D}]" << endl;
     cerr << "  [-sharp_edgeI | -interpolate_edgeI]" << endl;
-    cerr << "  [-lindstrom]" << endl;
+    cerr << "  [-lindstrom] [-eigen_svd | -batch_svd]" << endl;
     cerr << "  [-single_isov | -multi_isov | -split_non_manifold]" << endl;
     cerr << "  [-sep_pos | -sep_neg | -resolve_ambig]" << endl;
     cerr << "  [-check_disk | -no_check_disk]" << endl;
@@ -1592,11 +1947,15 @@ namespace {
     cerr << "  [-dist2center | -dist2centroid]" << endl;
     cerr << "  [-no_round | -round <n>]" << endl;
 	cerr << "  [-map_extended]" <<endl;
+    cerr << "  [-threads <N>] [-isovalue_threads <N>] [-minmax_region <L>]"
+         << endl;
+    cerr << "  [-sparse_index | -dense_index] [-slab <Z>]" << endl;
     cerr << "  [-keepv]" << endl;
-    cerr << "  [-off|-iv] [-o {output_filename}] [-stdout]"
+    cerr << "  [-off|-iv|-ply|-bin] [-o {output_filename}] [-stdout]"
          << endl;
     cerr << "  [-s] [-out_param] [-info] [-write_isov_info] [-nowrite] [-time]"
          << endl;
+    cerr << "  [-time_json {json_filename}]" << endl;
     cerr << "  [-help]" << endl;
   }
 
@@ -1688,6 +2047,15 @@ void MERGESHARP::help(const char * command_path)
        << endl;
   cout << "       Use endpoint gradients to compute isosurface-edge intersections." << endl;
   cout << "  -gradient {gradient_nrrd_filename}: Read gradients from gradient nrrd file." << endl;
+  cout << "  -compute_gradient: Compute central difference gradients"
+       << endl
+       << "      from the scalar grid instead of reading a gradient file."
+       << endl
+       << "      Gradients are computed only near cubes containing an isovalue."
+       << endl;
+  cout << "  -min_gradient_mag {M}: Set computed gradients with magnitude"
+       << endl
+       << "      less than M to zero.  (Default 0.0001.)" << endl;
   cout << "  -normal {normal_off_filename}: Read edge-isosurface intersections"
        << endl
        << "      and normals from OFF file normal_off_filename." << endl;
@@ -1731,6 +2099,16 @@ void MERGESHARP::help(const char * command_path)
        << endl;
   cout << "  -lindstrom:   Use Lindstrom's equation to compute sharp point."
        << endl;
+  cout << "  -eigen_svd:   Solve Lindstrom's equation with Eigen's JacobiSVD"
+       << endl
+       << "                one cube at a time.  (Default.)" << endl;
+  cout << "  -batch_svd:   Solve Lindstrom's equation for batches of cubes"
+       << endl
+       << "                with a double precision 3x3 eigen solver."
+       << endl
+       << "                Faster, but vertex positions differ slightly from"
+       << endl
+       << "                -eigen_svd and may change the mesh." << endl;
   cout << "  -allow_conflict:  Allow more than one isosurface vertex in a cube."
        << endl;
   cout << "  -clamp_conflict:  Settle conflicts by clamping to cube."
@@ -1769,12 +2147,56 @@ void MERGESHARP::help(const char * command_path)
   cout << "  -no_check_disk: Skip disk check for merged vertices." << endl;
   cout << "  -trimesh:   Output triangle mesh." << endl;
   cout << "  -map_extended: Use the extended version of mapping to sharp vertices." << endl;
+  cout << "  -threads <N>: Use <N> threads to compute isosurface vertex positions,"
+       << endl
+       << "              to select sharp vertices and to extract isosurface"
+       << endl
+       << "              polygons.  (Default 1.)" << endl;
+  cout << "  -isovalue_threads <N>: Extract up to <N> isovalues concurrently."
+       << endl
+       << "              Isovalues share the input grids and precomputed data."
+       << endl
+       << "              (Default 1.)" << endl;
+  cout << "  -minmax_region <L>: Skip regions of LxLxL grid cubes whose scalar"
+       << endl
+       << "              range does not contain the isovalue. (Default 8.)"
+       << endl
+       << "              If <L> is 0, check every grid cube." << endl;
+  cout << "  -sparse_index: Store indices of active grid cubes in a sorted list."
+       << endl
+       << "              Uses memory proportional to number of active cubes."
+       << endl;
+  cout << "  -dense_index: Store indices of active grid cubes in a grid"
+       << endl
+       << "              with one entry per grid vertex. (Default.)" << endl;
+  cout << "  -slab <Z>: Process grid in z-slabs of <Z> grid cubes." << endl
+       << "              Only one slab and its halo are processed at a time."
+       << endl
+       << "              Nrrd files with raw data are read one slab at a time."
+       << endl
+       << "              Output may differ slightly from the output"
+       << endl
+       << "              for the entire grid and for other values of <Z>."
+       << endl
+       << "              If <Z> is 0, process entire grid. (Default 0.)"
+       << endl;
   cout << "  -off: Output in geomview OFF format. (Default.)" << endl;
+  cout << "  -ply: Output in binary little-endian PLY format." << endl;
+  cout << "  -bin: Output in binary mesh format: 64 byte header followed by"
+       << endl
+       << "        float coordinate and int vertex index arrays." << endl;
   cout << "  -iv: Output in OpenInventor .iv format." << endl;
   cout << "  -o {output_filename}: Write isosurface to file {output_filename}." << endl;
   cout << "  -stdout: Write isosurface to standard output." << endl;
   cout << "  -nowrite: Don't write isosurface." << endl;
   cout << "  -time: Output running time." << endl;
+  cout << "         Also output wall clock time and number of calls"
+       << " of each profiled" << endl;
+  cout << "         stage, and process peak resident set size"
+       << " at the end of the stage." << endl;
+  cout << "  -time_json {json_filename}: Output running time and write"
+       << " profiled stages" << endl;
+  cout << "         to {json_filename} in JSON format.  Implies -time." << endl;
   cout << "  -s: Silent mode." << endl;
   cout << "  -out_param: Print mergesharp parameters." << endl;
   cout << "  -info: Print algorithm information." << endl;
@@ -1801,9 +2223,12 @@ void MERGESHARP::IO_INFO::Init()
   dimension = 3;
   scalar_filename = NULL;
   gradient_filename = NULL;
+  flag_compute_gradient = false;
+  min_gradient_mag = 0.0001;
   output_filename = NULL;
   output_format = OFF;
   report_time_flag = false;
+  time_json_filename = NULL;
   use_stdout = false;
   nowrite_flag = false;
   flag_output_alg_info = false;
@@ -1879,6 +2304,14 @@ namespace {
     case IV:
       ofilename += ".iv";
       break;
+
+    case PLY:
+      ofilename += ".ply";
+      break;
+
+    case BINARY_MESH:
+      ofilename += ".bin";
+      break;
     }
 
     return(ofilename);
@@ -1904,6 +2337,9 @@ void MERGESHARP::set_mergesharp_data
 
   // Set data structures in mergesharp_data
   mergesharp_data.Set(input_info);
+
+  // Min/max regions are shared by all isovalues.
+  mergesharp_data.ComputeMinMaxRegions();
 }
 
 void MERGESHARP::set_input_info
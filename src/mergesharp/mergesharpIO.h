@@ -30,6 +30,7 @@
 #include "mergesharp_datastruct.h"
 #include "sharpiso_eigen.h"
 #include "ijkNrrd.h"
+#include "ijkgrid_nrrd.txx"
 
 namespace MERGESHARP {
 
@@ -39,6 +40,14 @@ namespace MERGESHARP {
 
   typedef float COLOR_TYPE;           /// Color type.
 
+  /// Scalar grid mapped from a nrrd file with raw data.
+  typedef IJK::SCALAR_GRID_NRRD_MAP<SHARPISO_SCALAR_GRID_BASE>
+    SHARPISO_SCALAR_GRID_NRRD_MAP;
+
+  /// Gradient grid mapped from a nrrd file with raw data.
+  typedef IJK::VECTOR_GRID_NRRD_MAP<GRADIENT_GRID_BASE>
+    GRADIENT_GRID_NRRD_MAP;
+
   // **************************************************
   // NRRD INFORMATION
   // **************************************************
@@ -62,7 +71,7 @@ namespace MERGESHARP {
   // **************************************************
 
   ///  Output format.
-  typedef enum { OFF, IV } OUTPUT_FORMAT;
+  typedef enum { OFF, IV, PLY, BINARY_MESH } OUTPUT_FORMAT;
 
   // **************************************************
   // IO INFORMATION
@@ -80,12 +89,21 @@ namespace MERGESHARP {
     const char * scalar_filename;       ///< Input scalar file name.
     const char * gradient_filename;     ///< Input gradient file name.
 
+    /// If true, compute gradients from the scalar grid
+    ///   instead of reading a gradient file.
+    bool flag_compute_gradient;
+
+    /// Computed gradients with magnitude less than min_gradient_mag
+    ///   are set to zero.
+    GRADIENT_COORD_TYPE min_gradient_mag;
+
     /// Input edge-isosurface intersection normal file name.
     const char * normal_filename;       
 
     const char * output_filename;
     OUTPUT_FORMAT output_format;
     bool report_time_flag;
+    const char * time_json_filename;    ///< JSON output of stage times.
     bool use_stdout;
     bool nowrite_flag;
     bool flag_output_alg_info;    ///< Print algorithm information.
@@ -231,7 +249,7 @@ namespace MERGESHARP {
   /// Check input information in input_info
   bool check_input
   (const INPUT_INFO & input_info, 
-   const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SHARPISO_GRID & scalar_grid,
    IJK::ERROR & error);
 
   /// Set input_info defaults.
@@ -260,6 +278,42 @@ namespace MERGESHARP {
   (const char * input_filename, GRADIENT_GRID & gradient_grid, 
    NRRD_INFO & nrrd_info);
 
+  /// Map a nearly raw raster data (nrrd) file with raw float data
+  ///   into mapped_scalar_grid.
+  /// If the file cannot be mapped, read it into scalar_grid.
+  void read_nrrd_file
+  (const char * input_filename, SHARPISO_SCALAR_GRID & scalar_grid, 
+   SHARPISO_SCALAR_GRID_NRRD_MAP & mapped_scalar_grid,
+   NRRD_INFO & nrrd_info, IO_TIME & io_time);
+
+  /// Map a nearly raw raster gradient data (nrrd) file with raw float data
+  ///   into mapped_gradient_grid.
+  /// If the file cannot be mapped, read it into gradient_grid.
+  void read_nrrd_file
+  (const char * input_filename, GRADIENT_GRID & gradient_grid, 
+   GRADIENT_GRID_NRRD_MAP & mapped_gradient_grid,
+   NRRD_INFO & nrrd_info);
+
+  /// Map z-slab of a nearly raw raster data (nrrd) file with raw data
+  ///   into mapped_scalar_slab.
+  /// Slab contains grid vertices with z-coordinates from z0 to z1.
+  /// Return false if the file cannot be mapped.
+  bool map_nrrd_slab
+  (const char * input_filename, 
+   const AXIS_SIZE_TYPE z0, const AXIS_SIZE_TYPE z1,
+   SHARPISO_SCALAR_GRID_NRRD_MAP & mapped_scalar_slab,
+   NRRD_INFO & nrrd_info);
+
+  /// Map z-slab of a nearly raw raster gradient data (nrrd) file 
+  ///   with raw data into mapped_gradient_slab.
+  /// Slab contains grid vertices with z-coordinates from z0 to z1.
+  /// Return false if the file cannot be mapped.
+  bool map_nrrd_slab
+  (const char * input_filename, 
+   const AXIS_SIZE_TYPE z0, const AXIS_SIZE_TYPE z1,
+   GRADIENT_GRID_NRRD_MAP & mapped_gradient_slab,
+   NRRD_INFO & nrrd_info);
+
   // **************************************************
   // READ OFF FILE
   // **************************************************
@@ -320,6 +374,14 @@ namespace MERGESHARP {
    const std::vector<VERTEX_INDEX> & quad_vert,
    const bool flag_reorder_quad_vertices);
 
+  /// Write dual mesh to stream out in output_info.output_format.
+  /// Quadrilateral vertices are written in the given order.
+  void write_dual_mesh3D
+  (const OUTPUT_INFO & output_info, std::ostream & out,
+   const std::vector<COORD_TYPE> & vertex_coord, 
+   const std::vector<VERTEX_INDEX> & tri_vert,
+   const std::vector<VERTEX_INDEX> & quad_vert);
+
 
   // Write dual mesh.
   // Return time to write data.
@@ -401,6 +463,10 @@ namespace MERGESHARP {
   (const INPUT_INFO & input_info, const IO_TIME & io_time, 
    const MERGESHARP_TIME & mergesharp_time, const double total_elapsed_time);
 
+  /// Write total time and profiled stages to input_info.time_json_filename.
+  void write_time_json
+  (const INPUT_INFO & input_info, const double total_elapsed_time);
+
   // **************************************************
   // WRITE ISOSURFACE VERTEX INFORMATION TO FILE
   // **************************************************
@@ -92,7 +92,7 @@ AMBIGUITY_STATUS MERGESHARP::decide_ambiguous_facet
  const MERGESHARP_PARAM & mergesharp_param)
 {
   NUM_TYPE sharp_vertex_location;
-  static COORD_TYPE coord[DIM3];
+  COORD_TYPE coord[DIM3];
 
   if (!is_grid_facet_ambiguous
       (scalar_grid, facet_v0, facet_orth_dir, isovalue)) 
@@ -239,7 +239,7 @@ void MERGESHARP::propagate_sep
  std::vector<AMBIGUITY_TYPE> & facet_ambig_status)
 {
   std::queue<VERTEX_INDEX> facet_list;
-  static COORD_TYPE coord[DIM3];
+  COORD_TYPE coord[DIM3];
 
   for (int i = 0; i < facet_ambig_status.size(); i++) {
     if (facet_ambig_status[i] == SEPARATE_POS ||
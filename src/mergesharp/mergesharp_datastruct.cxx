@@ -20,6 +20,7 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+#include <algorithm>
 #include <assert.h>
 #include <cmath>
 #include <cstddef>
@@ -69,6 +70,10 @@ void MERGESHARP_PARAM::Init()
   flag_store_isovert_info = false;
   flag_grad2hermite = false;
   flag_grad2hermiteI = false;
+  minmax_region_edge_length = 8;
+  flag_sparse_gcube_index = false;
+  slab_thickness = 0;
+  num_isovalue_threads = 1;
 }
 
 /// Set type of interpolation
@@ -141,6 +146,8 @@ bool MERGESHARP_PARAM::NormalsRequired() const
 // Initialize MERGESHARP_DATA
 void MERGESHARP_DATA::Init()
 {
+  scalar_grid_ptr = &scalar_grid;
+  gradient_grid_ptr = &gradient_grid;
   is_scalar_grid_set = false;
   is_gradient_grid_set = false;
   are_edgeI_set = false;
@@ -159,6 +166,7 @@ void MERGESHARP_DATA::CopyScalarGrid
 {
   scalar_grid.Copy(scalar_grid2);
   scalar_grid.SetSpacing(scalar_grid2.SpacingPtrConst());
+  scalar_grid_ptr = &scalar_grid;
   is_scalar_grid_set = true;
 }
 
@@ -168,6 +176,53 @@ void MERGESHARP_DATA::CopyGradientGrid
 {
   gradient_grid.Copy(gradient_grid2);
   gradient_grid.SetSpacing(gradient_grid2.SpacingPtrConst());
+  gradient_grid_ptr = &gradient_grid;
+  is_gradient_grid_set = true;
+}
+
+// Move scalar grid
+void MERGESHARP_DATA::MoveScalarGrid
+(SHARPISO_SCALAR_GRID & scalar_grid2)
+{
+  IJK::ARRAY<COORD_TYPE> spacing(scalar_grid2.Dimension());
+
+  std::copy(scalar_grid2.SpacingPtrConst(), 
+            scalar_grid2.SpacingPtrConst()+scalar_grid2.Dimension(),
+            spacing.Ptr());
+  scalar_grid.Move(scalar_grid2);
+  scalar_grid.SetSpacing(spacing.PtrConst());
+  scalar_grid_ptr = &scalar_grid;
+  is_scalar_grid_set = true;
+}
+
+// Move gradient grid
+void MERGESHARP_DATA::MoveGradientGrid
+(GRADIENT_GRID & gradient_grid2)
+{
+  IJK::ARRAY<COORD_TYPE> spacing(gradient_grid2.Dimension());
+
+  std::copy(gradient_grid2.SpacingPtrConst(), 
+            gradient_grid2.SpacingPtrConst()+gradient_grid2.Dimension(),
+            spacing.Ptr());
+  gradient_grid.Move(gradient_grid2);
+  gradient_grid.SetSpacing(spacing.PtrConst());
+  gradient_grid_ptr = &gradient_grid;
+  is_gradient_grid_set = true;
+}
+
+// Share scalar grid
+void MERGESHARP_DATA::ShareScalarGrid
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid2)
+{
+  scalar_grid_ptr = &scalar_grid2;
+  is_scalar_grid_set = true;
+}
+
+// Share gradient grid
+void MERGESHARP_DATA::ShareGradientGrid
+(const GRADIENT_GRID_BASE & gradient_grid2)
+{
+  gradient_grid_ptr = &gradient_grid2;
   is_gradient_grid_set = true;
 }
 
@@ -177,6 +232,7 @@ void MERGESHARP_DATA::SubsampleScalarGrid
 {
   scalar_grid.Subsample(scalar_grid2, subsample_resolution);
   scalar_grid.SetSpacing(subsample_resolution, scalar_grid2.SpacingPtrConst());
+  scalar_grid_ptr = &scalar_grid;
   is_scalar_grid_set = true;
 }
 
@@ -188,7 +244,8 @@ void MERGESHARP_DATA::SupersampleScalarGrid
   scalar_grid.Supersample(scalar_grid2, supersample_resolution);
   scalar_grid.SetSpacing(float(1.0/supersample_resolution),
                          scalar_grid2.SpacingPtrConst());
- is_scalar_grid_set = true;
+  scalar_grid_ptr = &scalar_grid;
+  is_scalar_grid_set = true;
 }
 
 /// Subsample gradient grid
@@ -200,6 +257,7 @@ void MERGESHARP_DATA::SubsampleGradientGrid
   gradient_grid.ScalarMultiply(subsample_resolution);
   gradient_grid.SetSpacing(subsample_resolution,
                            gradient_grid2.SpacingPtrConst());
+  gradient_grid_ptr = &gradient_grid;
   is_gradient_grid_set = true;
 }
 
@@ -258,6 +316,72 @@ void MERGESHARP_DATA::SetGrids
 
 }
 
+// Copy z-slab of scalar and gradient grids.
+// Slab vertices are contiguous since z is the slowest varying coordinate.
+void MERGESHARP_DATA::CopySlab
+(const SHARPISO_SCALAR_GRID_BASE & full_scalar_grid,
+ const GRADIENT_GRID_BASE & full_gradient_grid,
+ const AXIS_SIZE_TYPE z0, const AXIS_SIZE_TYPE z1)
+{
+  const int dimension = full_scalar_grid.Dimension();
+  const GRADIENT_LENGTH_TYPE vector_length = full_gradient_grid.VectorLength();
+  IJK::ARRAY<AXIS_SIZE_TYPE> axis_size(dimension);
+  PROCEDURE_ERROR error("MERGESHARP_DATA::CopySlab");
+
+  if (dimension != DIM3) {
+    error.AddMessage("Programming error.  Grid dimension must be 3.");
+    throw error;
+  }
+
+  if (!full_gradient_grid.CompareSize(full_scalar_grid)) {
+    error.AddMessage("Programming error.  Scalar and gradient grid sizes differ.");
+    throw error;
+  }
+
+  if (z0 < 0 || z1 < z0 || z1 >= full_scalar_grid.AxisSize(DIM3-1)) {
+    error.AddMessage("Programming error.  Illegal slab [", z0, ",", z1, "].");
+    throw error;
+  }
+
+  std::copy(full_scalar_grid.AxisSize(), full_scalar_grid.AxisSize()+dimension,
+            axis_size.Ptr());
+  axis_size[DIM3-1] = z1-z0+1;
+
+  const VERTEX_INDEX v0 = z0*axis_size[0]*axis_size[1];
+
+  scalar_grid.SetSize(dimension, axis_size.PtrConst());
+  std::copy(full_scalar_grid.ScalarPtrConst()+v0,
+            full_scalar_grid.ScalarPtrConst()+v0+scalar_grid.NumVertices(),
+            scalar_grid.ScalarPtr());
+  scalar_grid.SetSpacing(full_scalar_grid.SpacingPtrConst());
+  scalar_grid_ptr = &scalar_grid;
+  is_scalar_grid_set = true;
+
+  gradient_grid.SetSize(dimension, axis_size.PtrConst(), vector_length);
+  std::copy(full_gradient_grid.VectorPtrConst()+v0*vector_length,
+            full_gradient_grid.VectorPtrConst()+
+            (v0+gradient_grid.NumVertices())*vector_length,
+            gradient_grid.VectorPtr());
+  gradient_grid.SetSpacing(full_gradient_grid.SpacingPtrConst());
+  gradient_grid_ptr = &gradient_grid;
+  is_gradient_grid_set = true;
+}
+
+/// Compute min and max of scalar_grid regions.
+void MERGESHARP_DATA::ComputeMinMaxRegions()
+{
+  PROCEDURE_ERROR error("MERGESHARP_DATA::ComputeMinMaxRegions");
+
+  if (!IsScalarGridSet()) {
+    error.AddMessage("Programming error. Scalar grid must be set before computing minmax regions.");
+    throw error;
+  }
+
+  if (minmax_region_edge_length > 0) {
+    minmax_regions.ComputeMinMax(ScalarGrid(), minmax_region_edge_length);
+  }
+}
+
 /// Set edge-isosurface intersections and normals.
 void MERGESHARP_DATA::SetEdgeI
 (const std::vector<COORD_TYPE> & edgeI_coord,
@@ -432,6 +556,8 @@ void MERGESHARP::SHARPISO_INFO::Clear()
   num_cube_multi_isov = 0;
   num_non_disk_isopatches = 0;
   num_non_manifold_split = 0;
+  num_open_edges = 0;
+  num_non_manifold_edges = 0;
   num_1_2_change = 0;
 
   vertex_info.clear();
@@ -479,7 +605,7 @@ void MERGESHARP::DUAL_ISOVERT_INFO::Set(const MERGESHARP::DUAL_ISOVERT & isov)
 
 void MERGESHARP::set_isovert_info
 (const std::vector<MERGESHARP::DUAL_ISOVERT> & iso_vlist,
- const std::vector<GRID_CUBE> & gcube_list,
+ const GRID_CUBE_ARRAY & gcube_list,
  std::vector<DUAL_ISOVERT_INFO> & isovert_info)
 {
   IJK::PROCEDURE_ERROR error("set_isovert_info");
@@ -562,14 +688,28 @@ void MERGESHARP::MERGE_DATA::Init
 {
   this->num_obj_per_vertex = num_obj_per_vertex;
   this->num_obj_per_edge = num_obj_per_edge;
+  IJK::PROCEDURE_ERROR error("MERGE_DATA::Init");
+
   this->num_obj_per_grid_vertex =
     dimension*num_obj_per_edge + num_obj_per_vertex;
+
+  // Check that object identifiers fit in MERGE_INDEX.
+  double max_num_obj = num_obj_per_grid_vertex;
+  for (int d = 0; d < dimension; d++)
+    { max_num_obj *= double(axis_size[d]); }
+  if (max_num_obj > double(std::numeric_limits<MERGE_INDEX>::max())) {
+    error.AddMessage("Grid is too large for ", 8*sizeof(MERGE_INDEX),
+                     "-bit merge indices.");
+    error.AddMessage("  Rebuild with INDEX_TYPE=int64.");
+    throw error;
+  }
+
   compute_num_grid_vertices(dimension, axis_size, num_vertices);
   num_edges = dimension*num_vertices;
   vertex_id0 = num_obj_per_edge*num_edges;
   MERGE_INDEX num_obj =
     num_obj_per_vertex*num_vertices + num_obj_per_edge*num_edges;
-  INTEGER_LIST<MERGE_INDEX,MERGE_INDEX>::Init(num_obj);
+  INTEGER_LIST<MERGE_INDEX,MERGE_INDEX>::SetRange(num_obj);
 }
 
 bool MERGESHARP::MERGE_DATA::Check(ERROR & error) const
@@ -177,6 +177,24 @@ namespace MERGESHARP {
     /// If true, convert gradient to hermite data using linear interpolation.
     bool flag_grad2hermiteI;
 
+    /// Number of grid edges along each edge of a min/max region.
+    /// Regions whose scalar range does not contain the isovalue
+    ///   are skipped when locating active cubes.
+    /// If 0, scan every grid cube.
+    AXIS_SIZE_TYPE minmax_region_edge_length;
+
+    /// If true, store index of active cubes in a sparse list
+    ///   instead of a grid with one entry per grid vertex.
+    bool flag_sparse_gcube_index;
+
+    /// Number of grid cubes along the z-axis in each slab.
+    /// If positive, process the grid one z-slab at a time.
+    /// If 0, process the entire grid at once.
+    AXIS_SIZE_TYPE slab_thickness;
+
+    /// Number of isovalues extracted concurrently.
+    int num_isovalue_threads;
+
   public:
     MERGESHARP_PARAM() { Init(); };
     ~MERGESHARP_PARAM() { Init(); };
@@ -220,6 +238,15 @@ namespace MERGESHARP {
     SHARPISO_SCALAR_GRID scalar_grid;  ///< Regular grid of scalar values.
     GRADIENT_GRID gradient_grid;       ///< Regular grid of vertex gradients.
 
+    /// Scalar and gradient grids returned by ScalarGrid() and GradientGrid().
+    /// Point to scalar_grid and gradient_grid unless the grids are shared.
+    const SHARPISO_SCALAR_GRID_BASE * scalar_grid_ptr;
+    const GRADIENT_GRID_BASE * gradient_grid_ptr;
+
+    /// Min and max scalar values of scalar_grid regions.
+    /// Shared by all isovalues.
+    SHARPISO_MINMAX_REGIONS minmax_regions;
+
     /// Coordinate of edge-isosurface intersections
     std::vector<COORD_TYPE> edgeI_coord;  
 
@@ -244,6 +271,25 @@ namespace MERGESHARP {
       (const SHARPISO_SCALAR_GRID_BASE & scalar_grid2);
     void CopyGradientGrid             /// Copy gradient_grid to MERGESHARP_DATA
       (const GRADIENT_GRID_BASE & gradient_grid2);
+
+    /// Move scalar_grid2 to MERGESHARP_DATA without copying scalar values.
+    /// scalar_grid2 is left empty.
+    void MoveScalarGrid(SHARPISO_SCALAR_GRID & scalar_grid2);
+
+    /// Move gradient_grid2 to MERGESHARP_DATA without copying gradients.
+    /// gradient_grid2 is left empty.
+    void MoveGradientGrid(GRADIENT_GRID & gradient_grid2);
+
+    /// Use scalar_grid2 without copying or moving it.
+    /// scalar_grid2 must not be modified or deleted
+    ///   while MERGESHARP_DATA uses it.
+    void ShareScalarGrid(const SHARPISO_SCALAR_GRID_BASE & scalar_grid2);
+
+    /// Use gradient_grid2 without copying or moving it.
+    /// gradient_grid2 must not be modified or deleted
+    ///   while MERGESHARP_DATA uses it.
+    void ShareGradientGrid(const GRADIENT_GRID_BASE & gradient_grid2);
+
     void SubsampleScalarGrid        /// Subsample scalar_grid.
       (const SHARPISO_SCALAR_GRID_BASE & scalar_grid2, 
        const int subsample_resolution);
@@ -270,6 +316,18 @@ namespace MERGESHARP {
        const bool flag_subsample, const int subsample_resolution,
        const bool flag_supersample, const int supersample_resolution);
 
+    /// Copy z-slab of scalar and gradient grids.
+    /// Slab contains grid vertices with z-coordinates from z0 to z1.
+    void CopySlab
+      (const SHARPISO_SCALAR_GRID_BASE & full_scalar_grid,
+       const GRADIENT_GRID_BASE & full_gradient_grid,
+       const AXIS_SIZE_TYPE z0, const AXIS_SIZE_TYPE z1);
+
+    /// Compute min and max of scalar_grid regions
+    ///   with edge length minmax_region_edge_length.
+    /// Precondition: Scalar grid is set.
+    void ComputeMinMaxRegions();
+
     /// Set edge-isosurface intersections and normals.
     void SetEdgeI(const std::vector<COORD_TYPE> & edgeI_coord,
                   const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord);
@@ -286,11 +344,15 @@ namespace MERGESHARP {
 
     /// Return scalar_grid.
     const SHARPISO_SCALAR_GRID_BASE & ScalarGrid() const
-      { return(scalar_grid); };
+      { return(*scalar_grid_ptr); };
 
     /// Return gradient_grid.
     const GRADIENT_GRID_BASE & GradientGrid() const     
-      { return(gradient_grid); };
+      { return(*gradient_grid_ptr); };
+
+    /// Return min and max of scalar_grid regions.
+    const SHARPISO_MINMAX_REGIONS & MinMaxRegions() const
+      { return(minmax_regions); };
 
     /// Return edgeI coordinates.
     const std::vector<COORD_TYPE> & EdgeICoord() const
@@ -427,6 +489,13 @@ namespace MERGESHARP {
     ///   or vice versa.
     int num_1_2_change;
 
+    /// Number of isosurface edges in exactly one isosurface polygon
+    ///   or in three or more polygons.  Edges between vertices
+    ///   in grid boundary cubes are not counted.
+    /// Set only when the isosurface is constructed by slabs.
+    int num_open_edges;
+    int num_non_manifold_edges;
+
     SHARPISO_INFO();  ///< Constructor.
     void Clear();     ///< Clear all data.
 
@@ -463,6 +532,8 @@ namespace MERGESHARP {
   // **************************************************
 
   /// Internal data structure for merge_identical_vertices 
+  /// Memory for each grid object is not allocated until needed.
+  /// merge_identical sorts short lists instead of allocating memory.
   class MERGE_DATA: public IJK::INTEGER_LIST<MERGE_INDEX, MERGE_INDEX> {
 
   protected:
@@ -605,7 +676,7 @@ namespace MERGESHARP {
   /// Store isosurface vertex information in isovert_info.
   void set_isovert_info
     (const std::vector<MERGESHARP::DUAL_ISOVERT> & iso_vlist,
-     const std::vector<GRID_CUBE> & gcube_list,
+     const GRID_CUBE_ARRAY & gcube_list,
      std::vector<DUAL_ISOVERT_INFO> & isovert_info);
 
   /// Delete vertices i where flag_keep[i] = false.
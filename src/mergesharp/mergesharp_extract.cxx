@@ -19,8 +19,12 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+#include <thread>
+#include <vector>
+
 #include "ijkgrid_macros.h"
 #include "ijkisopoly.txx"
+#include "ijkprofile.txx"
 #include "ijktime.txx"
 
 #include "mergesharp_extract.h"
@@ -29,6 +33,98 @@ using namespace IJK;
 using namespace MERGESHARP;
 
 
+// **************************************************
+// LOCAL ROUTINES
+// **************************************************
+
+namespace {
+
+  typedef IJK::FACET_INTERIOR_VERTEX_LIST<VERTEX_INDEX>
+  FACET_INTERIOR_VERTEX_LIST;
+
+  /// Isosurface polytopes extracted from one slab of grid edges.
+  class SLAB_ISOPOLY {
+  public:
+    std::vector<ISO_VERTEX_INDEX> iso_poly;
+    std::vector<FACET_VERTEX_INDEX> facet_vertex;
+  };
+
+  /// Extract dual isosurface polytopes around interior edges
+  ///   with direction edge_dir on the lines of edges starting
+  ///   at vertices vlist.VertexIndex(i), i0 <= i < i1.
+  /// Edges are visited in the same order as IJK_FOR_EACH_INTERIOR_GRID_EDGE.
+  void extract_dual_isopoly_in_slab
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SCALAR_TYPE isovalue, const int edge_dir,
+   const FACET_INTERIOR_VERTEX_LIST & vlist,
+   const VERTEX_INDEX i0, const VERTEX_INDEX i1,
+   const bool flag_facet_vertex, SLAB_ISOPOLY & slab_isopoly)
+  {
+    const VERTEX_INDEX axis_inc = scalar_grid.AxisIncrement(edge_dir);
+    const VERTEX_INDEX axis_size = scalar_grid.AxisSize(edge_dir);
+
+    for (VERTEX_INDEX i = i0; i < i1; i++) {
+      const VERTEX_INDEX iv0 = vlist.VertexIndex(i);
+      const VERTEX_INDEX endv = iv0 + (axis_size-1)*axis_inc;
+
+      for (VERTEX_INDEX iend0 = iv0; iend0 < endv; iend0 += axis_inc) {
+        if (flag_facet_vertex) {
+          extract_dual_isopoly_around_bipolar_edge
+            (scalar_grid, isovalue, iend0, edge_dir,
+             slab_isopoly.iso_poly, slab_isopoly.facet_vertex);
+        }
+        else {
+          extract_dual_isopoly_around_bipolar_edge
+            (scalar_grid, isovalue, iend0, edge_dir, slab_isopoly.iso_poly);
+        }
+      }
+    }
+  }
+
+  /// Extract dual isosurface polytopes using num_threads threads.
+  /// For each edge direction, the lines of interior grid edges
+  ///   are split into num_threads slabs of consecutive lines.
+  /// Thread k extracts slab k in each direction.
+  /// slab_isopoly[edge_dir*num_threads+k] contains the polytopes
+  ///   from slab k in direction edge_dir, so concatenating
+  ///   slab_isopoly in order gives the serial output.
+  void extract_dual_isopoly_slabs
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SCALAR_TYPE isovalue, const int num_threads,
+   const bool flag_facet_vertex, std::vector<SLAB_ISOPOLY> & slab_isopoly)
+  {
+    const int dimension = scalar_grid.Dimension();
+
+    slab_isopoly.clear();
+    slab_isopoly.resize(dimension*num_threads);
+
+    auto extract_slabs = [&](const int k) {
+      FACET_INTERIOR_VERTEX_LIST vlist(scalar_grid, 0, true);
+
+      for (int edge_dir = 0; edge_dir < dimension; edge_dir++) {
+        if (scalar_grid.AxisSize(edge_dir) < 1) { continue; }
+
+        vlist.GetVertices(scalar_grid, edge_dir);
+        const VERTEX_INDEX num_lines = vlist.NumVertices();
+        const VERTEX_INDEX i0 = (num_lines*k)/num_threads;
+        const VERTEX_INDEX i1 = (num_lines*(k+1))/num_threads;
+
+        extract_dual_isopoly_in_slab
+          (scalar_grid, isovalue, edge_dir, vlist, i0, i1,
+           flag_facet_vertex, slab_isopoly[edge_dir*num_threads+k]);
+      }
+    };
+
+    std::vector<std::thread> thread_list;
+    for (int k = 0; k < num_threads; k++)
+      { thread_list.push_back(std::thread(extract_slabs, k)); }
+    for (int k = 0; k < num_threads; k++)
+      { thread_list[k].join(); }
+  }
+
+}
+
+
 // **************************************************
 // EXTRACT ISOPOLY
 // **************************************************
@@ -45,6 +141,8 @@ void MERGESHARP::extract_dual_isopoly
  const SCALAR_TYPE isovalue, std::vector<ISO_VERTEX_INDEX> & iso_poly,
  MERGESHARP_INFO & mergesharp_info)
 {
+  IJK_PROFILE_SCOPE(extract_timer, "extract_dual_isopoly");
+
   mergesharp_info.time.extract = 0;
 
   clock_t t0 = std::clock();
@@ -79,6 +177,8 @@ void MERGESHARP::extract_dual_isopoly
  std::vector<FACET_VERTEX_INDEX> & facet_vertex,
  MERGESHARP_INFO & mergesharp_info)
 {
+  IJK_PROFILE_SCOPE(extract_timer, "extract_dual_isopoly");
+
   mergesharp_info.time.extract = 0;
 
   clock_t t0 = clock();
@@ -98,6 +198,87 @@ void MERGESHARP::extract_dual_isopoly
   clock2seconds(t1-t0, mergesharp_info.time.extract);
 }
 
+/// Extract dual isosurface polytopes using num_threads threads.
+/// Returns the same list as the serial version.
+void MERGESHARP::extract_dual_isopoly
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const SCALAR_TYPE isovalue, const int num_threads,
+ std::vector<ISO_VERTEX_INDEX> & iso_poly,
+ MERGESHARP_INFO & mergesharp_info)
+{
+  if (num_threads <= 1) {
+    extract_dual_isopoly(scalar_grid, isovalue, iso_poly, mergesharp_info);
+    return;
+  }
+
+  IJK_PROFILE_SCOPE(extract_timer, "extract_dual_isopoly");
+
+  mergesharp_info.time.extract = 0;
+
+  clock_t t0 = clock();
+
+  // initialize output
+  iso_poly.clear();
+
+  if (scalar_grid.NumCubeVertices() < 1) { return; }
+
+  std::vector<SLAB_ISOPOLY> slab_isopoly;
+  extract_dual_isopoly_slabs
+    (scalar_grid, isovalue, num_threads, false, slab_isopoly);
+
+  for (NUM_TYPE i = 0; i < NUM_TYPE(slab_isopoly.size()); i++) {
+    iso_poly.insert(iso_poly.end(), slab_isopoly[i].iso_poly.begin(),
+                    slab_isopoly[i].iso_poly.end());
+  }
+
+  clock_t t1 = clock();
+  clock2seconds(t1-t0, mergesharp_info.time.extract);
+}
+
+
+/// Extract dual isosurface polytopes using num_threads threads.
+/// Return locations of isosurface vertices on each facet.
+/// Returns the same lists as the serial version.
+void MERGESHARP::extract_dual_isopoly
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const SCALAR_TYPE isovalue, const int num_threads,
+ std::vector<ISO_VERTEX_INDEX> & iso_poly,
+ std::vector<FACET_VERTEX_INDEX> & facet_vertex,
+ MERGESHARP_INFO & mergesharp_info)
+{
+  if (num_threads <= 1) {
+    extract_dual_isopoly
+      (scalar_grid, isovalue, iso_poly, facet_vertex, mergesharp_info);
+    return;
+  }
+
+  IJK_PROFILE_SCOPE(extract_timer, "extract_dual_isopoly");
+
+  mergesharp_info.time.extract = 0;
+
+  clock_t t0 = clock();
+
+  // initialize output
+  iso_poly.clear();
+
+  if (scalar_grid.NumCubeVertices() < 1) { return; }
+
+  std::vector<SLAB_ISOPOLY> slab_isopoly;
+  extract_dual_isopoly_slabs
+    (scalar_grid, isovalue, num_threads, true, slab_isopoly);
+
+  for (NUM_TYPE i = 0; i < NUM_TYPE(slab_isopoly.size()); i++) {
+    iso_poly.insert(iso_poly.end(), slab_isopoly[i].iso_poly.begin(),
+                    slab_isopoly[i].iso_poly.end());
+    facet_vertex.insert
+      (facet_vertex.end(), slab_isopoly[i].facet_vertex.begin(),
+       slab_isopoly[i].facet_vertex.end());
+  }
+
+  clock_t t1 = clock();
+  clock2seconds(t1-t0, mergesharp_info.time.extract);
+}
+
 /// Extract dual isosurface polytopes from list of edges.
 /// Returns list of isosurface polytope vertices.
 /// Return locations of isosurface vertices on each facet.
@@ -56,6 +56,28 @@ namespace MERGESHARP {
    std::vector<FACET_VERTEX_INDEX> & facet_vertex,
    MERGESHARP_INFO & mergesharp_info);
 
+  /// Extract dual isosurface polytopes using num_threads threads.
+  /// Interior grid edges are split into slabs which are extracted
+  ///   in parallel.  Slab lists are concatenated in slab order,
+  ///   so iso_poly is identical to the list from the serial version.
+  /// @param num_threads Number of threads.  If num_threads <= 1,
+  ///   call the serial version.
+  void extract_dual_isopoly
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SCALAR_TYPE isovalue, const int num_threads,
+   std::vector<ISO_VERTEX_INDEX> & iso_poly,
+   MERGESHARP_INFO & mergesharp_info);
+
+  /// Extract dual isosurface polytopes using num_threads threads.
+  /// Return locations of isosurface vertices on each facet.
+  /// Lists are identical to the lists from the serial version.
+  void extract_dual_isopoly
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SCALAR_TYPE isovalue, const int num_threads,
+   std::vector<ISO_VERTEX_INDEX> & iso_cube,
+   std::vector<FACET_VERTEX_INDEX> & facet_vertex,
+   MERGESHARP_INFO & mergesharp_info);
+
   /// Extract dual isosurface polytopes from list of edges.
   /// Returns list of isosurface polytope vertices.
   /// Return locations of isosurface vertices on each facet.
@@ -0,0 +1,276 @@
+/// \file mergesharp_gradient.cxx
+/// Compute gradients from the scalar grid.
+
+/*
+  Copyright (C) 2013 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ijkgrid_macros.h"
+#include "ijkprofile.txx"
+
+#include "mergesharp_gradient.h"
+
+using namespace IJK;
+using namespace MERGESHARP;
+
+
+// **************************************************
+// LOCAL ROUTINES
+// **************************************************
+
+namespace {
+
+  /// Compute gradient at a boundary vertex.
+  /// Use one sided differences along axes where a neighbor is missing.
+  void compute_boundary_gradient
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const VERTEX_INDEX iv1, GRADIENT_COORD_TYPE * gradient)
+  {
+    GRID_COORD_TYPE coord[DIM3];
+
+    scalar_grid.ComputeCoord(iv1, coord);
+
+    for (int d = 0; d < DIM3; d++) {
+      if (coord[d] > 0) {
+        const VERTEX_INDEX iv0 = scalar_grid.PrevVertex(iv1, d);
+        if (coord[d]+1 < scalar_grid.AxisSize(d)) {
+          const VERTEX_INDEX iv2 = scalar_grid.NextVertex(iv1, d);
+          gradient[d] = 
+            (SCALAR_TYPE(scalar_grid.Scalar(iv2)) - scalar_grid.Scalar(iv0))/2;
+        }
+        else {
+          gradient[d] = scalar_grid.Scalar(iv1) - scalar_grid.Scalar(iv0);
+        }
+      }
+      else if (coord[d]+1 < scalar_grid.AxisSize(d)) {
+        const VERTEX_INDEX iv2 = scalar_grid.NextVertex(iv1, d);
+        gradient[d] = scalar_grid.Scalar(iv2) - scalar_grid.Scalar(iv1);
+      }
+      else {
+        gradient[d] = 0;
+      }
+    }
+  }
+
+  /// Compute central difference gradients at num_vert consecutive
+  ///   interior vertices along the x-axis.
+  /// The loop has no calls or early exits so the compiler can vectorize it.
+  /// @param scalar Pointer to scalar value of first vertex.
+  ///   Scalar values are widened to SCALAR_TYPE before division.
+  /// @param gradient Pointer to gradient of first vertex.
+  /// @param yinc Axis increment along the y-axis.
+  /// @param zinc Axis increment along the z-axis.
+  void compute_gradient_central_difference_row
+  (const GRID_SCALAR_TYPE * scalar, const VERTEX_INDEX num_vert,
+   const VERTEX_INDEX yinc, const VERTEX_INDEX zinc,
+   const GRADIENT_COORD_TYPE min_gradient_mag,
+   GRADIENT_COORD_TYPE * gradient)
+  {
+    for (VERTEX_INDEX k = 0; k < num_vert; k++) {
+      const GRADIENT_COORD_TYPE gx =
+        (SCALAR_TYPE(scalar[k+1]) - scalar[k-1])/2;
+      const GRADIENT_COORD_TYPE gy =
+        (SCALAR_TYPE(scalar[k+yinc]) - scalar[k-yinc])/2;
+      const GRADIENT_COORD_TYPE gz =
+        (SCALAR_TYPE(scalar[k+zinc]) - scalar[k-zinc])/2;
+      const SCALAR_TYPE mag = std::sqrt(SCALAR_TYPE(gx*gx + gy*gy + gz*gz));
+      const bool is_small = (mag < min_gradient_mag);
+
+      gradient[3*k] = is_small ? 0 : gx;
+      gradient[3*k+1] = is_small ? 0 : gy;
+      gradient[3*k+2] = is_small ? 0 : gz;
+    }
+  }
+
+  /// Compute gradients at vertices x0,...,x1-1 in the row
+  ///   starting at vertex iv_row.
+  void compute_gradient_row_range
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const VERTEX_INDEX iv_row, const bool is_interior_row,
+   const GRID_COORD_TYPE x0, const GRID_COORD_TYPE x1,
+   const GRADIENT_COORD_TYPE min_gradient_mag,
+   GRADIENT_GRID & gradient_grid)
+  {
+    const AXIS_SIZE_TYPE axis_size0 = scalar_grid.AxisSize(0);
+    GRID_COORD_TYPE xstart = x0;
+    GRID_COORD_TYPE xend = x1;
+
+    if (is_interior_row) {
+      if (xstart == 0) {
+        compute_boundary_gradient
+          (scalar_grid, iv_row, gradient_grid.VectorPtr(iv_row));
+        xstart++;
+      }
+      if (xend == axis_size0 && xend > xstart) {
+        xend--;
+        compute_boundary_gradient
+          (scalar_grid, iv_row+xend, gradient_grid.VectorPtr(iv_row+xend));
+      }
+
+      if (xend > xstart) {
+        compute_gradient_central_difference_row
+          (scalar_grid.ScalarPtrConst()+iv_row+xstart, xend-xstart,
+           scalar_grid.AxisIncrement(1), scalar_grid.AxisIncrement(2),
+           min_gradient_mag, gradient_grid.VectorPtr(iv_row+xstart));
+      }
+    }
+    else {
+      for (GRID_COORD_TYPE x = xstart; x < xend; x++) {
+        compute_boundary_gradient
+          (scalar_grid, iv_row+x, gradient_grid.VectorPtr(iv_row+x));
+      }
+    }
+  }
+
+  /// Return true if some isovalue in isovalue_list is
+  ///   in the range [minval,maxval].
+  bool contains_isovalue
+  (const SCALAR_ARRAY & isovalue_list,
+   const SCALAR_TYPE minval, const SCALAR_TYPE maxval)
+  {
+    for (NUM_TYPE i = 0; i < NUM_TYPE(isovalue_list.size()); i++) {
+      if (minval <= isovalue_list[i] && isovalue_list[i] <= maxval)
+        { return(true); }
+    }
+    return(false);
+  }
+
+  /// Set in_band[iv] to 1 for every vertex iv within distance band_width
+  ///   of some cube whose scalar range contains an isovalue.
+  void mark_gradient_band
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SCALAR_ARRAY & isovalue_list, const AXIS_SIZE_TYPE band_width,
+   std::vector<unsigned char> & in_band)
+  {
+    const AXIS_SIZE_TYPE * axis_size = scalar_grid.AxisSize();
+    const NUM_TYPE num_cube_vertices = scalar_grid.NumCubeVertices();
+    GRID_COORD_TYPE coord[DIM3];
+    GRID_COORD_TYPE min_coord[DIM3], max_coord[DIM3];
+
+    in_band.assign(scalar_grid.NumVertices(), 0);
+
+    IJK_FOR_EACH_GRID_CUBE(iv0, scalar_grid, VERTEX_INDEX) {
+
+      SCALAR_TYPE minval = scalar_grid.Scalar(iv0);
+      SCALAR_TYPE maxval = minval;
+      for (NUM_TYPE k = 1; k < num_cube_vertices; k++) {
+        const SCALAR_TYPE s =
+          scalar_grid.Scalar(scalar_grid.CubeVertex(iv0, k));
+        if (s < minval) { minval = s; }
+        else if (s > maxval) { maxval = s; }
+      }
+
+      if (!contains_isovalue(isovalue_list, minval, maxval)) { continue; }
+
+      scalar_grid.ComputeCoord(iv0, coord);
+      for (int d = 0; d < DIM3; d++) {
+        min_coord[d] = std::max(coord[d]-band_width, 0);
+        max_coord[d] = std::min(coord[d]+1+band_width, axis_size[d]-1);
+      }
+
+      for (GRID_COORD_TYPE z = min_coord[2]; z <= max_coord[2]; z++) {
+        for (GRID_COORD_TYPE y = min_coord[1]; y <= max_coord[1]; y++) {
+          const VERTEX_INDEX iv_row =
+            scalar_grid.AxisIncrement(1)*y + scalar_grid.AxisIncrement(2)*z;
+          std::fill(in_band.begin()+iv_row+min_coord[0],
+                    in_band.begin()+iv_row+max_coord[0]+1, 1);
+        }
+      }
+    }
+  }
+
+}
+
+
+// **************************************************
+// CENTRAL DIFFERENCE GRADIENTS
+// **************************************************
+
+/// Compute central difference gradients at all grid vertices.
+void MERGESHARP::compute_gradient_central_difference
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const GRADIENT_COORD_TYPE min_gradient_mag,
+ GRADIENT_GRID & gradient_grid)
+{
+  IJK_PROFILE_SCOPE(gradient_timer, "compute_gradient");
+  const AXIS_SIZE_TYPE * axis_size = scalar_grid.AxisSize();
+
+  gradient_grid.SetSize(scalar_grid, DIM3);
+  gradient_grid.SetSpacing(scalar_grid.SpacingPtrConst());
+
+  for (GRID_COORD_TYPE z = 0; z < axis_size[2]; z++) {
+    for (GRID_COORD_TYPE y = 0; y < axis_size[1]; y++) {
+      const VERTEX_INDEX iv_row =
+        scalar_grid.AxisIncrement(1)*y + scalar_grid.AxisIncrement(2)*z;
+      const bool is_interior_row =
+        (y > 0 && y+1 < axis_size[1] && z > 0 && z+1 < axis_size[2]);
+
+      compute_gradient_row_range
+        (scalar_grid, iv_row, is_interior_row, 0, axis_size[0],
+         min_gradient_mag, gradient_grid);
+    }
+  }
+}
+
+
+/// Compute central difference gradients only at grid vertices
+///   near cubes whose scalar range contains some isovalue.
+void MERGESHARP::compute_gradient_central_difference_band
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const SCALAR_ARRAY & isovalue_list, const AXIS_SIZE_TYPE band_width,
+ const GRADIENT_COORD_TYPE min_gradient_mag,
+ GRADIENT_GRID & gradient_grid, NUM_TYPE & num_computed)
+{
+  IJK_PROFILE_SCOPE(gradient_timer, "compute_gradient");
+  const AXIS_SIZE_TYPE * axis_size = scalar_grid.AxisSize();
+  std::vector<unsigned char> in_band;
+
+  num_computed = 0;
+  gradient_grid.SetSize(scalar_grid, DIM3);
+  gradient_grid.SetSpacing(scalar_grid.SpacingPtrConst());
+  gradient_grid.SetAllCoord(0);
+
+  mark_gradient_band(scalar_grid, isovalue_list, band_width, in_band);
+
+  for (GRID_COORD_TYPE z = 0; z < axis_size[2]; z++) {
+    for (GRID_COORD_TYPE y = 0; y < axis_size[1]; y++) {
+      const VERTEX_INDEX iv_row =
+        scalar_grid.AxisIncrement(1)*y + scalar_grid.AxisIncrement(2)*z;
+      const bool is_interior_row =
+        (y > 0 && y+1 < axis_size[1] && z > 0 && z+1 < axis_size[2]);
+
+      // Compute gradients in each run of consecutive band vertices.
+      GRID_COORD_TYPE x0 = 0;
+      while (x0 < axis_size[0]) {
+        if (!in_band[iv_row+x0]) { x0++; continue; }
+
+        GRID_COORD_TYPE x1 = x0+1;
+        while (x1 < axis_size[0] && in_band[iv_row+x1]) { x1++; }
+
+        compute_gradient_row_range
+          (scalar_grid, iv_row, is_interior_row, x0, x1,
+           min_gradient_mag, gradient_grid);
+        num_computed += (x1-x0);
+        x0 = x1;
+      }
+    }
+  }
+}
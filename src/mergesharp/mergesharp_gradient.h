@@ -0,0 +1,59 @@
+/// \file mergesharp_gradient.h
+/// Compute gradients from the scalar grid.
+
+/*
+  Copyright (C) 2013 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef _MERGESHARP_GRADIENT_
+#define _MERGESHARP_GRADIENT_
+
+#include "sharpiso_grids.h"
+#include "mergesharp_types.h"
+
+
+namespace MERGESHARP {
+
+  // **************************************************
+  // CENTRAL DIFFERENCE GRADIENTS
+  // **************************************************
+
+  /// Compute central difference gradients at all grid vertices.
+  /// Gradients match cgradient:
+  ///   Interior gradients are (s[iv+e_d]-s[iv-e_d])/2 and are set to zero
+  ///     if their magnitude is less than min_gradient_mag.
+  ///   Boundary gradients use one sided differences along axes
+  ///     where a neighbor is missing.
+  void compute_gradient_central_difference
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_COORD_TYPE min_gradient_mag,
+   GRADIENT_GRID & gradient_grid);
+
+  /// Compute central difference gradients only at grid vertices
+  ///   within distance band_width of some cube whose scalar range
+  ///   contains an isovalue in isovalue_list.
+  /// Gradients at other vertices are set to zero.
+  /// @param[out] num_computed Number of vertices with computed gradients.
+  void compute_gradient_central_difference_band
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SCALAR_ARRAY & isovalue_list, const AXIS_SIZE_TYPE band_width,
+   const GRADIENT_COORD_TYPE min_gradient_mag,
+   GRADIENT_GRID & gradient_grid, NUM_TYPE & num_computed);
+
+}
+
+#endif
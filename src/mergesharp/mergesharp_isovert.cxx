@@ -26,10 +26,13 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iomanip>  
 #include <stdio.h>
 #include <stdio.h>
+#include <functional>
+#include <thread>
 
 #include "ijkcoord.txx"
 #include "ijkgrid.txx"
 #include "ijkgrid_macros.h"
+#include "ijkprofile.txx"
 #include "ijkscalar_grid.txx"
 
 #include "mergesharp_types.h"
@@ -113,6 +116,82 @@ namespace {
 			isovert.gcube_list[gcube_index].linf_dist);
 	}
 
+	// Compute isosurface vertex positions for gcube_list[kstart..kend-1].
+	// Writes only to gcube_list[kstart..kend-1] and to isovert_info,
+	//   so disjoint ranges may be processed concurrently.
+	// Each call has its own GET_GRADIENTS_SCRATCH, reused for all cubes
+	//   in the range.
+	void compute_isovert_positions_in_range
+		(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+		const GRADIENT_GRID_BASE & gradient_grid,
+		const SCALAR_TYPE isovalue,
+		const SHARP_ISOVERT_PARAM & isovert_param,
+		const OFFSET_VOXEL & voxel,
+		const NUM_TYPE kstart, const NUM_TYPE kend,
+		ISOVERT & isovert,
+		ISOVERT_INFO & isovert_info)
+	{
+		GET_GRADIENTS_SCRATCH scratch;
+
+		if (isovert_param.use_lindstrom && isovert_param.use_lindstrom_fast &&
+			!isovert_param.use_eigen_svd) {
+
+			// Solve normal equations of LINDSTROM_BATCH_SIZE cubes together.
+			for (NUM_TYPE k0 = kstart; k0 < kend; k0 += LINDSTROM_BATCH_SIZE) {
+				const NUM_TYPE num_cubes = std::min(kend-k0, LINDSTROM_BATCH_SIZE);
+				VERTEX_INDEX cube_index[LINDSTROM_BATCH_SIZE];
+				COORD_TYPE sharp_coord[LINDSTROM_BATCH_SIZE*DIM3];
+				EIGENVALUE_TYPE eigenvalues[LINDSTROM_BATCH_SIZE*DIM3]={0.0};
+				NUM_TYPE num_large_eigenvalues[LINDSTROM_BATCH_SIZE];
+				SVD_INFO svd_info[LINDSTROM_BATCH_SIZE];
+
+				for (NUM_TYPE i = 0; i < num_cubes; i++) {
+					cube_index[i] = isovert.gcube_list[k0+i].cube_index;
+					isovert.gcube_list[k0+i].flag_centroid_location = false;
+				}
+
+				svd_compute_sharp_vertex_for_cubes_lindstrom
+					(scalar_grid, gradient_grid, cube_index, num_cubes, isovalue,
+					isovert_param, voxel, scratch, sharp_coord, eigenvalues,
+					num_large_eigenvalues, svd_info);
+
+				for (NUM_TYPE i = 0; i < num_cubes; i++) {
+					std::copy(sharp_coord+i*DIM3, sharp_coord+(i+1)*DIM3,
+						isovert.gcube_list[k0+i].isovert_coord);
+					store_svd_info(scalar_grid, cube_index[i], k0+i,
+						num_large_eigenvalues[i], svd_info[i], isovert, isovert_info);
+				}
+			}
+			return;
+		}
+
+		for (NUM_TYPE index = kstart; index < kend; index++) {
+			const VERTEX_INDEX iv = isovert.gcube_list[index].cube_index;
+			isovert.gcube_list[index].flag_centroid_location = false;
+
+			// compute the sharp vertex for this cube
+			EIGENVALUE_TYPE eigenvalues[DIM3]={0.0};
+			NUM_TYPE num_large_eigenvalues;
+			SVD_INFO svd_info;
+
+			if (isovert_param.use_lindstrom) {
+				svd_compute_sharp_vertex_for_cube_lindstrom
+					(scalar_grid, gradient_grid, iv, isovalue, isovert_param, voxel,
+					scratch, isovert.gcube_list[index].isovert_coord,
+					eigenvalues, num_large_eigenvalues, svd_info);
+			}
+			else {
+				svd_compute_sharp_vertex_for_cube_lc_intersection
+					(scalar_grid, gradient_grid, iv, isovalue, isovert_param, voxel,
+					scratch, isovert.gcube_list[index].isovert_coord,
+					eigenvalues, num_large_eigenvalues, svd_info);
+			}
+
+			store_svd_info(scalar_grid, iv, index, num_large_eigenvalues,
+				svd_info, isovert, isovert_info);
+		}
+	}
+
 }
 
 // **************************************************
@@ -121,6 +200,9 @@ namespace {
 
 /**
 * **Compute Isovertex Positions from gradients. 
+* Active cubes are split into isovert_param.num_threads contiguous ranges
+*   which are processed concurrently.  Output does not depend on 
+*   the number of threads.
 */
 void compute_isovert_positions 
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
@@ -130,84 +212,51 @@ void compute_isovert_positions
 	ISOVERT & isovert,
 	ISOVERT_INFO & isovert_info)
 {
+	IJK_PROFILE_SCOPE(position_timer, "compute_isovert_positions");
 	const SIGNED_COORD_TYPE grad_selection_cube_offset =
 		isovert_param.grad_selection_cube_offset;
+	const NUM_TYPE num_gcube = isovert.gcube_list.size();
 	OFFSET_VOXEL voxel;
-	SVD_INFO svd_info;
 
 	voxel.SetVertexCoord
 		(scalar_grid.SpacingPtrConst(), grad_selection_cube_offset);
 
-	if (isovert_param.use_lindstrom) {
-
-		IJK_FOR_EACH_GRID_CUBE(iv, scalar_grid, VERTEX_INDEX) {
-			NUM_TYPE index = isovert.sharp_ind_grid.Scalar(iv);
+	NUM_TYPE num_threads = isovert_param.num_threads;
+	if (num_threads > num_gcube) { num_threads = num_gcube; }
 
-			if (index != ISOVERT::NO_INDEX) {
-				// this is an active cube
-				isovert.gcube_list[index].flag_centroid_location = false;
-
-				// compute the sharp vertex for this cube
-				EIGENVALUE_TYPE eigenvalues[DIM3]={0.0};
-				NUM_TYPE num_large_eigenvalues;
-				//DEBUG
-				/*using namespace std;
-				cout <<"\n---------------------------\ncube index eigen "<< iv<<","; 
-				*/
-				svd_compute_sharp_vertex_for_cube_lindstrom
-					(scalar_grid, gradient_grid, iv, isovalue, isovert_param, voxel,
-					isovert.gcube_list[index].isovert_coord,
-					eigenvalues, num_large_eigenvalues, svd_info);
-				store_svd_info(scalar_grid, iv, index, num_large_eigenvalues,
-					svd_info, isovert, isovert_info);
-
-				////DEBUG
-				//cout <<" eigen values ";
-
-				//if(svd_info.location!=CENTROID)
-				//{
-				//	for (int j = 0; j < num_large_eigenvalues; j++)
-				//	{
-				//		cout << eigenvalues[j]<<" ";
-				//	}
-				//	cout << endl;
-				//}
-				//else
-				//{
-				//	cout <<"location computed using centroid.\n";
-				//}
-			}
-		}
+	if (num_threads <= 1) {
+		compute_isovert_positions_in_range
+			(scalar_grid, gradient_grid, isovalue, isovert_param, voxel,
+			0, num_gcube, isovert, isovert_info);
 	}
 	else {
-
-		IJK_FOR_EACH_GRID_CUBE(iv, scalar_grid, VERTEX_INDEX) {
-			NUM_TYPE index = isovert.sharp_ind_grid.Scalar(iv);
-
-			if (index != ISOVERT::NO_INDEX) {
-				// this is an active cube
-				isovert.gcube_list[index].flag_centroid_location = false;
-
-				// compute the sharp vertex for this cube
-				EIGENVALUE_TYPE eigenvalues[DIM3]={0.0};
-				NUM_TYPE num_large_eigenvalues;
-
-				svd_compute_sharp_vertex_for_cube_lc_intersection
-					(scalar_grid, gradient_grid, iv, isovalue, isovert_param, voxel,
-					isovert.gcube_list[index].isovert_coord,
-					eigenvalues, num_large_eigenvalues, svd_info);
-
-				store_svd_info(scalar_grid, iv, index, num_large_eigenvalues,
-					svd_info, isovert, isovert_info);
-			}
+		std::vector<ISOVERT_INFO> thread_info(num_threads);
+		std::vector<std::thread> thread_list;
+
+		for (NUM_TYPE i = 0; i < num_threads; i++) {
+			const NUM_TYPE kstart = (num_gcube*i)/num_threads;
+			const NUM_TYPE kend = (num_gcube*(i+1))/num_threads;
+			thread_list.push_back
+				(std::thread(compute_isovert_positions_in_range,
+				std::cref(scalar_grid), std::cref(gradient_grid), isovalue,
+				std::cref(isovert_param), std::cref(voxel), kstart, kend,
+				std::ref(isovert), std::ref(thread_info[i])));
 		}
 
+		for (NUM_TYPE i = 0; i < num_threads; i++) {
+			thread_list[i].join();
+			isovert_info.num_conflicts += thread_info[i].num_conflicts;
+			isovert_info.num_Linf_iso_vertex_locations += 
+				thread_info[i].num_Linf_iso_vertex_locations;
+		}
 	}
-	store_boundary_bits(scalar_grid, isovert.gcube_list);
 
+	store_boundary_bits(scalar_grid, isovert.gcube_list);
 }
 
 // Compute isosurface vertex positions using isosurface-edge intersections.
+// Intersections of isosurface and grid edges are computed once
+//   for all active cubes and stored in an EDGEI_CACHE.
 void compute_isovert_positions_edgeI
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	const GRADIENT_GRID_BASE & gradient_grid,
@@ -217,60 +266,37 @@ void compute_isovert_positions_edgeI
 	ISOVERT & isovert,
 	ISOVERT_INFO & isovert_info)
 {
-	const SIGNED_COORD_TYPE grad_selection_cube_offset =
-		isovert_param.grad_selection_cube_offset;
+	const NUM_TYPE num_gcube = isovert.gcube_list.size();
+	const bool flag_linear_interpolate =
+		(vertex_position_method == EDGEI_INTERPOLATE);
+	EDGEI_CACHE edgeI_cache;
+	GET_GRADIENTS_SCRATCH scratch;
 	SVD_INFO svd_info;
 
-	if (vertex_position_method == EDGEI_GRADIENT) {
-
-		IJK_FOR_EACH_GRID_CUBE(iv, scalar_grid, VERTEX_INDEX) {
-			NUM_TYPE index = isovert.sharp_ind_grid.Scalar(iv);
-
-			if (index != ISOVERT::NO_INDEX) {
-				// this is an active cube
-				isovert.gcube_list[index].flag_centroid_location = false;
-
-				// compute the sharp vertex for this cube
-				EIGENVALUE_TYPE eigenvalues[DIM3]={0.0};
-				NUM_TYPE num_large_eigenvalues;
+	if (num_gcube == 0) { return; }
 
-				svd_compute_sharp_vertex_edgeI_sharp_gradient
-					(scalar_grid, gradient_grid, iv, isovalue, isovert_param,
-					isovert.gcube_list[index].isovert_coord,
-					eigenvalues, num_large_eigenvalues, svd_info);
-
-
-				store_svd_info(scalar_grid, iv, index, num_large_eigenvalues,
-					svd_info, isovert, isovert_info);
-			}
-		}
-
-	}
-	else {
-		// vertex_position_method == EDGEI_INTERPOLATE
-
-		IJK_FOR_EACH_GRID_CUBE(iv, scalar_grid, VERTEX_INDEX) {
-			NUM_TYPE index = isovert.sharp_ind_grid.Scalar(iv);
+	edgeI_cache.Set
+		(scalar_grid, gradient_grid, isovalue, 
+		isovert_param.max_small_magnitude, 
+		isovert.gcube_list.CubeIndexPtrConst(), num_gcube, 
+		flag_linear_interpolate);
 
-			if (index != ISOVERT::NO_INDEX) {
-				// this is an active cube
-				isovert.gcube_list[index].flag_centroid_location = false;
+	for (NUM_TYPE index = 0; index < num_gcube; index++) {
+		const VERTEX_INDEX iv = isovert.gcube_list.CubeIndex(index);
 
-				// compute the sharp vertex for this cube
-				EIGENVALUE_TYPE eigenvalues[DIM3]={0.0};
-				NUM_TYPE num_large_eigenvalues;
+		isovert.gcube_list[index].flag_centroid_location = false;
 
-				svd_compute_sharp_vertex_edgeI_interpolate_gradients
-					(scalar_grid, gradient_grid, iv, isovalue, isovert_param,
-					isovert.gcube_list[index].isovert_coord,
-					eigenvalues, num_large_eigenvalues, svd_info);
-
-				store_svd_info(scalar_grid, iv, index, num_large_eigenvalues,
-					svd_info, isovert, isovert_info);
+		// compute the sharp vertex for this cube
+		EIGENVALUE_TYPE eigenvalues[DIM3]={0.0};
+		NUM_TYPE num_large_eigenvalues;
 
-			}
-		}
+		svd_compute_sharp_vertex_edgeI
+			(scalar_grid, gradient_grid, edgeI_cache, index, iv, isovert_param, 
+			scratch, isovert.gcube_list[index].isovert_coord,
+			eigenvalues, num_large_eigenvalues, svd_info);
 
+		store_svd_info(scalar_grid, iv, index, num_large_eigenvalues,
+			svd_info, isovert, isovert_info);
 	}
 
 	store_boundary_bits(scalar_grid, isovert.gcube_list);
@@ -288,6 +314,8 @@ void MERGESHARP::recompute_isovert_positions
 	ISOVERT & isovert,
 	ISOVERT_INFO & isovert_info)
 {
+	IJK_PROFILE_SCOPE(recompute_timer, "recompute_isovert_positions");
+
 	for (NUM_TYPE i = 0; i < isovert.gcube_list.size(); i++) {
 		GRID_CUBE_FLAG cube_flag = isovert.gcube_list[i].flag;
 
@@ -425,6 +453,7 @@ void MERGESHARP::recompute_isovert_positions
 	const SHARP_ISOVERT_PARAM & isovert_param,
 	ISOVERT & isovert)
 {
+	IJK_PROFILE_SCOPE(recompute_timer, "recompute_isovert_positions");
 
 	for (NUM_TYPE i = 0; i < isovert.gcube_list.size(); i++) {
 		GRID_CUBE_FLAG cube_flag = isovert.gcube_list[i].flag;
@@ -628,20 +657,20 @@ void compute_isovert_positions
 class GCUBE_COMPARE {
 
 public:
-	const std::vector<GRID_CUBE> * gcube_list;
+	const GRID_CUBE_ARRAY * gcube_list;
 
-	GCUBE_COMPARE(const std::vector<GRID_CUBE> & gcube_list)
+	GCUBE_COMPARE(const GRID_CUBE_ARRAY & gcube_list)
 	{ this->gcube_list = &gcube_list; };
 
 	bool operator () (int i,int j)
 	{
-		if (gcube_list->at(i).num_eigenvalues == 
-			gcube_list->at(j).num_eigenvalues) {
-				return ((gcube_list->at(i).linf_dist) < (gcube_list->at(j).linf_dist)); 
+		if (gcube_list->NumEigenvalues(i) == 
+			gcube_list->NumEigenvalues(j)) {
+				return ((gcube_list->LinfDist(i)) < (gcube_list->LinfDist(j))); 
 		}
 		else {
-			return ((gcube_list->at(i).num_eigenvalues) > 
-				(gcube_list->at(j).num_eigenvalues)); 
+			return ((gcube_list->NumEigenvalues(i)) > 
+				(gcube_list->NumEigenvalues(j))); 
 		}
 	}
 };
@@ -651,7 +680,7 @@ public:
 ///    sorted by number of large eigenvalues and by distance 
 ///    of sharp coord from cube center.
 void MERGESHARP::sort_gcube_list
-	(const std::vector<GRID_CUBE> & gcube_list,
+	(const GRID_CUBE_ARRAY & gcube_list,
 	std::vector<NUM_TYPE> & sortd_ind2gcube_list)
 {
   GCUBE_COMPARE gcube_compare(gcube_list);
@@ -714,9 +743,9 @@ void get_selected
 	std::vector<VERTEX_INDEX> & selected_list)
 {
 	const int dimension = grid.Dimension();
-	static GRID_COORD_TYPE coord[DIM3];
-	static GRID_COORD_TYPE min_coord[DIM3];
-	static GRID_COORD_TYPE max_coord[DIM3];
+	GRID_COORD_TYPE coord[DIM3];
+	GRID_COORD_TYPE min_coord[DIM3];
+	GRID_COORD_TYPE max_coord[DIM3];
 
 	long boundary_bits;
 
@@ -850,9 +879,9 @@ void MERGESHARP::init_bin_grid
 
 void MERGESHARP::bin_grid_insert
 	(const SHARPISO_GRID & grid, const AXIS_SIZE_TYPE bin_width,
-	const VERTEX_INDEX cube_index, BIN_GRID<int> & bin_grid)
+	const VERTEX_INDEX cube_index, BIN_GRID<VERTEX_INDEX> & bin_grid)
 {
-	static GRID_COORD_TYPE coord[DIM3];
+	GRID_COORD_TYPE coord[DIM3];
 
 	grid.ComputeCoord(cube_index, coord);
 	divide_coord_3D(bin_width, coord);
@@ -909,30 +938,300 @@ bool check_covered_point(
 }
 
 
+// **************************************************
+// SELECTION SCHEDULE
+// **************************************************
+
+/// Order in which to process the sorted cube list during selection.
+/// Serial schedules process every index in sorted order, one at a time.
+/// Parallel schedules split the sorted list into rounds.  Cubes in
+///   a round are far enough apart that they do not read or write
+///   each other's neighborhoods, and no cube in a round is near 
+///   an earlier cube processed in a later round.
+/// Processing the rounds in order gives the same selection as
+///   processing the sorted list in order.
+class SELECTION_SCHEDULE {
+
+protected:
+	bool flag_serial;
+	NUM_TYPE num_sorted;
+
+	/// Indices into the sorted list, grouped by round.
+	std::vector<NUM_TYPE> round_list;
+
+	/// Round i is round_list[round_start[i]..round_start[i+1]-1].
+	std::vector<NUM_TYPE> round_start;
+
+	/// Compute rounds for indices in pending_list.
+	void ComputeRounds
+		(const SHARPISO_GRID & grid, const ISOVERT & isovert,
+		const vector<NUM_TYPE> & sortd_ind2gcube_list,
+		const vector<NUM_TYPE> & pending_list, const AXIS_SIZE_TYPE cell_width);
+
+public:
+	SELECTION_SCHEDULE() { SetSerial(0); }
+
+	/// Process all num_sorted indices serially.
+	void SetSerial(const NUM_TYPE num_sorted);
+
+	/// Compute parallel rounds.
+	/// Skip cubes which are never selected in any selection phase.
+	void Set
+		(const SHARPISO_SCALAR_GRID_BASE & scalar_grid, const ISOVERT & isovert,
+		const vector<NUM_TYPE> & sortd_ind2gcube_list,
+		const COORD_TYPE linf_dist_threshold);
+
+	bool IsSerial() const { return(flag_serial); }
+	NUM_TYPE NumSorted() const { return(num_sorted); }
+	NUM_TYPE NumRounds() const { return(round_start.size()-1); }
+	NUM_TYPE RoundStart(const NUM_TYPE i) const { return(round_start[i]); }
+	NUM_TYPE RoundEnd(const NUM_TYPE i) const { return(round_start[i+1]); }
+	NUM_TYPE Index(const NUM_TYPE k) const { return(round_list[k]); }
+};
+
+
+void SELECTION_SCHEDULE::SetSerial(const NUM_TYPE num_sorted)
+{
+	flag_serial = true;
+	this->num_sorted = num_sorted;
+	round_list.clear();
+	round_start.assign(1, 0);
+}
+
+
+void SELECTION_SCHEDULE::Set
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid, const ISOVERT & isovert,
+	const vector<NUM_TYPE> & sortd_ind2gcube_list,
+	const COORD_TYPE linf_dist_threshold)
+{
+	GRID_COORD_TYPE coord0[DIM3], coord1[DIM3];
+	vector<NUM_TYPE> pending_list;
+
+	SetSerial(sortd_ind2gcube_list.size());
+	flag_serial = false;
+
+	// Every selection phase skips boundary cubes and cubes
+	//   with linf_dist >= linf_dist_threshold and linf_dist > 0.5.
+	// dmax = max distance from a cube to the cube containing its isovert.
+	GRID_COORD_TYPE dmax = 0;
+	for (NUM_TYPE ind = 0; ind < NUM_TYPE(sortd_ind2gcube_list.size());
+	     ind++) {
+		const GRID_CUBE_CONST_REF c = isovert.gcube_list[sortd_ind2gcube_list[ind]];
+
+		if (c.boundary_bits != 0) { continue; }
+		if (c.linf_dist >= linf_dist_threshold && c.linf_dist > 0.5) 
+			{ continue; }
+
+		pending_list.push_back(ind);
+
+		VERTEX_INDEX cube_index1;
+		compute_containing_cube(scalar_grid, c.isovert_coord, cube_index1);
+		scalar_grid.ComputeCoord(c.cube_index, coord0);
+		scalar_grid.ComputeCoord(cube_index1, coord1);
+		for (int d = 0; d < DIM3; d++) {
+			const GRID_COORD_TYPE dist = 
+				(coord0[d] > coord1[d])?(coord0[d]-coord1[d]):(coord1[d]-coord0[d]);
+			if (dist > dmax) { dmax = dist; }
+		}
+	}
+
+	// Processing a cube reads flags of cubes within distance dmax+1,
+	//   reads selected cubes within distance 3 (creates_triangle), 
+	//   and writes flags of cubes within distance 1.
+	// Cubes at distance more than max(3,dmax+2) are independent.
+	AXIS_SIZE_TYPE cell_width = dmax+3;
+	if (cell_width < 4) { cell_width = 4; }
+
+	ComputeRounds
+		(scalar_grid, isovert, sortd_ind2gcube_list, pending_list, cell_width);
+}
+
+
+// Compute rounds.
+// Each round scans a window of the first pending indices in sorted order.
+// Cubes are binned into cells of width cell_width.  A scanned cube 
+//   is in the round if no earlier scanned cube is in the same 
+//   or an adjacent cell.  Such cubes are more than cell_width apart.
+void SELECTION_SCHEDULE::ComputeRounds
+	(const SHARPISO_GRID & grid, const ISOVERT & isovert,
+	const vector<NUM_TYPE> & sortd_ind2gcube_list,
+	const vector<NUM_TYPE> & pending_list, const AXIS_SIZE_TYPE cell_width)
+{
+	const NUM_TYPE MIN_WINDOW = 64;
+	const NUM_TYPE MAX_WINDOW = 65536;
+	AXIS_SIZE_TYPE num_cells[DIM3];
+	GRID_COORD_TYPE coord[DIM3];
+	vector<NUM_TYPE> window;
+	vector<NUM_TYPE> not_ready;
+	vector<VERTEX_INDEX> marked_list;
+	NUM_TYPE window_size = 1024;
+
+	NUM_TYPE total_num_cells = 1;
+	for (int d = 0; d < DIM3; d++) {
+		num_cells[d] = IJK::compute_subsample_size(grid.AxisSize(d), cell_width);
+		total_num_cells *= num_cells[d];
+	}
+	vector<bool> is_marked(total_num_cells, false);
+
+	const NUM_TYPE num_pending = pending_list.size();
+	NUM_TYPE inext = 0;
+	while (window.size() > 0 || inext < num_pending) {
+
+		while (NUM_TYPE(window.size()) < window_size && inext < num_pending) {
+			window.push_back(pending_list[inext]);
+			inext++;
+		}
+
+		const NUM_TYPE num_window = window.size();
+		not_ready.clear();
+		for (NUM_TYPE k = 0; k < num_window; k++) {
+			const NUM_TYPE ind = window[k];
+			grid.ComputeCoord
+				(isovert.gcube_list[sortd_ind2gcube_list[ind]].cube_index, coord);
+			divide_coord_3D(cell_width, coord);
+
+			bool is_ready = true;
+			for (GRID_COORD_TYPE x0 = coord[0]-1; x0 <= coord[0]+1; x0++) {
+				if (x0 < 0 || x0 >= num_cells[0]) { continue; }
+				for (GRID_COORD_TYPE x1 = coord[1]-1; x1 <= coord[1]+1; x1++) {
+					if (x1 < 0 || x1 >= num_cells[1]) { continue; }
+					for (GRID_COORD_TYPE x2 = coord[2]-1; x2 <= coord[2]+1; x2++) {
+						if (x2 < 0 || x2 >= num_cells[2]) { continue; }
+						const VERTEX_INDEX jcell = 
+							x0 + num_cells[0]*(x1 + num_cells[1]*x2);
+						if (is_marked[jcell]) { is_ready = false; }
+					}
+				}
+			}
+
+			if (is_ready) { round_list.push_back(ind); }
+			else { not_ready.push_back(ind); }
+
+			const VERTEX_INDEX icell =
+				coord[0] + num_cells[0]*(coord[1] + num_cells[1]*coord[2]);
+			if (!is_marked[icell]) {
+				is_marked[icell] = true;
+				marked_list.push_back(icell);
+			}
+		}
+
+		const NUM_TYPE num_ready = num_window - NUM_TYPE(not_ready.size());
+		round_start.push_back(round_list.size());
+
+		for (NUM_TYPE k = 0; k < NUM_TYPE(marked_list.size()); k++)
+			{ is_marked[marked_list[k]] = false; }
+		marked_list.clear();
+
+		// Shrink the window if few scanned cubes are ready.
+		if (4*num_ready < num_window && window_size > MIN_WINDOW)
+			{ window_size = window_size/2; }
+		else if (2*num_ready > num_window && window_size < MAX_WINDOW)
+			{ window_size = 2*window_size; }
+
+		window.swap(not_ready);
+	}
+}
+
+
+/// Process sorted list indices in schedule order.
+/// @param process_index Function (ind, new_selected) which processes 
+///   sorted list index ind, appending selected cubes to new_selected.
+/// Selected cubes are inserted into bin_grid and selected_list
+///   after each index in serial schedules and after each round
+///   in parallel schedules.
+template <typename PROCESS_INDEX>
+void select_in_sorted_order
+	(const SHARPISO_GRID & grid, const SHARP_ISOVERT_PARAM & isovert_param,
+	const SELECTION_SCHEDULE & schedule,
+	BIN_GRID<VERTEX_INDEX> & bin_grid, vector<VERTEX_INDEX> & selected_list,
+	PROCESS_INDEX process_index)
+{
+	// Rounds smaller than MIN_THREAD_ROUND_SIZE are processed by
+	//   the calling thread.
+	const NUM_TYPE MIN_THREAD_ROUND_SIZE = 256;
+	const int bin_width = isovert_param.bin_width;
+	const NUM_TYPE num_threads = isovert_param.num_threads;
+	vector<VERTEX_INDEX> new_selected;
+
+	if (schedule.IsSerial()) {
+		for (NUM_TYPE ind = 0; ind < schedule.NumSorted(); ind++) {
+			new_selected.clear();
+			process_index(ind, new_selected);
+			for (NUM_TYPE i = 0; i < NUM_TYPE(new_selected.size()); i++) {
+				bin_grid_insert(grid, bin_width, new_selected[i], bin_grid);
+				selected_list.push_back(new_selected[i]);
+			}
+		}
+		return;
+	}
+
+	std::vector< vector<VERTEX_INDEX> > thread_selected(num_threads);
+	std::vector<std::thread> thread_list;
+	for (NUM_TYPE iround = 0; iround < schedule.NumRounds(); iround++) {
+		const NUM_TYPE kstart = schedule.RoundStart(iround);
+		const NUM_TYPE kend = schedule.RoundEnd(iround);
+		const NUM_TYPE round_size = kend - kstart;
+
+		NUM_TYPE num_round_threads = num_threads;
+		if (round_size < MIN_THREAD_ROUND_SIZE) { num_round_threads = 1; }
+
+		if (num_round_threads <= 1) {
+			thread_selected[0].clear();
+			for (NUM_TYPE k = kstart; k < kend; k++)
+				{ process_index(schedule.Index(k), thread_selected[0]); }
+		}
+		else {
+			for (NUM_TYPE i = 0; i < num_round_threads; i++) {
+				const NUM_TYPE k0 = kstart + (round_size*i)/num_round_threads;
+				const NUM_TYPE k1 = kstart + (round_size*(i+1))/num_round_threads;
+				vector<VERTEX_INDEX> & new_selected_i = thread_selected[i];
+				new_selected_i.clear();
+				thread_list.push_back
+					(std::thread([&schedule, &process_index, &new_selected_i, k0, k1] {
+						for (NUM_TYPE k = k0; k < k1; k++)
+							{ process_index(schedule.Index(k), new_selected_i); }
+					}));
+			}
+
+			for (NUM_TYPE i = 0; i < NUM_TYPE(thread_list.size()); i++)
+				{ thread_list[i].join(); }
+			thread_list.clear();
+		}
+
+		for (NUM_TYPE i = 0; i < num_round_threads; i++) {
+			for (NUM_TYPE j = 0; j < NUM_TYPE(thread_selected[i].size()); j++) {
+				bin_grid_insert(grid, bin_width, thread_selected[i][j], bin_grid);
+				selected_list.push_back(thread_selected[i][j]);
+			}
+		}
+	}
+}
+
 
+/// Select cube and mark its neighbors as covered.
+/// Append cube to new_selected.  Caller inserts cubes in new_selected
+///   into bin_grid.
 void select_vertex
 	(
 	const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	SHARPISO_BOOL_GRID &covered_grid,
-	BIN_GRID<VERTEX_INDEX> &bin_grid,
 	SHARPISO_GRID_NEIGHBORS &gridn,
 	const VERTEX_INDEX ind,
 	const SCALAR_TYPE isovalue,
 	const SHARP_ISOVERT_PARAM & isovert_param,
-	vector<NUM_TYPE> sortd_ind2gcube_list,
+	const vector<NUM_TYPE> & sortd_ind2gcube_list,
 	ISOVERT & isovert,
-	vector<VERTEX_INDEX> &selected_list,
+	vector<VERTEX_INDEX> &new_selected,
 	GRID_CUBE_FLAG flag
 	)
 {
-	const int bin_width = isovert_param.bin_width;
   const NUM_TYPE gcube_index = sortd_ind2gcube_list[ind];
   const VERTEX_INDEX cube_index = 
     isovert.gcube_list[gcube_index].cube_index;
 
   isovert.gcube_list[gcube_index].flag = SELECTED_GCUBE;
 
-  selected_list.push_back(cube_index);
+  new_selected.push_back(cube_index);
   covered_grid.Set(cube_index, true);
 
   // *** DEBUG ***
@@ -947,8 +1246,6 @@ void select_vertex
   }
   */
 
-  bin_grid_insert(scalar_grid, bin_width, cube_index, bin_grid);
-
   // mark all the neighbors as covered
   for (int i=0;i < gridn.NumVertexNeighborsC(); i++) {
     VERTEX_INDEX cube_index2 = gridn.VertexNeighborC(cube_index, i);
@@ -956,7 +1253,7 @@ void select_vertex
     covered_grid.Set(cube_index2, true);
 
     NUM_TYPE gcube_index2 = isovert.sharp_ind_grid.Scalar(cube_index2);
-    if(gcube_index2 != ISOVERT::NO_INDEX) {
+    if(gcube_index2 != ISOVERT::NO_INDEX && !isovert.IsFixed(gcube_index2)) {
       isovert.gcube_list[gcube_index2].flag = flag;
 
       if (isovert.gcube_list[gcube_index2].covered_by ==
@@ -971,14 +1268,14 @@ void check_and_select_vertex
 	(
 	const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	SHARPISO_BOOL_GRID &covered_grid,
-	BIN_GRID<VERTEX_INDEX> &bin_grid,
+	const BIN_GRID<VERTEX_INDEX> &bin_grid,
 	SHARPISO_GRID_NEIGHBORS &gridn,
 	const VERTEX_INDEX ind,
 	const SCALAR_TYPE isovalue,
 	const SHARP_ISOVERT_PARAM & isovert_param,
-	vector<NUM_TYPE> sortd_ind2gcube_list,
+	const vector<NUM_TYPE> & sortd_ind2gcube_list,
 	ISOVERT &isovert,
-	vector<VERTEX_INDEX> &selected_list,
+	vector<VERTEX_INDEX> &new_selected,
 	GRID_CUBE_FLAG flag
 	)
 {
@@ -1004,8 +1301,8 @@ void check_and_select_vertex
 
 	if (!triangle_flag) {
     select_vertex
-      (scalar_grid, covered_grid, bin_grid, gridn, ind, isovalue,
-       isovert_param, sortd_ind2gcube_list, isovert, selected_list, flag);
+      (scalar_grid, covered_grid, gridn, ind, isovalue,
+       isovert_param, sortd_ind2gcube_list, isovert, new_selected, flag);
 	}
 	else
 	{
@@ -1025,18 +1322,19 @@ void select_corners	(
 	SHARPISO_GRID_NEIGHBORS &gridn,
 	const SCALAR_TYPE isovalue,
 	const SHARP_ISOVERT_PARAM & isovert_param,
-	vector<NUM_TYPE> sortd_ind2gcube_list,
+	const vector<NUM_TYPE> & sortd_ind2gcube_list,
+	const SELECTION_SCHEDULE & schedule,
 	ISOVERT &isovert,
 	vector<VERTEX_INDEX> &selected_list)
 {
 	const COORD_TYPE linf_dist_threshold = 
 		isovert_param.linf_dist_thresh_merge_sharp;
-	const int bin_width = isovert_param.bin_width;
 
-	for (int ind=0; ind < sortd_ind2gcube_list.size(); ind++) {
+	select_in_sorted_order
+		(scalar_grid, isovert_param, schedule, bin_grid, selected_list,
+		[&](const NUM_TYPE ind, vector<VERTEX_INDEX> & new_selected) {
 
-		GRID_CUBE c;
-		c = isovert.gcube_list[sortd_ind2gcube_list[ind]];
+		const GRID_CUBE_CONST_REF c = isovert.gcube_list[sortd_ind2gcube_list[ind]];
 		// check boundary
 		if (c.boundary_bits == 0)
 			// select corners first
@@ -1045,9 +1343,9 @@ void select_corners	(
 				{
 					check_and_select_vertex
 						(scalar_grid, covered_grid, bin_grid, gridn, ind, isovalue, isovert_param, 
-             sortd_ind2gcube_list, isovert, selected_list, COVERED_CORNER_GCUBE );
+             sortd_ind2gcube_list, isovert, new_selected, COVERED_CORNER_GCUBE );
 				}
-	}
+	});
 
 }
 
@@ -1061,17 +1359,19 @@ void select_edges	(
 	SHARPISO_GRID_NEIGHBORS &gridn,
 	const SCALAR_TYPE isovalue,
 	const SHARP_ISOVERT_PARAM & isovert_param,
-	vector<NUM_TYPE> sortd_ind2gcube_list,
+	const vector<NUM_TYPE> & sortd_ind2gcube_list,
+	const SELECTION_SCHEDULE & schedule,
 	ISOVERT &isovert,
 	vector<VERTEX_INDEX> &selected_list)
 {
 	const COORD_TYPE linf_dist_threshold = 
 		isovert_param.linf_dist_thresh_merge_sharp;
-	const int bin_width = isovert_param.bin_width;
-	for (int ind=0; ind < sortd_ind2gcube_list.size(); ind++) {
 
-		GRID_CUBE c;
-		c = isovert.gcube_list[sortd_ind2gcube_list[ind]];
+	select_in_sorted_order
+		(scalar_grid, isovert_param, schedule, bin_grid, selected_list,
+		[&](const NUM_TYPE ind, vector<VERTEX_INDEX> & new_selected) {
+
+		const GRID_CUBE_CONST_REF c = isovert.gcube_list[sortd_ind2gcube_list[ind]];
 		// check boundary
 		if(c.boundary_bits == 0)
 			//select corners first
@@ -1080,9 +1380,9 @@ void select_edges	(
 				{
 					check_and_select_vertex
 						(scalar_grid, covered_grid, bin_grid, gridn, ind, isovalue, isovert_param, 
-						sortd_ind2gcube_list, isovert, selected_list, COVERED_A_GCUBE );
+						sortd_ind2gcube_list, isovert, new_selected, COVERED_A_GCUBE );
 				}
-	}
+	});
 }
 
 
@@ -1095,19 +1395,20 @@ void select_cubes_containing_covered_points	(
 	SHARPISO_GRID_NEIGHBORS &gridn,
 	const SCALAR_TYPE isovalue,
 	const SHARP_ISOVERT_PARAM & isovert_param,
-	vector<NUM_TYPE> sortd_ind2gcube_list,
+	const vector<NUM_TYPE> & sortd_ind2gcube_list,
+	const SELECTION_SCHEDULE & schedule,
 	ISOVERT &isovert,
 	vector<VERTEX_INDEX> &selected_list)
 {
 	const COORD_TYPE linf_dist_threshold = 
 		isovert_param.linf_dist_thresh_merge_sharp;
-	const int bin_width = isovert_param.bin_width;
-  VERTEX_INDEX cube_index1, cube_index2, cube_index3;
 
-	for (int ind=0; ind < sortd_ind2gcube_list.size(); ind++) {
+	select_in_sorted_order
+		(scalar_grid, isovert_param, schedule, bin_grid, selected_list,
+		[&](const NUM_TYPE ind, vector<VERTEX_INDEX> & new_selected) {
 
-		GRID_CUBE c;
-		c = isovert.gcube_list[sortd_ind2gcube_list[ind]];
+    VERTEX_INDEX cube_index1, cube_index2, cube_index3;
+		const GRID_CUBE_CONST_REF c = isovert.gcube_list[sortd_ind2gcube_list[ind]];
 
 		// check boundary
 		if(c.boundary_bits == 0) {
@@ -1153,9 +1454,9 @@ void select_cubes_containing_covered_points	(
                   */
 
                   select_vertex
-                    (scalar_grid, covered_grid, bin_grid, gridn, ind, 
+                    (scalar_grid, covered_grid, gridn, ind, 
                      isovalue, isovert_param, sortd_ind2gcube_list, isovert, 
-                     selected_list, COVERED_A_GCUBE );
+                     new_selected, COVERED_A_GCUBE );
                 }
               }
             }
@@ -1163,7 +1464,7 @@ void select_cubes_containing_covered_points	(
         }
       }
     }
-  }
+  });
 }
 
 
@@ -1246,40 +1547,89 @@ void select_near_corners	(
 	SHARPISO_GRID_NEIGHBORS &gridn,
 	const SCALAR_TYPE isovalue,
 	const SHARP_ISOVERT_PARAM & isovert_param,
-	vector<NUM_TYPE> sortd_ind2gcube_list,
+	const vector<NUM_TYPE> & sortd_ind2gcube_list,
+	const SELECTION_SCHEDULE & schedule,
 	ISOVERT &isovert,
 	vector<VERTEX_INDEX> &selected_list)
 {
-	const COORD_TYPE linf_dist_threshold = 
-		isovert_param.linf_dist_thresh_merge_sharp;
-	const int bin_width = isovert_param.bin_width;
-
-
-	for (int ind=0; ind < sortd_ind2gcube_list.size(); ind++) {
+	select_in_sorted_order
+		(scalar_grid, isovert_param, schedule, bin_grid, selected_list,
+		[&](const NUM_TYPE ind, vector<VERTEX_INDEX> & new_selected) {
 
-		GRID_CUBE c;
-		c = isovert.gcube_list[sortd_ind2gcube_list[ind]];
+		const GRID_CUBE_CONST_REF c = isovert.gcube_list[sortd_ind2gcube_list[ind]];
 
     if (isovert.isFlag(cube_ind_frm_gc_ind(isovert, sortd_ind2gcube_list[ind]), AVAILABLE_GCUBE)) {
 
       // check boundary
       if(c.boundary_bits == 0 && c.linf_dist <= 0.5 ) {
         bool flag = is_neighbor(c, scalar_grid, gridn,  isovert,  COVERED_CORNER_GCUBE );
-        VERTEX_INDEX neighbor_cube_index;
         if(flag)
           check_and_select_vertex
             (scalar_grid, covered_grid, bin_grid, gridn, ind, isovalue, isovert_param, 
-             sortd_ind2gcube_list, isovert, selected_list, COVERED_A_GCUBE );
+             sortd_ind2gcube_list, isovert, new_selected, COVERED_A_GCUBE );
       }
     }
-	}
+	});
 }
 
 // Set gcube_list[i].covered_by to gcube_list[i].cube_index for each i.
+// Fixed cubes keep their covered_by.
 void initialize_covered_by(ISOVERT & isovert)
 {
-  for (NUM_TYPE i = 0; i < isovert.gcube_list.size(); i++) 
-    { isovert.gcube_list[i].covered_by = isovert.gcube_list[i].cube_index; }
+  for (NUM_TYPE i = 0; i < isovert.gcube_list.size(); i++) {
+    if (!isovert.IsFixed(i)) 
+      { isovert.gcube_list[i].covered_by = isovert.gcube_list[i].cube_index; }
+  }
+}
+
+
+// Mark cubes covered by fixed cubes in covered_grid.
+// Insert fixed selected cubes into bin_grid and selected_list
+//   and cover their neighbors, as in select_vertex.
+void select_fixed_vertices
+	(
+	const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	SHARPISO_BOOL_GRID &covered_grid,
+	BIN_GRID<VERTEX_INDEX> &bin_grid,
+	SHARPISO_GRID_NEIGHBORS &gridn,
+	const SHARP_ISOVERT_PARAM & isovert_param,
+	ISOVERT &isovert,
+	vector<VERTEX_INDEX> &selected_list)
+{
+	const int bin_width = isovert_param.bin_width;
+
+	for (NUM_TYPE i = 0; i < isovert.gcube_list.size(); i++) {
+
+		if (!isovert.IsFixed(i)) { continue; }
+
+		const GRID_CUBE_CONST_REF c = isovert.gcube_list[i];
+		if (c.IsCoveredOrSelected())
+			{ covered_grid.Set(c.cube_index, true); }
+
+		if (c.flag != SELECTED_GCUBE || c.boundary_bits != 0) { continue; }
+
+		bin_grid_insert(scalar_grid, bin_width, c.cube_index, bin_grid);
+		selected_list.push_back(c.cube_index);
+
+		GRID_CUBE_FLAG flag = COVERED_A_GCUBE;
+		if (c.num_eigenvalues > 2) { flag = COVERED_CORNER_GCUBE; }
+
+		for (int k = 0; k < gridn.NumVertexNeighborsC(); k++) {
+			VERTEX_INDEX cube_index2 = gridn.VertexNeighborC(c.cube_index, k);
+
+			covered_grid.Set(cube_index2, true);
+
+			INDEX_DIFF_TYPE gcube_index2 = isovert.sharp_ind_grid.Scalar(cube_index2);
+			if (gcube_index2 != ISOVERT::NO_INDEX && !isovert.IsFixed(gcube_index2)) {
+				isovert.gcube_list[gcube_index2].flag = flag;
+
+				if (isovert.gcube_list[gcube_index2].covered_by ==
+					isovert.gcube_list[gcube_index2].cube_index) {
+						isovert.gcube_list[gcube_index2].covered_by = c.cube_index;
+				}
+			}
+		}
+	}
 }
 
 
@@ -1291,13 +1641,21 @@ void select_3x3x3_regions
 	const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	const SCALAR_TYPE isovalue,
 	const SHARP_ISOVERT_PARAM & isovert_param,
-	vector<NUM_TYPE> sortd_ind2gcube_list,
+	const vector<NUM_TYPE> & sortd_ind2gcube_list,
 	ISOVERT & isovert)
 {
 	const int dimension = scalar_grid.Dimension();
 	const int bin_width = isovert_param.bin_width;
 
-
+	SELECTION_SCHEDULE schedule;
+	if (isovert_param.num_threads > 1) {
+		schedule.Set
+			(scalar_grid, isovert, sortd_ind2gcube_list,
+			isovert_param.linf_dist_thresh_merge_sharp);
+	}
+	else {
+		schedule.SetSerial(sortd_ind2gcube_list.size());
+	}
 
 	BIN_GRID<VERTEX_INDEX> bin_grid;
 	init_bin_grid(scalar_grid, bin_width, bin_grid);
@@ -1315,25 +1673,29 @@ void select_3x3x3_regions
 	covered_grid.SetSize(scalar_grid);
 	covered_grid.SetAll(false);
 
+	// cubes selected or covered in a neighboring slab
+	select_fixed_vertices
+    (scalar_grid, covered_grid, bin_grid, gridn, isovert_param, isovert, selected_list);
+
 	// pick corners
 	select_corners
     (scalar_grid, covered_grid, bin_grid, gridn, isovalue, isovert_param, 
-     sortd_ind2gcube_list, isovert, selected_list);
+     sortd_ind2gcube_list, schedule, isovert, selected_list);
 
 	// pick near corners
 	select_near_corners
     (scalar_grid, covered_grid, bin_grid, gridn, isovalue, isovert_param, 
-     sortd_ind2gcube_list, isovert, selected_list);
+     sortd_ind2gcube_list, schedule, isovert, selected_list);
 
 	// pick points on edges
 	select_edges
     (scalar_grid, covered_grid, bin_grid, gridn, isovalue, isovert_param, 
-     sortd_ind2gcube_list, isovert, selected_list);
+     sortd_ind2gcube_list, schedule, isovert, selected_list);
 
   // pick points in cubes previously identified as covered points.
   select_cubes_containing_covered_points
     (scalar_grid, covered_grid, bin_grid, gridn, isovalue, isovert_param, 
-     sortd_ind2gcube_list, isovert, selected_list);
+     sortd_ind2gcube_list, schedule, isovert, selected_list);
 }
 
 /**
@@ -1345,7 +1707,7 @@ void select_3x3x3_regions_old
 	const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	const SCALAR_TYPE isovalue,
 	const SHARP_ISOVERT_PARAM & isovert_param,
-	vector<NUM_TYPE> sortd_ind2gcube_list,
+	const vector<NUM_TYPE> & sortd_ind2gcube_list,
 	ISOVERT &isovert)
 {
 	const int dimension = scalar_grid.Dimension();
@@ -1606,9 +1968,12 @@ void create_active_cubes (
 	const SCALAR_TYPE isovalue,
 	ISOVERT &isovert)
 {
+	IJK_PROFILE_SCOPE(active_cubes_timer, "create_active_cubes");
 	NUM_TYPE index = 0;
 	//set the size of sharp index grid
 	isovert.sharp_ind_grid.SetSize(scalar_grid);
+	// vertices on the upper grid boundary are not primary vertices of cubes
+	isovert.sharp_ind_grid.SetAll(ISOVERT::NO_INDEX);
 	IJK_FOR_EACH_GRID_CUBE(iv, scalar_grid, VERTEX_INDEX)
 	{
 		if (is_gt_cube_min_le_cube_max(scalar_grid, iv, isovalue))
@@ -1626,6 +1991,99 @@ void create_active_cubes (
 		}
 	}
 }
+
+/**
+Sets the sharp_ind_grid and gcube_list using the min and max
+  scalar values of grid regions.
+
+Cubes in regions whose scalar range does not contain the isovalue
+  are not tested.  Active cubes are stored in gcube_list in increasing
+  order of cube index, as in create_active_cubes(scalar_grid,...).
+If minmax_regions.RegionEdgeLength() is 0, scan all grid cubes.
+*/
+void create_active_cubes (
+	const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const SHARPISO_MINMAX_REGIONS & minmax_regions,
+	const SCALAR_TYPE isovalue,
+	ISOVERT &isovert)
+{
+	const AXIS_SIZE_TYPE region_edge_length = 
+		minmax_regions.RegionEdgeLength();
+	const AXIS_SIZE_TYPE * axis_size = scalar_grid.AxisSize();
+	const AXIS_SIZE_TYPE * num_regions = minmax_regions.AxisSize();
+	std::vector<VERTEX_INDEX> active_cube;
+	AXIS_SIZE_TYPE cube_min[DIM3], cube_max[DIM3];
+	IJK::PROCEDURE_ERROR error("create_active_cubes");
+
+	if (region_edge_length < 1 || scalar_grid.Dimension() != DIM3) {
+		create_active_cubes(scalar_grid, isovalue, isovert);
+		return;
+	}
+
+	IJK_PROFILE_SCOPE(active_cubes_timer, "create_active_cubes");
+
+	if (minmax_regions.Dimension() != DIM3) {
+		error.AddMessage("Programming error. Dimension of minmax regions ",
+			minmax_regions.Dimension(), " does not match grid dimension ",
+			DIM3, ".");
+		throw error;
+	}
+
+	for (int d = 0; d < DIM3; d++) {
+		if (num_regions[d] != compute_num_regions_along_axis
+			(axis_size[d], region_edge_length)) {
+				error.AddMessage
+					("Programming error. Minmax regions do not match scalar grid.");
+				error.AddMessage("  Recompute minmax regions after setting scalar grid.");
+				throw error;
+		}
+	}
+
+	NUM_TYPE iregion = 0;
+	for (AXIS_SIZE_TYPE rz = 0; rz < num_regions[2]; rz++) {
+		for (AXIS_SIZE_TYPE ry = 0; ry < num_regions[1]; ry++) {
+			for (AXIS_SIZE_TYPE rx = 0; rx < num_regions[0]; rx++) {
+
+				if (minmax_regions.Min(iregion) < isovalue &&
+					isovalue <= minmax_regions.Max(iregion)) {
+
+					const AXIS_SIZE_TYPE rcoord[DIM3] = { rx, ry, rz };
+					for (int d = 0; d < DIM3; d++) {
+						cube_min[d] = rcoord[d]*region_edge_length;
+						cube_max[d] = 
+							std::min(cube_min[d]+region_edge_length, axis_size[d]-1);
+					}
+
+					for (AXIS_SIZE_TYPE z = cube_min[2]; z < cube_max[2]; z++) {
+						for (AXIS_SIZE_TYPE y = cube_min[1]; y < cube_max[1]; y++) {
+							VERTEX_INDEX iv = 
+								cube_min[0] + axis_size[0]*(y + axis_size[1]*z);
+							for (AXIS_SIZE_TYPE x = cube_min[0]; x < cube_max[0]; 
+								x++, iv++) {
+									if (is_gt_cube_min_le_cube_max(scalar_grid, iv, isovalue))
+									{ active_cube.push_back(iv); }
+							}
+						}
+					}
+				}
+
+				iregion++;
+			}
+		}
+	}
+
+	std::sort(active_cube.begin(), active_cube.end());
+
+	isovert.sharp_ind_grid.SetSize(scalar_grid);
+	isovert.sharp_ind_grid.SetAll(ISOVERT::NO_INDEX);
+	isovert.gcube_list.reserve(isovert.gcube_list.size()+active_cube.size());
+	for (NUM_TYPE i = 0; i < NUM_TYPE(active_cube.size()); i++) {
+		GRID_CUBE gc;
+		gc.cube_index = active_cube[i];
+		isovert.sharp_ind_grid.Set(active_cube[i], isovert.gcube_list.size());
+		isovert.gcube_list.push_back(gc);
+	}
+}
 /// Compute the overlap region between two cube indices
 bool find_overlap(
 	const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
@@ -1671,6 +2129,7 @@ void process_edge(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 */
 void MERGESHARP::compute_dual_isovert
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const SHARPISO_MINMAX_REGIONS & minmax_regions,
 	const GRADIENT_GRID_BASE & gradient_grid,
 	const SCALAR_TYPE isovalue,
 	const SHARP_ISOVERT_PARAM & isovert_param,
@@ -1684,7 +2143,7 @@ void MERGESHARP::compute_dual_isovert
 		(scalar_grid, "gradient grid", "scalar grid", error))
 	{ throw error; }
 
-	create_active_cubes(scalar_grid, isovalue, isovert);
+	create_active_cubes(scalar_grid, minmax_regions, isovalue, isovert);
 
 	if (vertex_position_method == GRADIENT_POSITIONING) {
 		compute_isovert_positions 
@@ -1705,9 +2164,19 @@ void MERGESHARP::select_sharp_isovert
 	const SHARP_ISOVERT_PARAM & isovert_param,
 	ISOVERT & isovert)
 {
+	IJK_PROFILE_SCOPE(select_timer, "select_sharp_isovert");
+
 	// keep track of the sorted indices
 	std::vector<NUM_TYPE> sortd_ind2gcube_list;
 	sort_gcube_list(isovert.gcube_list, sortd_ind2gcube_list);
+
+	// Fixed cubes are not selected again.
+	if (!isovert.fixed_gcube.empty()) {
+		sortd_ind2gcube_list.erase
+			(std::remove_if(sortd_ind2gcube_list.begin(), sortd_ind2gcube_list.end(),
+			[&isovert](const NUM_TYPE i) { return(isovert.IsFixed(i)); }),
+			sortd_ind2gcube_list.end());
+	}
 	//DEBUG 
 	//for (int i = 0; i < sortd_ind2gcube_list.size(); i++)
 	//{
@@ -1778,7 +2247,7 @@ void MERGESHARP::store_table_index
 {
 	IJK::PROCEDURE_ERROR error("store_table_index");
 
-	if (table_index.size() != gcube_list.size()) {
+	if (NUM_TYPE(table_index.size()) != gcube_list.size()) {
 		error.AddMessage("Programming error.  Numbers of elements in table_index and gcube_list differ.");
 		error.AddMessage("  table_index.size() = ", table_index.size(), ".");
 		error.AddMessage("  gcube_list.size() = ", gcube_list.size(), ".");
@@ -1802,6 +2271,50 @@ bool GRID_CUBE::IsCoveredOrSelected() const
     { return false; }
 }
 
+// **************************************************
+// GRID_CUBE_ARRAY member functions
+// **************************************************
+
+void GRID_CUBE_ARRAY::clear()
+{
+	isovert_coord.clear();
+	num_eigenvalues.clear();
+	flag.clear();
+	boundary_bits.clear();
+	cube_index.clear();
+	linf_dist.clear();
+	flag_centroid_location.clear();
+	table_index.clear();
+	covered_by.clear();
+}
+
+void GRID_CUBE_ARRAY::reserve(const NUM_TYPE n)
+{
+	isovert_coord.reserve(DIM3*n);
+	num_eigenvalues.reserve(n);
+	flag.reserve(n);
+	boundary_bits.reserve(n);
+	cube_index.reserve(n);
+	linf_dist.reserve(n);
+	flag_centroid_location.reserve(n);
+	table_index.reserve(n);
+	covered_by.reserve(n);
+}
+
+void GRID_CUBE_ARRAY::push_back(const GRID_CUBE & gcube)
+{
+	isovert_coord.insert
+		(isovert_coord.end(), gcube.isovert_coord, gcube.isovert_coord+DIM3);
+	num_eigenvalues.push_back(gcube.num_eigenvalues);
+	flag.push_back(gcube.flag);
+	boundary_bits.push_back(gcube.boundary_bits);
+	cube_index.push_back(gcube.cube_index);
+	linf_dist.push_back(gcube.linf_dist);
+	flag_centroid_location.push_back(gcube.flag_centroid_location);
+	table_index.push_back(gcube.table_index);
+	covered_by.push_back(gcube.covered_by);
+}
+
 // **************************************************
 // ISOVERT member functions
 // **************************************************
@@ -1824,6 +2337,86 @@ bool ISOVERT::isActive(const int cube_index){
 		return false;
 }
 
+// **************************************************
+// GCUBE_INDEX_GRID member functions
+// **************************************************
+
+const int GCUBE_INDEX_GRID::NO_INDEX;
+
+void GCUBE_INDEX_GRID::SetSparse(const bool flag)
+{
+	flag_sparse = flag;
+	dense_index.clear();
+	sparse_cube.clear();
+	sparse_index.clear();
+	if (!flag_sparse) { dense_index.assign(NumVertices(), NO_INDEX); }
+}
+
+void GCUBE_INDEX_GRID::SetSize(const SHARPISO_GRID & grid)
+{
+	SHARPISO_GRID::SetSize(grid.Dimension(), grid.AxisSize());
+	SetSparse(flag_sparse);
+}
+
+void GCUBE_INDEX_GRID::SetAll(const INDEX_DIFF_TYPE index)
+{
+	IJK::PROCEDURE_ERROR error("GCUBE_INDEX_GRID::SetAll");
+
+	if (flag_sparse) {
+		if (index != NO_INDEX) {
+			error.AddMessage
+				("Programming error. Sparse index grid can only set all indices to NO_INDEX.");
+			throw error;
+		}
+		sparse_cube.clear();
+		sparse_index.clear();
+	}
+	else {
+		std::fill(dense_index.begin(), dense_index.end(), index);
+	}
+}
+
+INDEX_DIFF_TYPE GCUBE_INDEX_GRID::SparseScalar(const VERTEX_INDEX iv) const
+{
+	std::vector<VERTEX_INDEX>::const_iterator pos =
+		std::lower_bound(sparse_cube.begin(), sparse_cube.end(), iv);
+
+	if (pos != sparse_cube.end() && *pos == iv) 
+	{ return(sparse_index[pos-sparse_cube.begin()]); }
+	else
+	{ return(NO_INDEX); }
+}
+
+// Cubes are usually set in increasing order, so check the end first.
+void GCUBE_INDEX_GRID::SparseSet
+	(const VERTEX_INDEX iv, const INDEX_DIFF_TYPE index)
+{
+	if (sparse_cube.empty() || iv > sparse_cube.back()) {
+		if (index != NO_INDEX) {
+			sparse_cube.push_back(iv);
+			sparse_index.push_back(index);
+		}
+		return;
+	}
+
+	std::vector<VERTEX_INDEX>::iterator pos =
+		std::lower_bound(sparse_cube.begin(), sparse_cube.end(), iv);
+	const NUM_TYPE k = pos - sparse_cube.begin();
+
+	if (*pos == iv) {
+		if (index == NO_INDEX) {
+			sparse_cube.erase(pos);
+			sparse_index.erase(sparse_index.begin()+k);
+		}
+		else 
+		{ sparse_index[k] = index; }
+	}
+	else if (index != NO_INDEX) {
+		sparse_cube.insert(pos, iv);
+		sparse_index.insert(sparse_index.begin()+k, index);
+	}
+}
+
 // **************************************************
 // ISOVERT_INFO member functions
 // **************************************************
@@ -2101,6 +2694,7 @@ namespace {
    const VERTEX_INDEX cube_index0, const VERTEX_INDEX cube_index1)
   {
     VERTEX_INDEX gcube_index;
+    int boundary_bits;
 
     gcube_index = isovert.sharp_ind_grid.Scalar(cube_index0);
     if (gcube_index != ISOVERT::NO_INDEX) {
@@ -2108,7 +2702,10 @@ namespace {
       if (covered_by == cube_index1) { return(true); }
     }
 
-    if (isovert.gcube_list[gcube_index].boundary_bits == 0) {
+    // cube_index0 may not be active, so compute boundary bits from grid.
+    grid.ComputeBoundaryCubeBits(cube_index0, boundary_bits);
+
+    if (boundary_bits == 0) {
 
       for (NUM_TYPE j = 0; j < grid.NumVertexNeighborsC(); j++) {
         VERTEX_INDEX icube = grid.VertexNeighborC(cube_index0, j);
@@ -21,7 +21,8 @@ namespace MERGESHARP {
 // GRID CUBES INFORMATION
 // **************************************************
 
-typedef enum {
+/// Grid cube flag.  Stored in one byte.
+typedef enum : unsigned char {
 	AVAILABLE_GCUBE,    ///< Cube is available. is a sharp vertex. 
 						/// num_large_eigenvalues > 1 && svd_info.location == LOC_SVD
 	SELECTED_GCUBE,     ///< Cube contains a sharp vertex.
@@ -37,12 +38,16 @@ typedef enum {
 } GRID_CUBE_FLAG;
 
 
+/// Boundary bits of a grid cube.  Bits 2d and 2d+1 are set if
+///   the cube is on the lower or upper boundary orthogonal to axis d.
+typedef unsigned char GCUBE_BOUNDARY_BITS_TYPE;
+
 class GRID_CUBE {
 public:
 	COORD_TYPE isovert_coord[DIM3]; ///< Location of the sharp isovertex.
 	unsigned char num_eigenvalues;  ///< Number of eigenvalues.
 	GRID_CUBE_FLAG flag;            ///< Type for this cube.
-	int boundary_bits;              ///< Boundary bits for the cube
+	GCUBE_BOUNDARY_BITS_TYPE boundary_bits; ///< Boundary bits for the cube
 	VERTEX_INDEX cube_index;        ///< Index of cube in scalar grid.
 
   /// Linf-dist from isovert_coord[] to cube-center.
@@ -61,7 +66,218 @@ public:
   bool IsCoveredOrSelected() const;
 };
 
-typedef std::vector<GRID_CUBE> GRID_CUBE_ARRAY;
+
+/// Reference to the fields of one grid cube in a GRID_CUBE_ARRAY.
+/// Fields have the same names as the fields of GRID_CUBE,
+///   so gcube_list[i].flag, gcube_list[i].cube_index, etc.
+///   read and write the arrays of GRID_CUBE_ARRAY.
+/// GRID_CUBE_REF and GRID_CUBE_CONST_REF are instantiations
+///   with non-const and const field types.
+template <typename CTYPE, typename UCTYPE, typename FTYPE,
+          typename BTYPE, typename VTYPE, typename TTYPE>
+class GRID_CUBE_REF_T {
+public:
+	CTYPE * const isovert_coord;
+	UCTYPE & num_eigenvalues;
+	FTYPE & flag;
+	BTYPE & boundary_bits;
+	VTYPE & cube_index;
+	CTYPE & linf_dist;
+	UCTYPE & flag_centroid_location;
+	TTYPE & table_index;
+	VTYPE & covered_by;
+
+	GRID_CUBE_REF_T
+	(CTYPE * isovert_coord, UCTYPE & num_eigenvalues, FTYPE & flag,
+	 BTYPE & boundary_bits, VTYPE & cube_index, CTYPE & linf_dist,
+	 UCTYPE & flag_centroid_location, TTYPE & table_index,
+	 VTYPE & covered_by):
+		isovert_coord(isovert_coord), num_eigenvalues(num_eigenvalues),
+		flag(flag), boundary_bits(boundary_bits), cube_index(cube_index),
+		linf_dist(linf_dist), flag_centroid_location(flag_centroid_location),
+		table_index(table_index), covered_by(covered_by) {};
+
+	/// Constructor from a reference with less qualified fields.
+	/// Converts GRID_CUBE_REF to GRID_CUBE_CONST_REF.
+	template <typename CTYPE2, typename UCTYPE2, typename FTYPE2,
+	          typename BTYPE2, typename VTYPE2, typename TTYPE2>
+	GRID_CUBE_REF_T
+	(const GRID_CUBE_REF_T<CTYPE2,UCTYPE2,FTYPE2,BTYPE2,VTYPE2,TTYPE2> & ref):
+		isovert_coord(ref.isovert_coord), num_eigenvalues(ref.num_eigenvalues),
+		flag(ref.flag), boundary_bits(ref.boundary_bits),
+		cube_index(ref.cube_index), linf_dist(ref.linf_dist),
+		flag_centroid_location(ref.flag_centroid_location),
+		table_index(ref.table_index), covered_by(ref.covered_by) {};
+
+	/// Return true if cube is covered or selected.
+	bool IsCoveredOrSelected() const
+	{
+		return(flag == COVERED_A_GCUBE || flag == COVERED_B_GCUBE ||
+		       flag == COVERED_CORNER_GCUBE || flag == SELECTED_GCUBE);
+	}
+
+	/// Return copy of grid cube.
+	operator GRID_CUBE() const
+	{
+		GRID_CUBE gcube;
+		for (int d = 0; d < DIM3; d++)
+		{ gcube.isovert_coord[d] = isovert_coord[d]; }
+		gcube.num_eigenvalues = num_eigenvalues;
+		gcube.flag = flag;
+		gcube.boundary_bits = boundary_bits;
+		gcube.cube_index = cube_index;
+		gcube.linf_dist = linf_dist;
+		gcube.flag_centroid_location = flag_centroid_location;
+		gcube.table_index = table_index;
+		gcube.covered_by = covered_by;
+		return(gcube);
+	}
+};
+
+typedef GRID_CUBE_REF_T
+<COORD_TYPE, unsigned char, GRID_CUBE_FLAG, GCUBE_BOUNDARY_BITS_TYPE,
+ VERTEX_INDEX, IJKDUALTABLE::TABLE_INDEX> GRID_CUBE_REF;
+typedef GRID_CUBE_REF_T
+<const COORD_TYPE, const unsigned char, const GRID_CUBE_FLAG,
+ const GCUBE_BOUNDARY_BITS_TYPE, const VERTEX_INDEX,
+ const IJKDUALTABLE::TABLE_INDEX> GRID_CUBE_CONST_REF;
+
+
+/// List of grid cubes stored as a structure of arrays.
+/// Selection and merging loops mostly read flag, cube_index and
+///   boundary_bits, so each field is stored in its own array.
+///   Flags and boundary bits take one byte per cube.
+/// operator[] returns a GRID_CUBE_REF whose fields reference
+///   the entries of the arrays.
+class GRID_CUBE_ARRAY {
+
+protected:
+	std::vector<COORD_TYPE> isovert_coord;
+	std::vector<unsigned char> num_eigenvalues;
+	std::vector<GRID_CUBE_FLAG> flag;
+	std::vector<GCUBE_BOUNDARY_BITS_TYPE> boundary_bits;
+	std::vector<VERTEX_INDEX> cube_index;
+	std::vector<COORD_TYPE> linf_dist;
+	std::vector<unsigned char> flag_centroid_location;
+	std::vector<IJKDUALTABLE::TABLE_INDEX> table_index;
+	std::vector<VERTEX_INDEX> covered_by;
+
+public:
+
+	/// Return number of grid cubes.
+	NUM_TYPE size() const { return(cube_index.size()); }
+
+	/// Return true if list is empty.
+	bool empty() const { return(cube_index.empty()); }
+
+	/// Remove all grid cubes.
+	void clear();
+
+	/// Reserve space for n grid cubes.
+	void reserve(const NUM_TYPE n);
+
+	/// Add grid cube to end of list.
+	void push_back(const GRID_CUBE & gcube);
+
+	/// Return reference to grid cube i.
+	GRID_CUBE_REF operator[](const NUM_TYPE i)
+	{
+		return(GRID_CUBE_REF
+		       (&(isovert_coord[DIM3*i]), num_eigenvalues[i], flag[i],
+		        boundary_bits[i], cube_index[i], linf_dist[i],
+		        flag_centroid_location[i], table_index[i], covered_by[i]));
+	}
+
+	/// Return const reference to grid cube i.
+	GRID_CUBE_CONST_REF operator[](const NUM_TYPE i) const
+	{
+		return(GRID_CUBE_CONST_REF
+		       (&(isovert_coord[DIM3*i]), num_eigenvalues[i], flag[i],
+		        boundary_bits[i], cube_index[i], linf_dist[i],
+		        flag_centroid_location[i], table_index[i], covered_by[i]));
+	}
+
+	/// Return flag of grid cube i.
+	GRID_CUBE_FLAG Flag(const NUM_TYPE i) const { return(flag[i]); }
+
+	/// Return cube index of grid cube i.
+	VERTEX_INDEX CubeIndex(const NUM_TYPE i) const { return(cube_index[i]); }
+
+	/// Return pointer to array of cube indices of all grid cubes.
+	const VERTEX_INDEX * CubeIndexPtrConst() const
+	{ return(&(cube_index.front())); }
+
+	/// Return boundary bits of grid cube i.
+	GCUBE_BOUNDARY_BITS_TYPE BoundaryBits(const NUM_TYPE i) const
+	{ return(boundary_bits[i]); }
+
+	/// Return number of eigenvalues of grid cube i.
+	unsigned char NumEigenvalues(const NUM_TYPE i) const
+	{ return(num_eigenvalues[i]); }
+
+	/// Return Linf distance from isovert_coord to center of grid cube i.
+	COORD_TYPE LinfDist(const NUM_TYPE i) const { return(linf_dist[i]); }
+};
+
+// **************************************************
+// GRID CUBE INDEX
+// **************************************************
+
+/// Index into gcube_list of each grid cube.
+/// Dense storage has one entry per grid vertex.
+/// Sparse storage is a list of (cube index, gcube index) pairs,
+///   sorted by cube index and searched with binary search.
+///   Memory is proportional to the number of active cubes.
+/// Cubes which are not set have index NO_INDEX.
+class GCUBE_INDEX_GRID:public SHARPISO_GRID {
+
+protected:
+	bool flag_sparse;
+
+	/// Dense storage.  dense_index[iv] = gcube index of cube iv.
+	std::vector<INDEX_DIFF_TYPE> dense_index;
+
+	/// Sparse storage.  Sorted list of cubes with a gcube index.
+	std::vector<VERTEX_INDEX> sparse_cube;
+
+	/// Sparse storage.  sparse_index[k] = gcube index of sparse_cube[k].
+	std::vector<INDEX_DIFF_TYPE> sparse_index;
+
+	INDEX_DIFF_TYPE SparseScalar(const VERTEX_INDEX iv) const;
+	void SparseSet(const VERTEX_INDEX iv, const INDEX_DIFF_TYPE index);
+
+public:
+	static const int NO_INDEX = -1;       ///< Flag for no index.
+
+	GCUBE_INDEX_GRID() { flag_sparse = false; };
+
+	/// Use sparse storage if flag is true.  Clears all indices.
+	void SetSparse(const bool flag);
+
+	/// Set grid size.  All cubes have index NO_INDEX.
+	void SetSize(const SHARPISO_GRID & grid);
+
+	/// Set index of all cubes to NO_INDEX.
+	/// Dense storage also allows any other index.
+	void SetAll(const INDEX_DIFF_TYPE index);
+
+	/// Set gcube index of cube iv.
+	void Set(const VERTEX_INDEX iv, const INDEX_DIFF_TYPE index)
+	{
+		if (flag_sparse) { SparseSet(iv, index); }
+		else { dense_index[iv] = index; }
+	}
+
+	/// Return true if storage is sparse.
+	bool IsSparse() const { return(flag_sparse); };
+
+	/// Return gcube index of cube iv.
+	INDEX_DIFF_TYPE Scalar(const VERTEX_INDEX iv) const
+	{
+		if (flag_sparse) { return(SparseScalar(iv)); }
+		else { return(dense_index[iv]); }
+	}
+};
 
 // **************************************************
 // ISOSURFACE VERTEX DATA
@@ -71,13 +287,29 @@ class ISOVERT {
 public:
 
 	/// gcube_list containing the active cubes and their vertices.
-	std::vector<GRID_CUBE> gcube_list;
+	GRID_CUBE_ARRAY gcube_list;
 
-	static const int NO_INDEX = -1;       ///< Flag for no index.
+	/// Flag for no index.
+	static const int NO_INDEX = GCUBE_INDEX_GRID::NO_INDEX;
 
 	/// Grid containing the index to the gcube_list.
 	/// If cube is not active, then it is defined as NO_INDEX.
-	SHARPISO_INDEX_GRID sharp_ind_grid;
+	GCUBE_INDEX_GRID sharp_ind_grid;
+
+	/// fixed_gcube[i] is true if the flag, covered_by and merge of
+	///   gcube_list[i] were decided by the caller, e.g. in a neighboring slab.
+	/// Selection and merging do not change fixed cubes.
+	/// Empty if no cubes are fixed.
+	std::vector<bool> fixed_gcube;
+
+	/// If gcube_list[i] is fixed, it merges into gcube_list[fixed_gcube_map[i]]
+	///   and its flag after merging is fixed_merge_flag[i].
+	std::vector<NUM_TYPE> fixed_gcube_map;
+	std::vector<GRID_CUBE_FLAG> fixed_merge_flag;
+
+	/// Return true if gcube_list[gcube_index] is fixed.
+	bool IsFixed(const NUM_TYPE gcube_index) const
+	{ return(!fixed_gcube.empty() && fixed_gcube[gcube_index]); }
 
   /// Return true if cube is active.
 	bool isActive(const int cube_index);
@@ -119,8 +351,12 @@ public:
 // **************************************************
 
 /// Compute dual isosurface vertices.
+/// Use minmax_regions to skip grid regions which do not intersect
+///   the isosurface.  If minmax_regions.RegionEdgeLength() is 0,
+///   scan all grid cubes.
 void compute_dual_isovert
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SHARPISO_MINMAX_REGIONS & minmax_regions,
    const GRADIENT_GRID_BASE & gradient_grid,
    const SCALAR_TYPE isovalue,
    const SHARP_ISOVERT_PARAM & isovert_param,
@@ -220,7 +456,7 @@ void init_bin_grid
 /// Insert cube cube_index into the bin_grid.
 void bin_grid_insert
 (const SHARPISO_GRID & grid, const AXIS_SIZE_TYPE bin_width,
- const VERTEX_INDEX cube_index, BIN_GRID<int> & bin_grid);
+ const VERTEX_INDEX cube_index, BIN_GRID<VERTEX_INDEX> & bin_grid);
 
 /// Sort elements of gcube list with more than one eigenvalue.
 /// @param gcube_list List of grid cubes intersected by the isosurface.
@@ -229,7 +465,7 @@ void bin_grid_insert
 ///             Then, sorted by increasing linf_dist.
 ///             Grid cubes with one eigenvalue are ignored.
 void sort_gcube_list
-(const std::vector<GRID_CUBE> & gcube_list,
+(const GRID_CUBE_ARRAY & gcube_list,
  std::vector<NUM_TYPE> & sortd_ind2gcube_list);
 
 /// Store boundary bits for each cube in gcube_list.
@@ -21,14 +21,19 @@
 */
 
 
+#include <chrono>
 #include <iostream>
 
 #include "mergesharpIO.h"
 #include "mergesharp.h"
+#include "mergesharp_gradient.h"
+#include "mergesharp_multi_isovalue.h"
+#include "mergesharp_slab.h"
 
 #include "ijkmesh.txx"
 #include "ijkmesh_cpp11.txx"
 #include "ijkmesh_geom.txx"
+#include "ijkprofile.txx"
 
 using namespace IJK;
 using namespace MERGESHARP;
@@ -40,6 +45,30 @@ void memory_exhaustion();
 void construct_isosurface
 (const INPUT_INFO & input_info, const MERGESHARP_DATA & mergesharp_data,
  MERGESHARP_TIME & mergesharp_time, IO_TIME & io_time);
+void construct_isosurface_slab
+(const INPUT_INFO & input_info, const MERGESHARP_DATA & mergesharp_data,
+ const SHARPISO_GRID & full_grid, const SET_SLAB_FUNCTION & set_slab,
+ MERGESHARP_TIME & mergesharp_time, IO_TIME & io_time);
+bool map_first_slab
+(const char * scalar_filename, const char * gradient_filename,
+ SHARPISO_GRID & full_grid, NRRD_INFO & nrrd_info, IO_TIME & io_time);
+void map_slab
+(const char * scalar_filename, const char * gradient_filename,
+ const AXIS_SIZE_TYPE z0, const AXIS_SIZE_TYPE z1,
+ MERGESHARP_DATA & slab_data);
+void output_isosurface
+(const INPUT_INFO & input_info, const int i,
+ const MERGESHARP_DATA & mergesharp_data,
+ const DUAL_ISOSURFACE & dual_isosurface,
+ const MERGESHARP_INFO & mergesharp_info, IO_TIME & io_time);
+void move_or_share_grid
+(SHARPISO_SCALAR_GRID & read_scalar_grid,
+ const SHARPISO_SCALAR_GRID_NRRD_MAP & mapped_scalar_grid,
+ MERGESHARP_DATA & mergesharp_data);
+void move_or_share_grid
+(GRADIENT_GRID & read_gradient_grid,
+ const GRADIENT_GRID_NRRD_MAP & mapped_gradient_grid,
+ MERGESHARP_DATA & mergesharp_data);
 
 
 // **************************************************
@@ -48,8 +77,8 @@ void construct_isosurface
 
 int main(int argc, char **argv)
 {
-  time_t start_time;
-  time(&start_time);
+  const std::chrono::steady_clock::time_point start_time =
+    std::chrono::steady_clock::now();
 
   MERGESHARP_TIME mergesharp_time;
   IO_TIME io_time = {0.0, 0.0, 0.0};
@@ -61,21 +90,17 @@ int main(int argc, char **argv)
     std::set_new_handler(memory_exhaustion);
 
     parse_command_line(argc, argv, input_info);
+    IJK::profiler().Enable(input_info.report_time_flag);
 
-    SHARPISO_SCALAR_GRID full_scalar_grid;
+    // Nrrd files with raw data are mapped instead of read.
+    // If the data is aligned in the file, its pages are shared 
+    //   with other processes mapping the file.
+    SHARPISO_SCALAR_GRID read_scalar_grid;
+    SHARPISO_SCALAR_GRID_NRRD_MAP mapped_scalar_grid;
     NRRD_INFO nrrd_info;
-    read_nrrd_file
-      (input_info.scalar_filename, full_scalar_grid,  nrrd_info, io_time);
-
-    GRADIENT_GRID full_gradient_grid;
-    NRRD_INFO nrrd_gradient_info;
-    std::vector<COORD_TYPE> edgeI_coord;
-    std::vector<GRADIENT_COORD_TYPE> edgeI_normal_coord;
-
-    if (input_info.GradientsRequired()) {
-
-      string gradient_filename;
 
+    string gradient_filename;
+    if (input_info.GradientsRequired() && !input_info.flag_compute_gradient) {
       if (input_info.gradient_filename == NULL) {
         construct_gradient_filename
           (input_info.scalar_filename, gradient_filename);
@@ -83,17 +108,70 @@ int main(int argc, char **argv)
       else {
         gradient_filename = string(input_info.gradient_filename);
       }
+    }
+
+    // With -slab, the grids are mapped from nrrd files with raw data
+    //   one slab at a time.  Only the size and spacing of the full grid
+    //   are stored in slab_file_grid.
+    // Other files are read and the grids are copied one slab at a time.
+    SHARPISO_GRID slab_file_grid;
+    const bool flag_map_slabs =
+      (input_info.slab_thickness > 0 && !gradient_filename.empty() &&
+       map_first_slab(input_info.scalar_filename, gradient_filename.c_str(),
+                      slab_file_grid, nrrd_info, io_time));
+
+    if (!flag_map_slabs) {
+      read_nrrd_file
+        (input_info.scalar_filename, read_scalar_grid, mapped_scalar_grid,
+         nrrd_info, io_time);
+    }
+    const SHARPISO_SCALAR_GRID_BASE & full_scalar_grid =
+      mapped_scalar_grid.IsMapped() ?
+      static_cast<const SHARPISO_SCALAR_GRID_BASE &>(mapped_scalar_grid) :
+      static_cast<const SHARPISO_SCALAR_GRID_BASE &>(read_scalar_grid);
+    const SHARPISO_GRID & full_grid =
+      flag_map_slabs ? slab_file_grid :
+      static_cast<const SHARPISO_GRID &>(full_scalar_grid);
+
+    if (!check_input(input_info, full_grid, error))
+      { throw(error); };
+
+    GRADIENT_GRID read_gradient_grid;
+    GRADIENT_GRID_NRRD_MAP mapped_gradient_grid;
+    NRRD_INFO nrrd_gradient_info;
+    std::vector<COORD_TYPE> edgeI_coord;
+    std::vector<GRADIENT_COORD_TYPE> edgeI_normal_coord;
+
+    if (input_info.GradientsRequired() && input_info.flag_compute_gradient) {
 
-      read_nrrd_file(gradient_filename.c_str(), full_gradient_grid,
-                     nrrd_gradient_info);
+      if (input_info.flag_subsample || input_info.flag_supersample) {
+        // Cubes of the resampled grid do not match cubes of full grid.
+        compute_gradient_central_difference
+          (full_scalar_grid, input_info.min_gradient_mag, read_gradient_grid);
+      }
+      else {
+        // Vertex positions use gradients within max_grad_dist of the cube.
+        const AXIS_SIZE_TYPE band_width = 
+          std::max(input_info.max_grad_dist, NUM_TYPE(1));
+        NUM_TYPE num_computed;
+        compute_gradient_central_difference_band
+          (full_scalar_grid, input_info.isovalue, band_width, 
+           input_info.min_gradient_mag, read_gradient_grid, num_computed);
+
+        if (input_info.flag_output_alg_info && !input_info.use_stdout) {
+          cout << "Computed gradients at " << num_computed << " of "
+               << full_scalar_grid.NumVertices() << " grid vertices." << endl;
+        }
+      }
       flag_gradient = true;
+    }
+    else if (input_info.GradientsRequired()) {
 
-      if (!full_gradient_grid.CompareSize(full_scalar_grid)) {
-        error.AddMessage("Input error. Grid mismatch.");
-        error.AddMessage
-          ("  Dimension or axis sizes of gradient grid and scalar grid do not match.");
-        throw error;
+      if (!flag_map_slabs) {
+        read_nrrd_file(gradient_filename.c_str(), read_gradient_grid,
+                       mapped_gradient_grid, nrrd_gradient_info);
       }
+      flag_gradient = true;
     }
     else if (input_info.NormalsRequired()) {
 
@@ -106,8 +184,18 @@ int main(int argc, char **argv)
         (input_info.normal_filename, edgeI_coord, edgeI_normal_coord);
     }
 
-    if (!check_input(input_info, full_scalar_grid, error))
-      { throw(error); };
+    const GRADIENT_GRID_BASE & full_gradient_grid =
+      mapped_gradient_grid.IsMapped() ?
+      static_cast<const GRADIENT_GRID_BASE &>(mapped_gradient_grid) :
+      static_cast<const GRADIENT_GRID_BASE &>(read_gradient_grid);
+
+    if (flag_gradient && !flag_map_slabs &&
+        !full_gradient_grid.CompareSize(full_scalar_grid)) {
+      error.AddMessage("Input error. Grid mismatch.");
+      error.AddMessage
+        ("  Dimension or axis sizes of gradient grid and scalar grid do not match.");
+      throw error;
+    }
 
     // copy nrrd_info into input_info
     set_input_info(nrrd_info, input_info);
@@ -116,42 +204,109 @@ int main(int argc, char **argv)
     MERGESHARP_DATA mergesharp_data;
     mergesharp_data.grad_selection_cube_offset = 0.1;
 
-    if (flag_gradient) {
-      mergesharp_data.SetGrids
-        (full_scalar_grid, full_gradient_grid,
-         input_info.flag_subsample, input_info.subsample_resolution,
-         input_info.flag_supersample, input_info.supersample_resolution);
+    // Move or share full grids into mergesharp_data, instead of copying them,
+    //   if they are not resampled or split into slabs.
+    // Read grids are then empty.  Mapped grids are shared.
+    const bool flag_move_grids =
+      (input_info.slab_thickness <= 0 && !input_info.flag_subsample &&
+       !input_info.flag_supersample);
+
+    if (input_info.slab_thickness > 0) {
+      // construct_isosurface_slab maps or copies the grids
+      //   into a MERGESHARP_DATA one slab at a time.
+      mergesharp_data.Set(input_info);
+    }
+    else if (flag_gradient) {
+      if (flag_move_grids) {
+        move_or_share_grid
+          (read_scalar_grid, mapped_scalar_grid, mergesharp_data);
+        move_or_share_grid
+          (read_gradient_grid, mapped_gradient_grid, mergesharp_data);
+      }
+      else {
+        mergesharp_data.SetGrids
+          (full_scalar_grid, full_gradient_grid,
+           input_info.flag_subsample, input_info.subsample_resolution,
+           input_info.flag_supersample, input_info.supersample_resolution);
+      }
     }
     else
     {
-      mergesharp_data.SetScalarGrid
-        (full_scalar_grid, 
-         input_info.flag_subsample, input_info.subsample_resolution,
-         input_info.flag_supersample, input_info.supersample_resolution);
+      if (flag_move_grids) {
+        move_or_share_grid
+          (read_scalar_grid, mapped_scalar_grid, mergesharp_data);
+      }
+      else {
+        mergesharp_data.SetScalarGrid
+          (full_scalar_grid, 
+           input_info.flag_subsample, input_info.subsample_resolution,
+           input_info.flag_supersample, input_info.supersample_resolution);
+      }
 
       if (input_info.NormalsRequired()) {
         mergesharp_data.SetEdgeI(edgeI_coord, edgeI_normal_coord);
       }
 
     }
-    // Note: mergesharp_data.SetScalarGrid or mergesharp_data.SetGrids
-    //       must be called before set_mergesharp_data.
-    set_mergesharp_data(input_info, mergesharp_data, mergesharp_time);
+
+    if (input_info.slab_thickness <= 0) {
+      // Note: mergesharp_data.SetScalarGrid or mergesharp_data.SetGrids
+      //       must be called before set_mergesharp_data.
+      set_mergesharp_data(input_info, mergesharp_data, mergesharp_time);
+    }
 
     if (input_info.flag_output_param) 
       { report_mergesharp_param(mergesharp_data); }
 
-    report_num_cubes(full_scalar_grid, input_info, mergesharp_data);
-    construct_isosurface(input_info, mergesharp_data, mergesharp_time, io_time);
+    if (flag_move_grids) {
+      report_num_cubes
+        (mergesharp_data.ScalarGrid(), input_info, mergesharp_data); 
+    }
+    else {
+      report_num_cubes(full_grid, input_info, mergesharp_data);
+    }
+
+    if (flag_map_slabs) {
+      construct_isosurface_slab
+        (input_info, mergesharp_data, full_grid,
+         [&](const AXIS_SIZE_TYPE z0, const AXIS_SIZE_TYPE z1,
+             MERGESHARP_DATA & slab_data)
+         {
+           map_slab(input_info.scalar_filename, gradient_filename.c_str(),
+                    z0, z1, slab_data);
+         },
+         mergesharp_time, io_time);
+    }
+    else if (input_info.slab_thickness > 0) {
+      if (!full_gradient_grid.Check
+          (full_scalar_grid, "gradient grid", "scalar grid", error))
+        { throw error; }
+
+      construct_isosurface_slab
+        (input_info, mergesharp_data, full_grid,
+         [&](const AXIS_SIZE_TYPE z0, const AXIS_SIZE_TYPE z1,
+             MERGESHARP_DATA & slab_data)
+         {
+           slab_data.CopySlab(full_scalar_grid, full_gradient_grid, z0, z1);
+         },
+         mergesharp_time, io_time);
+    }
+    else {
+      construct_isosurface
+        (input_info, mergesharp_data, mergesharp_time, io_time);
+    }
 
     if (input_info.report_time_flag) {
 
-      time_t end_time;
-      time(&end_time);
-      double total_elapsed_time = difftime(end_time, start_time);
+      const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start_time;
+      const double total_elapsed_time = elapsed.count();
 
       cout << endl;
       report_time(input_info, io_time, mergesharp_time, total_elapsed_time);
+
+      if (input_info.time_json_filename != NULL)
+        { write_time_json(input_info, total_elapsed_time); }
     };
 
   }
@@ -177,75 +332,214 @@ void construct_isosurface
 (const INPUT_INFO & input_info, const MERGESHARP_DATA & mergesharp_data,
  MERGESHARP_TIME & mergesharp_time, IO_TIME & io_time)
 {
-  const int dimension = mergesharp_data.ScalarGrid().Dimension();
-  const int num_cube_vertices = compute_num_cube_vertices(dimension);
-  const int num_cubes = mergesharp_data.ScalarGrid().ComputeNumCubes();
+  io_time.write_time = 0;
+
+  // Isosurfaces are output in isovalue order on this thread.
+  dual_contouring_multi_isovalue
+    (mergesharp_data, input_info.isovalue, input_info.num_isovalue_threads,
+     [&](const int i, const DUAL_ISOSURFACE & dual_isosurface,
+         const MERGESHARP_INFO & mergesharp_info)
+     {
+       mergesharp_time.Add(mergesharp_info.time);
+       output_isosurface
+         (input_info, i, mergesharp_data, dual_isosurface, 
+          mergesharp_info, io_time);
+     });
+}
+
+/**
+* Construct isosurface one z-slab of the grid at a time.
+*/
+void construct_isosurface_slab
+(const INPUT_INFO & input_info, const MERGESHARP_DATA & mergesharp_data,
+ const SHARPISO_GRID & full_grid, const SET_SLAB_FUNCTION & set_slab,
+ MERGESHARP_TIME & mergesharp_time, IO_TIME & io_time)
+{
+  const int dimension = full_grid.Dimension();
+  const VERTEX_INDEX num_cubes = full_grid.ComputeNumCubes();
 
   io_time.write_time = 0;
-  for (unsigned int i = 0; i < input_info.isovalue.size(); i++) {
 
-    const SCALAR_TYPE isovalue = input_info.isovalue[i];
+  // Each isovalue maps or copies its own slabs.
+  dual_contouring_multi_isovalue
+    (dimension, input_info.isovalue, input_info.num_isovalue_threads,
+     [&](const SCALAR_TYPE isovalue, DUAL_ISOSURFACE & dual_isosurface,
+         MERGESHARP_INFO & mergesharp_info)
+     {
+       mergesharp_info.grid.num_cubes = num_cubes;
+       dual_contouring_slab
+         (full_grid, set_slab, mergesharp_data, isovalue, 
+          dual_isosurface, mergesharp_info);
+     },
+     [&](const int i, const DUAL_ISOSURFACE & dual_isosurface,
+         const MERGESHARP_INFO & mergesharp_info)
+     {
+       mergesharp_time.Add(mergesharp_info.time);
+       output_isosurface
+         (input_info, i, mergesharp_data, dual_isosurface,
+          mergesharp_info, io_time);
+
+       if (mergesharp_info.sharpiso.num_open_edges > 0) {
+         cerr << "Warning: Isosurface " << i << " has "
+              << mergesharp_info.sharpiso.num_open_edges
+              << " open edges away from the grid boundary." << endl;
+       }
+     });
+}
 
-    DUAL_ISOSURFACE dual_isosurface;
-    MERGESHARP_INFO mergesharp_info(dimension);
-    mergesharp_info.grid.num_cubes = num_cubes;
+// **************************************************
+// MAP SLABS
+// **************************************************
 
-    dual_contouring
-      (mergesharp_data, isovalue, dual_isosurface, mergesharp_info);
-    mergesharp_time.Add(mergesharp_info.time);
+/// Map first z-slice of the scalar and gradient nrrd files.
+/// Set full_grid to the size and spacing of the grid in the files.
+/// Return false if either file cannot be mapped
+///   or if the grid sizes in the files differ.
+bool map_first_slab
+(const char * scalar_filename, const char * gradient_filename,
+ SHARPISO_GRID & full_grid, NRRD_INFO & nrrd_info, IO_TIME & io_time)
+{
+  ELAPSED_TIME wall_time;
+  SHARPISO_SCALAR_GRID_NRRD_MAP scalar_slab;
+  GRADIENT_GRID_NRRD_MAP gradient_slab;
+  NRRD_INFO nrrd_gradient_info;
+
+  if (!map_nrrd_slab(scalar_filename, 0, 0, scalar_slab, nrrd_info) ||
+      !map_nrrd_slab(gradient_filename, 0, 0, gradient_slab,
+                     nrrd_gradient_info)) { 
+    nrrd_info.grid_spacing.clear();
+    return(false); 
+  }
 
-	OUTPUT_INFO output_info;
-    set_output_info(input_info, i, output_info);
+  const int dimension = scalar_slab.Dimension();
+  if (dimension != DIM3 || !gradient_slab.CompareSize(scalar_slab) ||
+      !std::equal(scalar_slab.FileAxisSize(), 
+                  scalar_slab.FileAxisSize()+dimension,
+                  gradient_slab.FileAxisSize())) {
+    // Let read_nrrd_file read the files and report the error.
+    nrrd_info.grid_spacing.clear();
+    return(false);
+  }
 
-	int grow_factor = 1;
-    int shrink_factor = 1;
-    if (input_info.flag_subsample)
-      { grow_factor = input_info.subsample_resolution; }
-    if (input_info.flag_supersample)
-      { shrink_factor = input_info.supersample_resolution; }
+  full_grid.SetSize(dimension, scalar_slab.FileAxisSize());
+  full_grid.SetSpacing(scalar_slab.SpacingPtrConst());
 
-    /* SPACING NOW CHANGED WHEN ISO COORDINATES ARE COMPUTED
-    rescale_vertex_coord(grow_factor, shrink_factor, input_info.grid_spacing,
-                         dual_isosurface.vertex_coord);
-    */
-	
-    if (mergesharp_data.flag_convert_quad_to_tri) {
+  io_time.read_nrrd_time = wall_time.getElapsed();
 
-      VERTEX_INDEX_ARRAY quad_vert(dual_isosurface.quad_vert);
-      VERTEX_INDEX_ARRAY quad_vert2;
-      DUAL_ISOSURFACE isosurface_tri_mesh;
-      isosurface_tri_mesh.vertex_coord = dual_isosurface.vertex_coord;
-      isosurface_tri_mesh.tri_vert = dual_isosurface.tri_vert;
+  return(true);
+}
 
-      IJK::reorder_quad_vertices(quad_vert);
+/// Map z-slab of the scalar and gradient nrrd files
+///   and copy it into slab_data.
+/// The mapped slab is unmapped on return.
+void map_slab
+(const char * scalar_filename, const char * gradient_filename,
+ const AXIS_SIZE_TYPE z0, const AXIS_SIZE_TYPE z1,
+ MERGESHARP_DATA & slab_data)
+{
+  SHARPISO_SCALAR_GRID_NRRD_MAP scalar_slab;
+  GRADIENT_GRID_NRRD_MAP gradient_slab;
+  NRRD_INFO nrrd_info;
+  IJK::PROCEDURE_ERROR error("map_slab");
+
+  if (!map_nrrd_slab(scalar_filename, z0, z1, scalar_slab, nrrd_info)) {
+    error.AddMessage("Error mapping slab [", z0, ",", z1, "] of file ",
+                     scalar_filename, ".");
+    throw error;
+  }
 
-      triangulate_quad_sharing_multiple_edges
-        (quad_vert, isosurface_tri_mesh.tri_vert, quad_vert2);
+  if (!map_nrrd_slab(gradient_filename, z0, z1, gradient_slab, nrrd_info)) {
+    error.AddMessage("Error mapping slab [", z0, ",", z1, "] of file ",
+                     gradient_filename, ".");
+    throw error;
+  }
 
-      if (mergesharp_data.quad_tri_method == SPLIT_MAX_ANGLE) {
+  slab_data.CopySlab(scalar_slab, gradient_slab, 0, z1-z0);
+}
 
-        // *** CREATE create_dual_tri IN mergesharp.cxx ***
-        triangulate_quad_split_max_angle
-          (DIM3, isosurface_tri_mesh.vertex_coord, quad_vert2,
-           mergesharp_data.max_small_magnitude, isosurface_tri_mesh.tri_vert);
-      }
-      else {
-        triangulate_quad(quad_vert2, isosurface_tri_mesh.tri_vert);
-      }
-	   
-      output_dual_isosurface
-        (output_info, mergesharp_data, isosurface_tri_mesh, 
-         mergesharp_info, io_time);
+/**
+* Output isosurface for isovalue i.
+* Convert quadrilaterals to triangles if flag_convert_quad_to_tri is true.
+*/
+void output_isosurface
+(const INPUT_INFO & input_info, const int i,
+ const MERGESHARP_DATA & mergesharp_data,
+ const DUAL_ISOSURFACE & dual_isosurface,
+ const MERGESHARP_INFO & mergesharp_info, IO_TIME & io_time)
+{
+  IJK_PROFILE_SCOPE(output_timer, "output");
+  OUTPUT_INFO output_info;
+  set_output_info(input_info, i, output_info);
+
+  if (mergesharp_data.flag_convert_quad_to_tri) {
+
+    VERTEX_INDEX_ARRAY quad_vert(dual_isosurface.quad_vert);
+    VERTEX_INDEX_ARRAY quad_vert2;
+    DUAL_ISOSURFACE isosurface_tri_mesh;
+    isosurface_tri_mesh.vertex_coord = dual_isosurface.vertex_coord;
+    isosurface_tri_mesh.tri_vert = dual_isosurface.tri_vert;
+
+    IJK::reorder_quad_vertices(quad_vert);
+
+    triangulate_quad_sharing_multiple_edges
+      (quad_vert, isosurface_tri_mesh.tri_vert, quad_vert2);
+
+    if (mergesharp_data.quad_tri_method == SPLIT_MAX_ANGLE) {
+
+      // *** CREATE create_dual_tri IN mergesharp.cxx ***
+      triangulate_quad_split_max_angle
+        (DIM3, isosurface_tri_mesh.vertex_coord, quad_vert2,
+         mergesharp_data.max_small_magnitude, isosurface_tri_mesh.tri_vert);
     }
     else {
-      output_dual_isosurface
-        (output_info, mergesharp_data, dual_isosurface, 
-         mergesharp_info, io_time);
+      triangulate_quad(quad_vert2, isosurface_tri_mesh.tri_vert);
     }
+
+    output_dual_isosurface
+      (output_info, mergesharp_data, isosurface_tri_mesh, 
+       mergesharp_info, io_time);
+  }
+  else {
+    output_dual_isosurface
+      (output_info, mergesharp_data, dual_isosurface, 
+       mergesharp_info, io_time);
   }
+}
+
+// **************************************************
+// MOVE OR SHARE GRIDS
+// **************************************************
 
+/// Share mapped_scalar_grid with mergesharp_data, if it is mapped.
+/// Otherwise, move read_scalar_grid into mergesharp_data.
+void move_or_share_grid
+(SHARPISO_SCALAR_GRID & read_scalar_grid,
+ const SHARPISO_SCALAR_GRID_NRRD_MAP & mapped_scalar_grid,
+ MERGESHARP_DATA & mergesharp_data)
+{
+  if (mapped_scalar_grid.IsMapped()) 
+    { mergesharp_data.ShareScalarGrid(mapped_scalar_grid); }
+  else
+    { mergesharp_data.MoveScalarGrid(read_scalar_grid); }
 }
 
+/// Share mapped_gradient_grid with mergesharp_data, if it is mapped.
+/// Otherwise, move read_gradient_grid into mergesharp_data.
+void move_or_share_grid
+(GRADIENT_GRID & read_gradient_grid,
+ const GRADIENT_GRID_NRRD_MAP & mapped_gradient_grid,
+ MERGESHARP_DATA & mergesharp_data)
+{
+  if (mapped_gradient_grid.IsMapped()) 
+    { mergesharp_data.ShareGradientGrid(mapped_gradient_grid); }
+  else
+    { mergesharp_data.MoveGradientGrid(read_gradient_grid); }
+}
+
+// **************************************************
+// MISC ROUTINES
+// **************************************************
+
 void memory_exhaustion()
 {
   cerr << "Error: Out of memory.  Terminating program." << endl;
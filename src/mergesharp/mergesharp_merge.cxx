@@ -28,6 +28,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "ijkgraph.txx"
 #include "ijkmesh.txx"
 #include "ijkgrid_macros.h"
+#include "ijkprofile.txx"
 
 #include "mergesharp_types.h"
 #include "mergesharp_datastruct.h"
@@ -133,6 +134,7 @@ void MERGESHARP::merge_sharp_iso_vertices_multi
 	std::vector<VERTEX_INDEX> & poly_vert,
 	std::vector<VERTEX_INDEX> & gcube_map, SHARPISO_INFO & sharpiso_info)
 {
+	IJK_PROFILE_SCOPE(merge_timer, "merge_sharp_iso_vertices_multi");
 	const NUM_TYPE num_gcube = isovert.gcube_list.size();
 	IJK::ARRAY<NUM_TYPE> first_gcube_isov(num_gcube);
 
@@ -189,7 +191,7 @@ namespace {
 
 	using namespace MERGESHARP;
 
-	void map_iso_vertex(const std::vector<GRID_CUBE> & gcube_list,
+	void map_iso_vertex(const GRID_CUBE_ARRAY & gcube_list,
 		const INDEX_DIFF_TYPE from_cube,
 		const INDEX_DIFF_TYPE to_cube,
 		std::vector<SHARPISO::VERTEX_INDEX> & gcube_map)
@@ -211,7 +213,7 @@ namespace {
 	void map_iso_vertex
   (const SHARPISO::SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
    const SCALAR_TYPE isovalue,
-   const std::vector<GRID_CUBE> & gcube_list,
+   const GRID_CUBE_ARRAY & gcube_list,
    const INDEX_DIFF_TYPE from_gcube,
    const INDEX_DIFF_TYPE to_gcube,
    std::vector<SHARPISO::VERTEX_INDEX> & gcube_map)
@@ -2551,6 +2553,19 @@ namespace {
 		std::vector<SHARPISO::VERTEX_INDEX> & gcube_map, 
 		MERGESHARP::SHARPISO_INFO & sharpiso_info);
 
+	// Set gcube_map and flags of fixed cubes.
+	void apply_fixed_gcube_map
+		(MERGESHARP::ISOVERT & isovert, 
+		std::vector<SHARPISO::VERTEX_INDEX> & gcube_map)
+	{
+		for (NUM_TYPE i = 0; i < NUM_TYPE(isovert.fixed_gcube.size()); i++) {
+			if (isovert.fixed_gcube[i]) {
+				gcube_map[i] = isovert.fixed_gcube_map[i];
+				isovert.gcube_list[i].flag = isovert.fixed_merge_flag[i];
+			}
+		}
+	}
+
 	void determine_gcube_map
 		(const SHARPISO::SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
 		const SCALAR_TYPE isovalue,
@@ -2566,6 +2581,8 @@ namespace {
         (scalar_grid, isovalue, isovert, gcube_map);
 		}
 
+		apply_fixed_gcube_map(isovert, gcube_map);
+
 		if (sharp_isovert_param.flag_check_disk) {
 			unmap_non_disk_isopatches
 				(scalar_grid, isovalue, isovert, gcube_map, sharpiso_info);
@@ -2588,6 +2605,8 @@ namespace {
         (scalar_grid, isovalue, isovert, gcube_map);
 		}
 
+		apply_fixed_gcube_map(isovert, gcube_map);
+
 		if (sharp_isovert_param.flag_check_disk) {
 			unmap_non_disk_isopatches
 				(scalar_grid, isodual_table, isovalue, isovert, gcube_map, 
@@ -2628,7 +2647,68 @@ namespace {
 		}
 	}
 
+	// Track which selected cubes need an isopatch disk check.
+	// The isopatch of selected cube cube_index depends only on gcube_map
+	//   and flags of cubes within distance dist2cube+1 of cube_index.
+	// Unmapping merged cubes around cube_index0 changes only cubes
+	//   within distance dist2cube of cube_index0, so only isopatches
+	//   of cubes within distance 2*dist2cube+1 of cube_index0 change.
+	// Other isopatches which passed the disk check still pass it.
+	class DISK_CHECK_TRACKER {
+
+	protected:
+		std::vector<bool> is_unchecked;
+		AXIS_SIZE_TYPE recheck_dist;
+
+	public:
+		DISK_CHECK_TRACKER
+			(const NUM_TYPE num_gcube, const AXIS_SIZE_TYPE dist2cube):
+			is_unchecked(num_gcube, true), recheck_dist(2*dist2cube+1) {};
+
+		bool IsUnchecked(const NUM_TYPE gcube_index) const
+		{ return(is_unchecked[gcube_index]); }
+
+		void SetChecked(const NUM_TYPE gcube_index)
+		{ is_unchecked[gcube_index] = false; }
+
+		// Mark all active cubes near cube_index0 as unchecked.
+		void SetUncheckedNear
+			(const SHARPISO_GRID & grid, const MERGESHARP::ISOVERT & isovert,
+			const VERTEX_INDEX cube_index0);
+	};
+
+	void DISK_CHECK_TRACKER::SetUncheckedNear
+		(const SHARPISO_GRID & grid, const MERGESHARP::ISOVERT & isovert,
+		const VERTEX_INDEX cube_index0)
+	{
+		const int dimension = grid.Dimension();
+		VERTEX_INDEX region_iv0;
+		IJK::ARRAY<AXIS_SIZE_TYPE> region_axis_size(dimension);
+
+		IJK::compute_region_around_cube
+			(cube_index0, dimension, grid.AxisSize(), recheck_dist, 
+			region_iv0, region_axis_size.Ptr());
+
+		NUM_TYPE num_region_cubes;
+		IJK::compute_num_grid_cubes
+			(dimension, region_axis_size.PtrConst(), num_region_cubes);
+
+		IJK::ARRAY<VERTEX_INDEX> region_cube_list(num_region_cubes);
+		IJK::get_subgrid_cubes
+			(dimension, grid.AxisSize(), region_iv0, region_axis_size.PtrConst(),
+			region_cube_list.Ptr());
+
+		for (NUM_TYPE i = 0; i < num_region_cubes; i++) {
+			const INDEX_DIFF_TYPE gcube_index1 = 
+				isovert.sharp_ind_grid.Scalar(region_cube_list[i]);
+			if (gcube_index1 != ISOVERT::NO_INDEX)
+			{ is_unchecked[gcube_index1] = true; }
+		}
+	}
+
 	// Reverse merges which create isopatches which are not disks.
+	// Repeat until all isopatches pass the disk check.
+	// After the first pass, only recheck isopatches near unmapped cubes.
 	void unmap_non_disk_isopatches
 		(const SHARPISO::SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
 		const SCALAR_TYPE isovalue,
@@ -2641,15 +2721,18 @@ namespace {
 		const int dist2cube = 1;
 		std::vector<ISO_VERTEX_INDEX> tri_vert;
 		std::vector<ISO_VERTEX_INDEX> quad_vert;
+		DISK_CHECK_TRACKER tracker(num_gcube, dist2cube);
 
 		bool passed_all_disk_checks;
 		do {
 			passed_all_disk_checks = true;
 
 			for (NUM_TYPE i = 0; i < num_gcube; i++) {
-				if (isovert.gcube_list[i].flag == SELECTED_GCUBE) {
+				if (isovert.gcube_list[i].flag == SELECTED_GCUBE &&
+					tracker.IsUnchecked(i) && !isovert.IsFixed(i)) {
 					VERTEX_INDEX cube_index = isovert.gcube_list[i].cube_index;
 
+					tracker.SetChecked(i);
 					extract_dual_isopatch_incident_on
 						(scalar_grid, isovalue, isovert, cube_index,
 						gcube_map, dist2cube, tri_vert, quad_vert);
@@ -2658,6 +2741,7 @@ namespace {
 
 					if (!is_isopatch_disk3D(tri_vert, quad_vert)) {
 						unmap_merged_cubes(isovert, cube_index, dist2cube, gcube_map);
+						tracker.SetUncheckedNear(scalar_grid, isovert, cube_index);
 						sharpiso_info.num_non_disk_isopatches++;
 						passed_all_disk_checks = false;
 					}
@@ -2690,6 +2774,8 @@ namespace {
 	}
 
 	// Reverse merges which create isopatches which are not disks.
+	// Repeat until all isopatches pass the disk check.
+	// After the first pass, only recheck isopatches near unmapped cubes.
 	void unmap_non_disk_isopatches
 		(const SHARPISO::SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
 		const IJKDUALTABLE::ISODUAL_CUBE_TABLE & isodual_table,
@@ -2703,15 +2789,18 @@ namespace {
 		const int dist2cube = 1;
 		std::vector<ISO_VERTEX_INDEX> tri_vert;
 		std::vector<ISO_VERTEX_INDEX> quad_vert;
+		DISK_CHECK_TRACKER tracker(num_gcube, dist2cube);
 
 		bool passed_all_disk_checks;
 		do {
 			passed_all_disk_checks = true;
 
 			for (NUM_TYPE i = 0; i < num_gcube; i++) {
-				if (isovert.gcube_list[i].flag == SELECTED_GCUBE) {
+				if (isovert.gcube_list[i].flag == SELECTED_GCUBE &&
+					tracker.IsUnchecked(i) && !isovert.IsFixed(i)) {
 					VERTEX_INDEX cube_index = isovert.gcube_list[i].cube_index;
 
+					tracker.SetChecked(i);
 					extract_dual_isopatch_incident_on_multi
 						(scalar_grid, isodual_table, isovalue, isovert, 
 						cube_index, gcube_map, dist2cube, tri_vert, quad_vert);
@@ -2719,6 +2808,7 @@ namespace {
 
 					if (!is_isopatch_disk3D(tri_vert, quad_vert)) {
 						unmap_merged_cubes(isovert, cube_index, dist2cube, gcube_map);
+						tracker.SetUncheckedNear(scalar_grid, isovert, cube_index);
 						isovert.gcube_list[i].flag = NON_DISK_GCUBE;
 						sharpiso_info.num_non_disk_isopatches++;
 						passed_all_disk_checks = false;
@@ -2777,6 +2867,7 @@ bool MERGESHARP::is_isopatch_disk3D
 	(const std::vector<ISO_VERTEX_INDEX> & tri_vert,
 	const std::vector<ISO_VERTEX_INDEX> & quad_vert)
 {
+	IJK_PROFILE_SCOPE(disk_timer, "is_isopatch_disk3D");
 	const NUM_TYPE num_tri = tri_vert.size()/NUM_VERT_PER_TRI;
 	const NUM_TYPE num_quad = quad_vert.size()/NUM_VERT_PER_QUAD;
 	std::vector<ISO_VERTEX_INDEX> tri_vert2;
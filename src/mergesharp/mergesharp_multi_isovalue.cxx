@@ -0,0 +1,242 @@
+/// \file mergesharp_multi_isovalue.cxx
+/// Construct isosurfaces for several isovalues concurrently.
+
+/*
+  Copyright (C) 2013 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mergesharp.h"
+#include "mergesharp_multi_isovalue.h"
+
+using namespace IJK;
+using namespace MERGESHARP;
+
+
+// **************************************************
+// LOCAL TYPES AND ROUTINES
+// **************************************************
+
+namespace {
+
+  /// Isosurface and information for one isovalue.
+  class ISOVALUE_RESULT {
+
+  public:
+    DUAL_ISOSURFACE dual_isosurface;
+    MERGESHARP_INFO mergesharp_info;
+    std::exception_ptr error;
+
+    ISOVALUE_RESULT(const int dimension):mergesharp_info(dimension) {};
+  };
+
+  typedef std::unique_ptr<ISOVALUE_RESULT> ISOVALUE_RESULT_PTR;
+
+  /// Data shared by the extraction threads and the calling thread.
+  class MULTI_ISOVALUE_QUEUE {
+
+  public:
+    std::mutex queue_mutex;
+    std::condition_variable queue_changed;
+
+    /// Index of next isovalue to extract.
+    int next_isovalue;
+
+    /// Number of isosurfaces passed to process_isosurface.
+    int num_processed;
+
+    /// Isovalues are extracted at most max_ahead isovalues
+    ///   ahead of num_processed, bounding the number of
+    ///   isosurfaces held in memory.
+    int max_ahead;
+
+    /// If true, stop extracting isovalues.
+    bool flag_abort;
+
+    std::vector<ISOVALUE_RESULT_PTR> result;
+    std::vector<bool> is_done;
+
+    MULTI_ISOVALUE_QUEUE(const int num_isovalues, const int num_threads):
+      result(num_isovalues), is_done(num_isovalues, false)
+    {
+      next_isovalue = 0;
+      num_processed = 0;
+      max_ahead = 2*num_threads;
+      flag_abort = false;
+    }
+  };
+
+  /// Extract isovalues from queue until none remain.
+  void extract_isovalues
+  (const int dimension, const SCALAR_ARRAY & isovalue_list,
+   const EXTRACT_ISOSURFACE_FUNCTION & extract_isosurface,
+   MULTI_ISOVALUE_QUEUE & queue)
+  {
+    const int num_isovalues = isovalue_list.size();
+
+    while (true) {
+
+      int i;
+      {
+        std::unique_lock<std::mutex> lock(queue.queue_mutex);
+        while (!queue.flag_abort && queue.next_isovalue < num_isovalues &&
+               queue.next_isovalue >= queue.num_processed+queue.max_ahead)
+          { queue.queue_changed.wait(lock); }
+
+        if (queue.flag_abort || queue.next_isovalue >= num_isovalues)
+          { return; }
+
+        i = queue.next_isovalue;
+        queue.next_isovalue++;
+      }
+
+      ISOVALUE_RESULT_PTR result(new ISOVALUE_RESULT(dimension));
+      try {
+        extract_isosurface
+          (isovalue_list[i], result->dual_isosurface,
+           result->mergesharp_info);
+      }
+      catch (...) {
+        result->error = std::current_exception();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(queue.queue_mutex);
+        queue.result[i].swap(result);
+        queue.is_done[i] = true;
+      }
+      queue.queue_changed.notify_all();
+    }
+  }
+
+  /// Stop the extraction threads and wait for them to finish.
+  void join_threads
+  (MULTI_ISOVALUE_QUEUE & queue, std::vector<std::thread> & thread_list)
+  {
+    {
+      std::lock_guard<std::mutex> lock(queue.queue_mutex);
+      queue.flag_abort = true;
+    }
+    queue.queue_changed.notify_all();
+
+    for (int k = 0; k < int(thread_list.size()); k++)
+      { thread_list[k].join(); }
+    thread_list.clear();
+  }
+
+}
+
+
+// **************************************************
+// DUAL CONTOURING FOR MULTIPLE ISOVALUES
+// **************************************************
+
+/// Dual contouring for each isovalue in isovalue_list.
+void MERGESHARP::dual_contouring_multi_isovalue
+(const MERGESHARP_DATA & mergesharp_data,
+ const SCALAR_ARRAY & isovalue_list, const int num_threads,
+ const PROCESS_ISOSURFACE_FUNCTION & process_isosurface)
+{
+  const int dimension = mergesharp_data.ScalarGrid().Dimension();
+  const int num_cubes = mergesharp_data.ScalarGrid().ComputeNumCubes();
+
+  EXTRACT_ISOSURFACE_FUNCTION extract_isosurface =
+    [&mergesharp_data, num_cubes]
+    (const SCALAR_TYPE isovalue, DUAL_ISOSURFACE & dual_isosurface,
+     MERGESHARP_INFO & mergesharp_info)
+    {
+      mergesharp_info.grid.num_cubes = num_cubes;
+      dual_contouring
+        (mergesharp_data, isovalue, dual_isosurface, mergesharp_info);
+    };
+
+  dual_contouring_multi_isovalue
+    (dimension, isovalue_list, num_threads,
+     extract_isosurface, process_isosurface);
+}
+
+
+/// Dual contouring for each isovalue in isovalue_list
+///   using extract_isosurface.
+void MERGESHARP::dual_contouring_multi_isovalue
+(const int dimension,
+ const SCALAR_ARRAY & isovalue_list, const int num_threads,
+ const EXTRACT_ISOSURFACE_FUNCTION & extract_isosurface,
+ const PROCESS_ISOSURFACE_FUNCTION & process_isosurface)
+{
+  const int num_isovalues = isovalue_list.size();
+
+  int num_extract_threads = num_threads;
+  if (num_extract_threads > num_isovalues)
+    { num_extract_threads = num_isovalues; }
+
+  if (num_extract_threads <= 1) {
+    for (int i = 0; i < num_isovalues; i++) {
+      DUAL_ISOSURFACE dual_isosurface;
+      MERGESHARP_INFO mergesharp_info(dimension);
+      extract_isosurface
+        (isovalue_list[i], dual_isosurface, mergesharp_info);
+      process_isosurface(i, dual_isosurface, mergesharp_info);
+    }
+    return;
+  }
+
+  MULTI_ISOVALUE_QUEUE queue(num_isovalues, num_extract_threads);
+  std::vector<std::thread> thread_list;
+
+  for (int k = 0; k < num_extract_threads; k++) {
+    thread_list.push_back
+      (std::thread(extract_isovalues, dimension, std::cref(isovalue_list),
+                   std::cref(extract_isosurface), std::ref(queue)));
+  }
+
+  try {
+    for (int i = 0; i < num_isovalues; i++) {
+
+      ISOVALUE_RESULT_PTR result;
+      {
+        std::unique_lock<std::mutex> lock(queue.queue_mutex);
+        while (!queue.is_done[i]) { queue.queue_changed.wait(lock); }
+        result.swap(queue.result[i]);
+      }
+
+      if (result->error) { std::rethrow_exception(result->error); }
+
+      process_isosurface
+        (i, result->dual_isosurface, result->mergesharp_info);
+      result.reset();
+
+      {
+        std::lock_guard<std::mutex> lock(queue.queue_mutex);
+        queue.num_processed = i+1;
+      }
+      queue.queue_changed.notify_all();
+    }
+  }
+  catch (...) {
+    join_threads(queue, thread_list);
+    throw;
+  }
+
+  join_threads(queue, thread_list);
+}
@@ -0,0 +1,81 @@
+/// \file mergesharp_multi_isovalue.h
+/// Construct isosurfaces for several isovalues concurrently.
+
+/*
+  Copyright (C) 2013 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef _MERGESHARP_MULTI_ISOVALUE_
+#define _MERGESHARP_MULTI_ISOVALUE_
+
+#include <functional>
+
+#include "mergesharp_types.h"
+#include "mergesharp_datastruct.h"
+
+
+namespace MERGESHARP {
+
+  // **************************************************
+  // TYPES
+  // **************************************************
+
+  /// Construct isosurface for one isovalue.
+  /// Called concurrently from several threads,
+  ///   so it may only read shared data.
+  typedef std::function<void
+  (const SCALAR_TYPE isovalue, DUAL_ISOSURFACE & dual_isosurface,
+   MERGESHARP_INFO & mergesharp_info)> EXTRACT_ISOSURFACE_FUNCTION;
+
+  /// Process isosurface for isovalue i.
+  /// Called on the calling thread in isovalue order.
+  typedef std::function<void
+  (const int i, const DUAL_ISOSURFACE & dual_isosurface,
+   const MERGESHARP_INFO & mergesharp_info)> PROCESS_ISOSURFACE_FUNCTION;
+
+
+  // **************************************************
+  // DUAL CONTOURING FOR MULTIPLE ISOVALUES
+  // **************************************************
+
+  /// Dual contouring for each isovalue in isovalue_list.
+  /// Up to num_threads isovalues are extracted concurrently
+  ///   from the same read-only mergesharp_data.
+  /// Isovalue-independent data, such as the min/max regions,
+  ///   is computed once in mergesharp_data and shared by all isovalues.
+  /// process_isosurface(i,...) is called on the calling thread
+  ///   for i = 0, 1, 2, ... in order, as soon as isosurface i is done.
+  /// Isosurface i is freed after process_isosurface returns.
+  /// An exception thrown while extracting isosurface i is rethrown
+  ///   in place of process_isosurface(i,...).
+  void dual_contouring_multi_isovalue
+    (const MERGESHARP_DATA & mergesharp_data,
+     const SCALAR_ARRAY & isovalue_list, const int num_threads,
+     const PROCESS_ISOSURFACE_FUNCTION & process_isosurface);
+
+  /// Dual contouring for each isovalue in isovalue_list
+  ///   using extract_isosurface.
+  /// @param dimension Dimension passed to the MERGESHARP_INFO constructor.
+  void dual_contouring_multi_isovalue
+    (const int dimension,
+     const SCALAR_ARRAY & isovalue_list, const int num_threads,
+     const EXTRACT_ISOSURFACE_FUNCTION & extract_isosurface,
+     const PROCESS_ISOSURFACE_FUNCTION & process_isosurface);
+
+}
+
+#endif
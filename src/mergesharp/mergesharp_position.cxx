@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "ijkgrid_macros.h"
 #include "ijkinterpolate.txx"
 #include "ijkisopoly.txx"
+#include "ijkprofile.txx"
 
 #include "ijkdualtable.h"
 #include "ijkdualtable_ambig.h"
@@ -175,6 +176,7 @@ void MERGESHARP::position_merged_dual_isovertices_multi
  const std::vector<DUAL_ISOVERT> & iso_vlist,
  COORD_TYPE * isov_coord)
 {
+  IJK_PROFILE_SCOPE(position_timer, "position_merged_isovertices");
   const int dimension = scalar_grid.Dimension();
   const int num_cube_vertices = scalar_grid.NumCubeVertices();
   MERGESHARP_CUBE_FACE_INFO cube(dimension);
@@ -629,10 +631,10 @@ void MERGESHARP::compute_isosurface_grid_edge_centroid
  const MERGESHARP_CUBE_FACE_INFO & cube,
  COORD_TYPE * coord)
 {
-  static COORD_TYPE vcoord[DIM3];
-  static COORD_TYPE coord0[DIM3];
-  static COORD_TYPE coord1[DIM3];
-  static COORD_TYPE coord2[DIM3];
+  COORD_TYPE vcoord[DIM3];
+  COORD_TYPE coord0[DIM3];
+  COORD_TYPE coord1[DIM3];
+  COORD_TYPE coord2[DIM3];
 
   int num_intersected_edges = 0;
   IJK::set_coord_3D(0.0, vcoord);
@@ -919,7 +921,7 @@ void MERGESHARP::full_split_dual_isovert
 
 /// Copy isovert position from data structure isovert
 void MERGESHARP::copy_isovert_positions
-(const std::vector<GRID_CUBE> & gcube_list,
+(const GRID_CUBE_ARRAY & gcube_list,
  COORD_ARRAY & vertex_coord)
 {
   VERTEX_INDEX num_isovert = gcube_list.size();
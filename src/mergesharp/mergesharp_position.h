@@ -357,7 +357,7 @@ namespace MERGESHARP {
 
   /// Copy isovert position from data structure isovert
   void copy_isovert_positions
-    (const std::vector<GRID_CUBE> & gcube_list,
+    (const GRID_CUBE_ARRAY & gcube_list,
      COORD_ARRAY & vertex_coord);
 
 };
@@ -0,0 +1,459 @@
+/// \file mergesharp_slab.cxx
+/// Construct isosurface one z-slab of the grid at a time.
+
+/*
+  Copyright (C) 2013 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "ijkmesh.txx"
+
+#include "mergesharp.h"
+#include "mergesharp_merge.h"
+#include "mergesharp_slab.h"
+
+using namespace IJK;
+using namespace MERGESHARP;
+
+
+// **************************************************
+// LOCAL TYPES AND ROUTINES
+// **************************************************
+
+namespace {
+
+  /// Key identifying an isosurface vertex by grid cube and patch.
+  typedef long long ISOV_KEY;
+
+  /// Hash table mapping isosurface vertex keys to mesh vertex indices.
+  typedef std::unordered_map<ISOV_KEY, VERTEX_INDEX> ISOV_KEY_TABLE;
+
+  /// Maximum number of isosurface patches in a cube plus one.
+  /// A cube has at most one isosurface patch per cube vertex.
+  const ISOV_KEY MAX_NUM_PATCH = NUM_CUBE_VERTICES3D;
+
+  ISOV_KEY compute_isov_key
+  (const VERTEX_INDEX cube_index, const int patch_index)
+  {
+    return(ISOV_KEY(cube_index)*MAX_NUM_PATCH + patch_index);
+  }
+
+  /// Selection and merge of a grid cube decided in a previous slab.
+  /// Cube indices are indices in the full grid.
+  class FIXED_GCUBE {
+
+  public:
+    GRID_CUBE_FLAG select_flag;  ///< Flag after selection.
+    GRID_CUBE_FLAG merge_flag;   ///< Flag after merging.
+    VERTEX_INDEX covered_by;     ///< Cube which covered this cube.
+    VERTEX_INDEX maps_to;        ///< Cube which this cube merges into.
+  };
+
+  /// Hash table mapping full grid cube indices to fixed grid cubes.
+  typedef std::unordered_map<VERTEX_INDEX, FIXED_GCUBE> FIXED_GCUBE_TABLE;
+
+  /// Fix the grid cubes of isovert which are in fixed_table.
+  /// Covering cubes and merge targets outside the slab
+  ///   are replaced by the cube itself.
+  /// @param slab_v0 Index in full grid of first vertex of slab grid.
+  void set_fixed_gcubes
+  (const VERTEX_INDEX slab_v0, const FIXED_GCUBE_TABLE & fixed_table,
+   ISOVERT & isovert)
+  {
+    const NUM_TYPE num_gcube = isovert.gcube_list.size();
+    const VERTEX_INDEX num_slab_vertices = isovert.sharp_ind_grid.NumVertices();
+
+    isovert.fixed_gcube.assign(num_gcube, false);
+    isovert.fixed_gcube_map.resize(num_gcube);
+    isovert.fixed_merge_flag.resize(num_gcube);
+
+    if (fixed_table.empty()) { return; }
+
+    for (NUM_TYPE i = 0; i < num_gcube; i++) {
+      const VERTEX_INDEX cube_index = isovert.gcube_list[i].cube_index;
+      FIXED_GCUBE_TABLE::const_iterator fixed_iter = 
+        fixed_table.find(cube_index+slab_v0);
+      if (fixed_iter == fixed_table.end()) { continue; }
+
+      const FIXED_GCUBE & fixed = fixed_iter->second;
+      const VERTEX_INDEX covered_by = fixed.covered_by - slab_v0;
+      const VERTEX_INDEX maps_to = fixed.maps_to - slab_v0;
+
+      isovert.fixed_gcube[i] = true;
+      isovert.gcube_list[i].flag = fixed.select_flag;
+      isovert.fixed_merge_flag[i] = fixed.merge_flag;
+
+      isovert.gcube_list[i].covered_by = cube_index;
+      if (covered_by >= 0 && covered_by < num_slab_vertices)
+        { isovert.gcube_list[i].covered_by = covered_by; }
+
+      isovert.fixed_gcube_map[i] = i;
+      if (maps_to >= 0 && maps_to < num_slab_vertices) {
+        const INDEX_DIFF_TYPE gcube_index2 = 
+          isovert.sharp_ind_grid.Scalar(maps_to);
+        if (gcube_index2 != ISOVERT::NO_INDEX)
+          { isovert.fixed_gcube_map[i] = gcube_index2; }
+      }
+    }
+  }
+
+  /// Insert grid cube gcube_index into fixed_table,
+  ///   unless it is already in fixed_table.
+  void insert_fixed_gcube
+  (const VERTEX_INDEX slab_v0, const NUM_TYPE gcube_index,
+   const ISOVERT & isovert, const std::vector<GRID_CUBE_FLAG> & select_flag,
+   const std::vector<VERTEX_INDEX> & gcube_map,
+   FIXED_GCUBE_TABLE & fixed_table)
+  {
+    const GRID_CUBE_CONST_REF c = isovert.gcube_list[gcube_index];
+    FIXED_GCUBE fixed;
+
+    fixed.select_flag = select_flag[gcube_index];
+    fixed.merge_flag = c.flag;
+    fixed.covered_by = c.covered_by + slab_v0;
+    fixed.maps_to = 
+      isovert.gcube_list.CubeIndex(gcube_map[gcube_index]) + slab_v0;
+    fixed_table.insert
+      (FIXED_GCUBE_TABLE::value_type(c.cube_index+slab_v0, fixed));
+  }
+
+  /// Store selection and merge of grid cubes with z-coordinate
+  ///   at most zlast and of the cubes they merge into.
+  /// Cubes already in fixed_table keep their previous values.
+  void store_fixed_gcubes
+  (const VERTEX_INDEX slab_v0, const AXIS_SIZE_TYPE zlast,
+   const VERTEX_INDEX num_vert_in_zplane,
+   const ISOVERT & isovert, const std::vector<GRID_CUBE_FLAG> & select_flag,
+   const std::vector<VERTEX_INDEX> & gcube_map,
+   FIXED_GCUBE_TABLE & fixed_table)
+  {
+    for (NUM_TYPE i = 0; i < isovert.gcube_list.size(); i++) {
+      const VERTEX_INDEX cube_index = isovert.gcube_list.CubeIndex(i);
+      if ((cube_index+slab_v0)/num_vert_in_zplane > zlast) { continue; }
+
+      insert_fixed_gcube
+        (slab_v0, i, isovert, select_flag, gcube_map, fixed_table);
+      if (gcube_map[i] != i) {
+        insert_fixed_gcube
+          (slab_v0, gcube_map[i], isovert, select_flag, gcube_map, 
+           fixed_table);
+      }
+    }
+  }
+
+  /// Remove grid cubes with z-coordinate less than z0 from fixed_table.
+  void erase_fixed_gcubes_below
+  (const AXIS_SIZE_TYPE z0, const VERTEX_INDEX num_vert_in_zplane,
+   FIXED_GCUBE_TABLE & fixed_table)
+  {
+    FIXED_GCUBE_TABLE::iterator fixed_iter = fixed_table.begin();
+    while (fixed_iter != fixed_table.end()) {
+      if (fixed_iter->first/num_vert_in_zplane < z0)
+        { fixed_iter = fixed_table.erase(fixed_iter); }
+      else
+        { fixed_iter++; }
+    }
+  }
+
+  /// Construct isosurface polygons of one slab.
+  /// Selection and merge of cubes in fixed_table are not changed.
+  /// Selection and merge of cubes with z-coordinate at most zc1
+  ///   are added to fixed_table.
+  /// Returns the polygons which are dual to grid edges in the slab,
+  ///   i.e., whose isosurface vertices before merging are in cubes
+  ///   with maximum z-coordinate in [zc0,zc1).
+  /// Polygon vertices are indices into slab_info.sharpiso.vertex_info.
+  /// @param slab_v0 Index in full grid of first vertex of slab grid.
+  void dual_contouring_merge_sharp_slab
+  (const MERGESHARP_DATA & slab_data, const SCALAR_TYPE isovalue,
+   const VERTEX_INDEX slab_v0,
+   const AXIS_SIZE_TYPE zc0, const AXIS_SIZE_TYPE zc1,
+   const VERTEX_INDEX num_vert_in_zplane,
+   FIXED_GCUBE_TABLE & fixed_table,
+   DUAL_ISOSURFACE & slab_isosurface,
+   MERGESHARP_INFO & slab_info)
+  {
+    MERGE_SHARP_HOOKS hooks;
+
+    hooks.fix_gcubes = [&](ISOVERT & isovert)
+      { set_fixed_gcubes(slab_v0, fixed_table, isovert); };
+
+    // Each quadrilateral is dual to a grid edge.  Assign the quadrilateral
+    //   to the slab containing the highest cube around the grid edge.
+    hooks.output_quad = 
+      [&](const std::vector<MERGESHARP::DUAL_ISOVERT> & iso_vlist,
+          const VERTEX_INDEX quad_vert[])
+      {
+        VERTEX_INDEX cube_max = 0;
+        for (NUM_TYPE k = 0; k < NUM_VERT_PER_QUAD; k++) {
+          cube_max = std::max(cube_max, iso_vlist[quad_vert[k]].cube_index);
+        }
+        const AXIS_SIZE_TYPE zmax = (cube_max+slab_v0)/num_vert_in_zplane;
+        return(zmax >= zc0 && zmax < zc1);
+      };
+
+    hooks.store_gcubes = 
+      [&](const ISOVERT & isovert, 
+          const std::vector<GRID_CUBE_FLAG> & select_flag,
+          const std::vector<VERTEX_INDEX> & gcube_map)
+      {
+        store_fixed_gcubes
+          (slab_v0, zc1, num_vert_in_zplane, isovert, select_flag, gcube_map,
+           fixed_table);
+      };
+
+    ISOVERT isovert;
+    isovert.sharp_ind_grid.SetSparse(slab_data.flag_sparse_gcube_index);
+
+    dual_contouring_merge_sharp_from_grad
+      (slab_data.ScalarGrid(), slab_data.MinMaxRegions(), 
+       slab_data.GradientGrid(), isovalue, slab_data, hooks, 
+       slab_isosurface, isovert, slab_info);
+  }
+
+  /// Add isosurface polygons of a slab to dual_isosurface.
+  /// @param slab_v0 Index in full grid of first vertex of slab grid.
+  /// @param isov_table Mesh index of each isosurface vertex
+  ///   already in dual_isosurface.
+  /// The first slab containing an isosurface vertex sets its coordinates.
+  void add_slab_polygons
+  (const VERTEX_INDEX slab_v0, const COORD_TYPE zoffset,
+   const VERTEX_INDEX_ARRAY & slab_poly_vert,
+   const std::vector<DUAL_ISOVERT_INFO> & slab_vertex_info,
+   const COORD_ARRAY & slab_vertex_coord,
+   VERTEX_INDEX_ARRAY & poly_vert,
+   DUAL_ISOSURFACE & dual_isosurface,
+   std::vector<DUAL_ISOVERT_INFO> & vertex_info,
+   ISOV_KEY_TABLE & isov_table)
+  {
+    for (NUM_TYPE j = 0; j < NUM_TYPE(slab_poly_vert.size()); j++) {
+      const VERTEX_INDEX iv = slab_poly_vert[j];
+      const VERTEX_INDEX cube_index = slab_vertex_info[iv].cube_index + slab_v0;
+      const ISOV_KEY key =
+        compute_isov_key(cube_index, slab_vertex_info[iv].patch_index);
+
+      ISOV_KEY_TABLE::iterator isov_iter = isov_table.find(key);
+      VERTEX_INDEX iw;
+      if (isov_iter == isov_table.end()) {
+        iw = dual_isosurface.NumVertices();
+        isov_table.insert(ISOV_KEY_TABLE::value_type(key, iw));
+        for (int d = 0; d < DIM3; d++) {
+          dual_isosurface.vertex_coord.push_back
+            (slab_vertex_coord[iv*DIM3+d]);
+        }
+        dual_isosurface.vertex_coord.back() += zoffset;
+        vertex_info.push_back(slab_vertex_info[iv]);
+        vertex_info.back().cube_index = cube_index;
+      }
+      else {
+        iw = isov_iter->second;
+      }
+
+      poly_vert.push_back(iw);
+    }
+  }
+
+  /// Return true if cube is on the grid boundary.
+  bool is_boundary_cube
+  (const SHARPISO_GRID & grid, const VERTEX_INDEX cube_index)
+  {
+    GCUBE_BOUNDARY_BITS_TYPE boundary_bits;
+    grid.ComputeBoundaryCubeBits(cube_index, boundary_bits);
+    return(boundary_bits != 0);
+  }
+
+  /// Count isosurface edges in exactly one isosurface polygon
+  ///   and in three or more isosurface polygons.
+  /// Edges between vertices in grid boundary cubes are not counted.
+  void count_open_and_non_manifold_edges
+  (const SHARPISO_GRID & grid, const DUAL_ISOSURFACE & dual_isosurface,
+   const std::vector<DUAL_ISOVERT_INFO> & vertex_info,
+   int & num_open_edges, int & num_non_manifold_edges)
+  {
+    std::vector<ISO_VERTEX_INDEX> quad_vert(dual_isosurface.quad_vert);
+    EDGE_HASH_TABLE edge_hash;
+
+    num_open_edges = 0;
+    num_non_manifold_edges = 0;
+
+    IJK::reorder_quad_vertices(quad_vert);
+    insert_tri_quad_edges(dual_isosurface.tri_vert, quad_vert, edge_hash);
+
+    for (EDGE_HASH_TABLE::const_iterator edge_iter = edge_hash.begin();
+         edge_iter != edge_hash.end(); edge_iter++) {
+      if (edge_iter->second == 2) { continue; }
+
+      const VERTEX_INDEX cube_index0 = 
+        vertex_info[edge_iter->first.first].cube_index;
+      const VERTEX_INDEX cube_index1 = 
+        vertex_info[edge_iter->first.second].cube_index;
+      if (is_boundary_cube(grid, cube_index0) && 
+          is_boundary_cube(grid, cube_index1)) { continue; }
+
+      if (edge_iter->second == 1) { num_open_edges++; }
+      else { num_non_manifold_edges++; }
+    }
+  }
+
+}
+
+
+// **************************************************
+// DUAL CONTOURING BY SLABS
+// **************************************************
+
+/// Dual contouring by z-slabs.
+void MERGESHARP::dual_contouring_slab
+(const SHARPISO_GRID & full_grid, const SET_SLAB_FUNCTION & set_slab,
+ const MERGESHARP_PARAM & mergesharp_param,
+ const SCALAR_TYPE isovalue,
+ DUAL_ISOSURFACE & dual_isosurface, MERGESHARP_INFO & mergesharp_info)
+{
+  const AXIS_SIZE_TYPE slab_thickness = mergesharp_param.slab_thickness;
+  const AXIS_SIZE_TYPE halo = compute_slab_halo(mergesharp_param);
+  PROCEDURE_ERROR error("dual_contouring_slab");
+
+  if (full_grid.Dimension() != DIM3) {
+    error.AddMessage("Programming error.  Grid dimension must be 3.");
+    throw error;
+  }
+
+  if (slab_thickness < 1) {
+    error.AddMessage("Programming error.  Slab thickness must be positive.");
+    throw error;
+  }
+
+  if (!mergesharp_param.allow_multiple_iso_vertices) {
+    error.AddMessage
+      ("Programming error.  Slabs require multiple isosurface vertices per cube.");
+    throw error;
+  }
+
+  const AXIS_SIZE_TYPE num_zcubes = full_grid.AxisSize(DIM3-1)-1;
+  const VERTEX_INDEX num_vert_in_zplane =
+    full_grid.AxisSize(0)*full_grid.AxisSize(1);
+  const COORD_TYPE zspacing = full_grid.Spacing(DIM3-1);
+
+  ISOV_KEY_TABLE isov_table;
+  FIXED_GCUBE_TABLE fixed_table;
+  std::vector<DUAL_ISOVERT_INFO> vertex_info;
+
+  dual_isosurface.Clear();
+  mergesharp_info.time.Clear();
+
+  for (AXIS_SIZE_TYPE zc0 = 0; zc0 < num_zcubes; zc0 += slab_thickness) {
+
+    // Slab contains cubes with z-coordinates in [zc0,zc1).
+    const AXIS_SIZE_TYPE zc1 = std::min(zc0+slab_thickness, num_zcubes);
+    const AXIS_SIZE_TYPE z0 = std::max(zc0-halo, 0);
+    const AXIS_SIZE_TYPE z1 = std::min(zc1+halo, num_zcubes);
+
+    MERGESHARP_DATA slab_data;
+    slab_data.Set(mergesharp_param);
+    slab_data.flag_store_isovert_info = true;
+    set_slab(z0, z1, slab_data);
+
+    if (slab_data.ScalarGrid().AxisSize(DIM3-1) != z1-z0+1) {
+      error.AddMessage("Programming error.  Incorrect size of slab [",
+                       z0, ",", z1, "].");
+      throw error;
+    }
+
+    slab_data.ComputeMinMaxRegions();
+
+    // Cubes below the slab are no longer needed.
+    erase_fixed_gcubes_below(z0, num_vert_in_zplane, fixed_table);
+
+    const VERTEX_INDEX slab_v0 = z0*num_vert_in_zplane;
+    const COORD_TYPE zoffset = z0*zspacing;
+
+    DUAL_ISOSURFACE slab_isosurface;
+    MERGESHARP_INFO slab_info(DIM3);
+    dual_contouring_merge_sharp_slab
+      (slab_data, isovalue, slab_v0, zc0, zc1, num_vert_in_zplane, 
+       fixed_table, slab_isosurface, slab_info);
+
+    const std::vector<DUAL_ISOVERT_INFO> & slab_vertex_info =
+      slab_info.sharpiso.vertex_info;
+
+    if (NUM_TYPE(slab_vertex_info.size()) != slab_isosurface.NumVertices()) {
+      error.AddMessage
+        ("Programming error.  Missing isosurface vertex information.");
+      throw error;
+    }
+
+    add_slab_polygons
+      (slab_v0, zoffset, slab_isosurface.tri_vert, slab_vertex_info, 
+       slab_isosurface.vertex_coord, dual_isosurface.tri_vert, 
+       dual_isosurface, vertex_info, isov_table);
+    add_slab_polygons
+      (slab_v0, zoffset, slab_isosurface.quad_vert, slab_vertex_info, 
+       slab_isosurface.vertex_coord, dual_isosurface.quad_vert, 
+       dual_isosurface, vertex_info, isov_table);
+
+    mergesharp_info.time.Add(slab_info.time);
+  }
+
+  // Polygons from adjacent slabs must share their edges.
+  count_open_and_non_manifold_edges
+    (full_grid, dual_isosurface, vertex_info,
+     mergesharp_info.sharpiso.num_open_edges,
+     mergesharp_info.sharpiso.num_non_manifold_edges);
+
+  mergesharp_info.sharpiso.vertex_info.swap(vertex_info);
+}
+
+/// Dual contouring by z-slabs of grids stored in memory.
+void MERGESHARP::dual_contouring_slab
+(const SHARPISO_SCALAR_GRID_BASE & full_scalar_grid,
+ const GRADIENT_GRID_BASE & full_gradient_grid,
+ const MERGESHARP_PARAM & mergesharp_param,
+ const SCALAR_TYPE isovalue,
+ DUAL_ISOSURFACE & dual_isosurface, MERGESHARP_INFO & mergesharp_info)
+{
+  PROCEDURE_ERROR error("dual_contouring_slab");
+
+  if (!full_gradient_grid.Check
+      (full_scalar_grid, "gradient grid", "scalar grid", error))
+    { throw error; }
+
+  dual_contouring_slab
+    (full_scalar_grid,
+     [&](const AXIS_SIZE_TYPE z0, const AXIS_SIZE_TYPE z1,
+         MERGESHARP_DATA & slab_data)
+     { slab_data.CopySlab(full_scalar_grid, full_gradient_grid, z0, z1); },
+     mergesharp_param, isovalue, dual_isosurface, mergesharp_info);
+}
+
+/// Return number of grid cubes added to each side of a slab.
+AXIS_SIZE_TYPE MERGESHARP::compute_slab_halo
+(const MERGESHARP_PARAM & mergesharp_param)
+{
+  // Gradients within max_grad_dist of a cube determine its isosurface vertex.
+  // Selection marks cubes within distance 2 of a selected cube
+  //   as covered or unavailable.
+  // Merging maps cubes within distance 2 to a selected cube.
+  // Two more cubes keep slab boundaries away from the cubes being fixed.
+  // No finite halo makes selection match the full grid exactly.
+  //   Selecting a cube changes which cubes near it may be selected,
+  //   so a different choice near a slab boundary can propagate.
+  const AXIS_SIZE_TYPE max_grad_dist = mergesharp_param.max_grad_dist;
+  return(std::max(max_grad_dist, 1) + 6);
+}
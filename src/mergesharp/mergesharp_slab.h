@@ -0,0 +1,99 @@
+/// \file mergesharp_slab.h
+/// Construct isosurface one z-slab of the grid at a time.
+
+/*
+  Copyright (C) 2013 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef _MERGESHARP_SLAB_
+#define _MERGESHARP_SLAB_
+
+#include <functional>
+
+#include "mergesharp_types.h"
+#include "mergesharp_datastruct.h"
+
+
+namespace MERGESHARP {
+
+  // **************************************************
+  // TYPES
+  // **************************************************
+
+  /// Set scalar and gradient grids of slab_data to the z-slab
+  ///   containing grid vertices with z-coordinates from z0 to z1.
+  /// Called concurrently from several threads for different isovalues.
+  typedef std::function<void
+  (const AXIS_SIZE_TYPE z0, const AXIS_SIZE_TYPE z1,
+   MERGESHARP_DATA & slab_data)> SET_SLAB_FUNCTION;
+
+
+  // **************************************************
+  // DUAL CONTOURING BY SLABS
+  // **************************************************
+
+  /// Dual contouring by z-slabs.
+  /// Each slab contains mergesharp_param.slab_thickness grid cubes
+  ///   along the z-axis plus a halo of compute_slab_halo() cubes
+  ///   on each side.
+  /// set_slab(z0,z1,slab_data) sets the scalar and gradient values
+  ///   in the slab and its halo.  Only one slab is stored at a time.
+  /// Slabs are processed in increasing z order.  Cube selection and
+  ///   merging in the lower halo of a slab are fixed to the decisions
+  ///   made in the previous slab, so adjacent slabs merge isosurface
+  ///   vertices on their common boundary the same way.
+  /// The isosurface may differ slightly from the isosurface of the
+  ///   full grid and depends on the slab thickness.  Fixed cubes are
+  ///   selected before the other cubes in the slab, and selecting
+  ///   a cube changes which cubes near it may be selected.
+  /// Each isosurface polygon is dual to a grid edge and is assigned
+  ///   to the slab containing the highest cube around the edge.
+  /// Isosurface vertices are identified across slabs by their
+  ///   grid cube and isosurface patch.
+  /// mergesharp_info.sharpiso.num_open_edges and num_non_manifold_edges
+  ///   count edges where the slab polygons do not fit together.
+  /// mergesharp_info.sharpiso.vertex_info stores the global cube
+  ///   and patch of each isosurface vertex.
+  /// @pre mergesharp_param.slab_thickness > 0.
+  /// @param full_grid Size and spacing of the full grid.
+  /// @pre mergesharp_param.allow_multiple_iso_vertices is true.
+  void dual_contouring_slab
+    (const SHARPISO_GRID & full_grid, const SET_SLAB_FUNCTION & set_slab,
+     const MERGESHARP_PARAM & mergesharp_param,
+     const SCALAR_TYPE isovalue,
+     DUAL_ISOSURFACE & dual_isosurface, MERGESHARP_INFO & mergesharp_info);
+
+  /// Dual contouring by z-slabs of scalar and gradient grids 
+  ///   stored in memory.
+  /// Each slab and its halo is copied from the full grids.
+  void dual_contouring_slab
+    (const SHARPISO_SCALAR_GRID_BASE & full_scalar_grid,
+     const GRADIENT_GRID_BASE & full_gradient_grid,
+     const MERGESHARP_PARAM & mergesharp_param,
+     const SCALAR_TYPE isovalue,
+     DUAL_ISOSURFACE & dual_isosurface, MERGESHARP_INFO & mergesharp_info);
+
+  /// Return number of grid cubes added to each side of a slab.
+  /// Halo covers the gradients within max_grad_dist of a cube,
+  ///   the 3x3x3 selection and covering neighborhoods and
+  ///   the cubes merged into a selected cube.
+  /// Halo does not make cube selection identical to the full grid.
+  AXIS_SIZE_TYPE compute_slab_halo(const MERGESHARP_PARAM & mergesharp_param);
+
+}
+
+#endif
@@ -38,8 +38,13 @@ namespace MERGESHARP {
 // SCALAR TYPES
 // **************************************************
 
-  typedef int ISO_VERTEX_INDEX;  ///< Isosurface vertex index type.
-  typedef int MERGE_INDEX;       ///< Merge index type.
+  /// Isosurface vertex index type.
+  /// 64-bit if SHARPISO_INDEX64 is defined.
+  typedef VERTEX_INDEX ISO_VERTEX_INDEX;
+
+  /// Merge index type.
+  /// 64-bit if SHARPISO_INDEX64 is defined.
+  typedef VERTEX_INDEX MERGE_INDEX;
 
   /// Edge index type.
   /// Vertex and edge indices must have the same type.
@@ -30,6 +30,7 @@
 #include "ijkcoord.txx"
 #include "ijkgrid.txx"
 #include "ijkinterpolate.txx"
+#include "ijkprofile.txx"
 #include "sharpiso_scalar.txx"
 #include "math.h"
 
@@ -82,14 +83,48 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
 	EIGENVALUE_TYPE eigenvalues[DIM3],
 	NUM_TYPE & num_large_eigenvalues,
 	SVD_INFO & svd_info)
+{
+	GET_GRADIENTS_SCRATCH scratch;
+
+	svd_compute_sharp_vertex_for_cube_lindstrom
+		(scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
+		voxel, scratch, sharp_coord, eigenvalues, num_large_eigenvalues,
+		svd_info);
+}
+
+/// Compute sharp isosurface vertex using singular valued decomposition.
+/// Use Lindstrom's formula.
+/// Use scratch memory for gradients.
+/// Also post processes vertices.
+void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const GRADIENT_GRID_BASE & gradient_grid,
+	const VERTEX_INDEX cube_index,
+	const SCALAR_TYPE isovalue,
+	const SHARP_ISOVERT_PARAM & sharpiso_param,
+	const OFFSET_VOXEL & voxel,
+	GET_GRADIENTS_SCRATCH & scratch,
+	COORD_TYPE sharp_coord[DIM3],
+	EIGENVALUE_TYPE eigenvalues[DIM3],
+	NUM_TYPE & num_large_eigenvalues,
+	SVD_INFO & svd_info)
 {
 	const EIGENVALUE_TYPE max_small_eigenvalue =
 		sharpiso_param.max_small_eigenvalue;
 
+	if (sharpiso_param.use_lindstrom_fast && !sharpiso_param.use_eigen_svd) {
+		svd_compute_sharp_vertex_for_cubes_lindstrom
+			(scalar_grid, gradient_grid, &cube_index, 1, isovalue,
+			sharpiso_param, voxel, scratch, sharp_coord, eigenvalues,
+			&num_large_eigenvalues, &svd_info);
+		return;
+	}
+
 	NUM_TYPE num_gradients = 0;
-	std::vector<COORD_TYPE> point_coord;
-	std::vector<GRADIENT_COORD_TYPE> gradient_coord;
-	std::vector<SCALAR_TYPE> scalar;
+	const std::vector<COORD_TYPE> & point_coord = scratch.point_coord;
+	const std::vector<GRADIENT_COORD_TYPE> & gradient_coord = 
+		scratch.gradient_coord;
+	const std::vector<SCALAR_TYPE> & scalar = scratch.scalar;
 
 	// Scale cube coord by spacings
 	COORD_TYPE cube_coord[DIM3];
@@ -98,7 +133,7 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
 	get_gradients
 		(scalar_grid, gradient_grid, cube_index, isovalue,
 		sharpiso_param, voxel, sharpiso_param.flag_sort_gradients,
-		point_coord, gradient_coord, scalar, num_gradients);
+		scratch, num_gradients);
 
 	if(num_gradients == 0)
 	{
@@ -106,6 +141,7 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
 		compute_edgeI_centroid
 			(scalar_grid, isovalue, cube_index, sharp_coord);
 
+		num_large_eigenvalues = 0;
 		svd_info.location = CENTROID;
 		return;
 	}
@@ -124,6 +160,7 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
 	/// use the sharp version with the garlnd heckbert way of storing normals
 	if (sharpiso_param.use_lindstrom_fast)
 	{
+		IJK_PROFILE_SCOPE(svd_timer, "svd");
 		svd_calculate_sharpiso_vertex_using_lindstrom_fast
 			(num_gradients, max_small_eigenvalue,isovalue, &(scalar[0]), 
 			&(point_coord[0]), &(gradient_coord[0]), 
@@ -134,6 +171,7 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
 	}
 	else
 	{
+		IJK_PROFILE_SCOPE(svd_timer, "svd");
 		svd_calculate_sharpiso_vertex_using_lindstrom
 			(sharpiso_param.use_lindstrom2, &(point_coord[0]),
 			&(gradient_coord[0]), &(scalar[0]),
@@ -147,6 +185,127 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
 		sharpiso_param, sharp_coord, svd_info);
 }
 
+/// Compute sharp isosurface vertices of a list of cubes
+///   using Lindstrom's formula.
+/// Also post processes vertices.
+void SHARPISO::svd_compute_sharp_vertex_for_cubes_lindstrom
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const GRADIENT_GRID_BASE & gradient_grid,
+	const VERTEX_INDEX cube_index[],
+	const NUM_TYPE num_cubes,
+	const SCALAR_TYPE isovalue,
+	const SHARP_ISOVERT_PARAM & sharpiso_param,
+	const OFFSET_VOXEL & voxel,
+	COORD_TYPE sharp_coord[],
+	EIGENVALUE_TYPE eigenvalues[],
+	NUM_TYPE num_large_eigenvalues[],
+	SVD_INFO svd_info[])
+{
+	GET_GRADIENTS_SCRATCH scratch;
+
+	svd_compute_sharp_vertex_for_cubes_lindstrom
+		(scalar_grid, gradient_grid, cube_index, num_cubes, isovalue,
+		sharpiso_param, voxel, scratch, sharp_coord, eigenvalues,
+		num_large_eigenvalues, svd_info);
+}
+
+/// Compute sharp isosurface vertices of a list of cubes
+///   using Lindstrom's formula.
+/// Use scratch memory for gradients.
+/// Also post processes vertices.
+void SHARPISO::svd_compute_sharp_vertex_for_cubes_lindstrom
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const GRADIENT_GRID_BASE & gradient_grid,
+	const VERTEX_INDEX cube_index[],
+	const NUM_TYPE num_cubes,
+	const SCALAR_TYPE isovalue,
+	const SHARP_ISOVERT_PARAM & sharpiso_param,
+	const OFFSET_VOXEL & voxel,
+	GET_GRADIENTS_SCRATCH & scratch,
+	COORD_TYPE sharp_coord[],
+	EIGENVALUE_TYPE eigenvalues[],
+	NUM_TYPE num_large_eigenvalues[],
+	SVD_INFO svd_info[])
+{
+	const EIGENVALUE_TYPE max_small_eigenvalue =
+		sharpiso_param.max_small_eigenvalue;
+
+	if (num_cubes > LINDSTROM_BATCH_SIZE) {
+		// Construct error only when needed, since it allocates memory.
+		IJK::PROCEDURE_ERROR error
+			("svd_compute_sharp_vertex_for_cubes_lindstrom");
+		error.AddMessage
+			("Programming error.  Number of cubes exceeds LINDSTROM_BATCH_SIZE.");
+		throw error;
+	}
+
+	const std::vector<COORD_TYPE> & point_coord = scratch.point_coord;
+	const std::vector<GRADIENT_COORD_TYPE> & gradient_coord = 
+		scratch.gradient_coord;
+	const std::vector<SCALAR_TYPE> & scalar = scratch.scalar;
+	LINDSTROM_3x3_BATCH batch;
+	NUM_TYPE batch_index[LINDSTROM_BATCH_SIZE];
+
+	for (NUM_TYPE i = 0; i < num_cubes; i++) {
+		NUM_TYPE num_gradients = 0;
+		COORD_TYPE * coord_i = sharp_coord + i*DIM3;
+
+		// Reuse scratch memory from the previous cube.
+		get_gradients
+			(scalar_grid, gradient_grid, cube_index[i], isovalue,
+			sharpiso_param, voxel, sharpiso_param.flag_sort_gradients,
+			scratch, num_gradients);
+
+		if (num_gradients == 0) {
+			compute_edgeI_centroid
+				(scalar_grid, isovalue, cube_index[i], coord_i);
+
+			num_large_eigenvalues[i] = 0;
+			svd_info[i].location = CENTROID;
+			batch_index[i] = -1;
+			continue;
+		}
+
+		svd_info[i].location = LOC_SVD;
+		svd_info[i].flag_conflict = false;
+		svd_info[i].flag_Linf_iso_vertex_location = false;
+
+		COORD_TYPE central_point[DIM3];
+		compute_central_point
+			(scalar_grid, gradient_grid, isovalue, cube_index[i],
+			sharpiso_param, central_point, svd_info[i]);
+
+		batch_index[i] = batch.AddCube
+			(num_gradients, isovalue, &(scalar[0]), &(point_coord[0]),
+			&(gradient_coord[0]), central_point);
+	}
+
+	{
+		// One svd call per cube, as in the unbatched code.
+		IJK_PROFILE_SCOPE_N(svd_timer, "svd", batch.num_cubes);
+		compute_lindstrom_3x3_batch(max_small_eigenvalue, batch);
+	}
+
+	for (NUM_TYPE i = 0; i < num_cubes; i++) {
+		const NUM_TYPE k = batch_index[i];
+		if (k < 0) { continue; }
+
+		COORD_TYPE * coord_i = sharp_coord + i*DIM3;
+		for (int d = 0; d < DIM3; d++) {
+			coord_i[d] = batch.coord[d][k];
+			eigenvalues[i*DIM3+d] = batch.eigenvalues[d][k];
+		}
+		num_large_eigenvalues[i] = batch.num_large_eigenvalues[k];
+
+		COORD_TYPE cube_coord[DIM3];
+		scalar_grid.ComputeScaledCoord(cube_index[i], cube_coord);
+
+		postprocess_isovert_location
+			(scalar_grid, gradient_grid, cube_index[i], cube_coord, isovalue,
+			sharpiso_param, coord_i, svd_info[i]);
+	}
+}
+
 // Compute sharp isosurface vertex using singular valued decomposition.
 // Use input edge-isosurface intersections and normals
 //   to position isosurface vertices on sharp features.
@@ -235,6 +394,21 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_hermite
 // COMPUTE SHARP VERTEX/EDGE USING SVD & EDGE-ISOSURFACE INTERSECTIONS
 // ********************************************************************
 
+/// Compute sharp isosurface vertex from edge-isosurface intersections
+///   and normals.
+void local_svd_compute_sharp_vertex_edgeI
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const GRADIENT_GRID_BASE & gradient_grid,
+ const VERTEX_INDEX cube_index,
+ const SCALAR_TYPE isovalue,
+ const SHARP_ISOVERT_PARAM & sharpiso_param,
+ const std::vector<COORD_TYPE> & edgeI_coord,
+ const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
+ COORD_TYPE sharp_coord[DIM3], 
+ EIGENVALUE_TYPE eigenvalues[DIM3],
+ NUM_TYPE & num_large_eigenvalues,
+ SVD_INFO & svd_info);
+
 /// Compute sharp isosurface vertex using edge-isosurface intersections.
 /// Approximate gradients using linear interpolation on the edges.
 void SHARPISO::svd_compute_sharp_vertex_edgeI_interpolate_gradients
@@ -250,42 +424,17 @@ void SHARPISO::svd_compute_sharp_vertex_edgeI_interpolate_gradients
 {
   const GRADIENT_COORD_TYPE max_small_magnitude =
     sharpiso_param.max_small_magnitude;
-  const EIGENVALUE_TYPE max_small_eigenvalue =
-    sharpiso_param.max_small_eigenvalue;
   std::vector<COORD_TYPE> edgeI_coord;
   std::vector<GRADIENT_COORD_TYPE> edgeI_normal_coord;
-  COORD_TYPE cube_coord[DIM3];
 
   compute_cube_edgeI_linear_interpolate
     (scalar_grid, gradient_grid, cube_index, isovalue,
      max_small_magnitude, edgeI_coord, edgeI_normal_coord);
 
-  if (edgeI_coord.size() > 0) {
-    NUM_TYPE num_gradients = edgeI_coord.size()/DIM3;
-
-    COORD_TYPE central_point[DIM3];
-    compute_central_point
-      (scalar_grid, gradient_grid, isovalue, cube_index, 
-       sharpiso_param, central_point, svd_info);
-
-    svd_calculate_sharpiso_vertex_using_lindstrom
-      (sharpiso_param.use_lindstrom2, &(edgeI_coord[0]),
-       &(edgeI_normal_coord[0]), 
-       num_gradients, isovalue, max_small_eigenvalue,
-       num_large_eigenvalues, eigenvalues, central_point, 
-       sharp_coord);
-
-    svd_info.location = LOC_SVD;
-  }
-  else{
-    scalar_grid.ComputeCubeCenterScaledCoord(cube_index, sharp_coord);
-    svd_info.location = CUBE_CENTER;
-  }
-
-  scalar_grid.ComputeScaledCoord(cube_index, cube_coord);
-  postprocess_isovert_location
-    (scalar_grid, gradient_grid, cube_index, cube_coord, isovalue,
-     sharpiso_param, sharp_coord, svd_info);
+  local_svd_compute_sharp_vertex_edgeI
+    (scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
+     edgeI_coord, edgeI_normal_coord, sharp_coord, 
+     eigenvalues, num_large_eigenvalues, svd_info);
 }
 
 /// Compute sharp isosurface vertex using edge-isosurface intersections.
@@ -302,9 +451,6 @@ void SHARPISO::svd_compute_sharp_vertex_edgeI_sharp_gradient
 {
   const GRADIENT_COORD_TYPE max_small_magnitude =
     sharpiso_param.max_small_magnitude;
-  const EIGENVALUE_TYPE max_small_eigenvalue =
-    sharpiso_param.max_small_eigenvalue;
-  COORD_TYPE cube_coord[DIM3];
   std::vector<COORD_TYPE> edgeI_coord;
   std::vector<GRADIENT_COORD_TYPE> edgeI_normal_coord;
 
@@ -312,6 +458,55 @@ void SHARPISO::svd_compute_sharp_vertex_edgeI_sharp_gradient
     (scalar_grid, gradient_grid, cube_index, isovalue,
      max_small_magnitude, edgeI_coord, edgeI_normal_coord);
 
+  local_svd_compute_sharp_vertex_edgeI
+    (scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
+     edgeI_coord, edgeI_normal_coord, sharp_coord, 
+     eigenvalues, num_large_eigenvalues, svd_info);
+}
+
+/// Compute sharp isosurface vertex using edge-isosurface intersections
+///   stored in edgeI_cache.
+/// Use scratch memory for the intersections on the cube edges.
+void SHARPISO::svd_compute_sharp_vertex_edgeI
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const GRADIENT_GRID_BASE & gradient_grid,
+ const EDGEI_CACHE & edgeI_cache,
+ const NUM_TYPE icube,
+ const VERTEX_INDEX cube_index,
+ const SHARP_ISOVERT_PARAM & sharpiso_param,
+ GET_GRADIENTS_SCRATCH & scratch,
+ COORD_TYPE sharp_coord[DIM3], EIGENVALUE_TYPE eigenvalues[DIM3],
+ NUM_TYPE & num_large_eigenvalues,
+ SVD_INFO & svd_info)
+{
+  edgeI_cache.GetCubeEdgeI
+    (icube, scratch.point_coord, scratch.gradient_coord);
+
+  local_svd_compute_sharp_vertex_edgeI
+    (scalar_grid, gradient_grid, cube_index, edgeI_cache.Isovalue(), 
+     sharpiso_param, scratch.point_coord, scratch.gradient_coord, 
+     sharp_coord, eigenvalues, num_large_eigenvalues, svd_info);
+}
+
+// Compute sharp isosurface vertex from edge-isosurface intersections
+//   and normals.
+void local_svd_compute_sharp_vertex_edgeI
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const GRADIENT_GRID_BASE & gradient_grid,
+ const VERTEX_INDEX cube_index,
+ const SCALAR_TYPE isovalue,
+ const SHARP_ISOVERT_PARAM & sharpiso_param,
+ const std::vector<COORD_TYPE> & edgeI_coord,
+ const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
+ COORD_TYPE sharp_coord[DIM3], 
+ EIGENVALUE_TYPE eigenvalues[DIM3],
+ NUM_TYPE & num_large_eigenvalues,
+ SVD_INFO & svd_info)
+{
+  const EIGENVALUE_TYPE max_small_eigenvalue =
+    sharpiso_param.max_small_eigenvalue;
+  COORD_TYPE cube_coord[DIM3];
+
   if (edgeI_coord.size() > 0) {
     NUM_TYPE num_gradients = edgeI_coord.size()/DIM3;
 
@@ -380,15 +575,37 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lc_intersection
  EIGENVALUE_TYPE eigenvalues[DIM3],
  NUM_TYPE & num_large_eigenvalues,
  SVD_INFO & svd_info)
+{
+  GET_GRADIENTS_SCRATCH scratch;
+
+  svd_compute_sharp_vertex_for_cube_lc_intersection
+    (scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
+     voxel, scratch, sharp_coord, eigenvalues, num_large_eigenvalues,
+     svd_info);
+}
+
+/// Compute sharp isosurface vertex using singular valued decomposition.
+/// Use line-cube intersection to compute sharp isosurface vertex
+///    when number of eigenvalues is 2.
+/// Use scratch memory for gradients.
+void SHARPISO::svd_compute_sharp_vertex_for_cube_lc_intersection
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const GRADIENT_GRID_BASE & gradient_grid,
+ const VERTEX_INDEX cube_index,
+ const SCALAR_TYPE isovalue,
+ const SHARP_ISOVERT_PARAM & sharpiso_param,
+ const OFFSET_VOXEL & voxel,
+ GET_GRADIENTS_SCRATCH & scratch,
+ COORD_TYPE sharp_coord[DIM3],
+ EIGENVALUE_TYPE eigenvalues[DIM3],
+ NUM_TYPE & num_large_eigenvalues,
+ SVD_INFO & svd_info)
 {
   const EIGENVALUE_TYPE max_small_eigenvalue =
     sharpiso_param.max_small_eigenvalue;
   const COORD_TYPE max_dist = sharpiso_param.max_dist;
 
   NUM_TYPE num_gradients = 0;
-  std::vector<COORD_TYPE> point_coord;
-  std::vector<GRADIENT_COORD_TYPE> gradient_coord;
-  std::vector<SCALAR_TYPE> scalar;
   GRADIENT_COORD_TYPE line_direction[DIM3];
 
   // Compute coord of the cube.
@@ -398,7 +615,7 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lc_intersection
   get_gradients
     (scalar_grid, gradient_grid, cube_index, isovalue,
      sharpiso_param, voxel, sharpiso_param.flag_sort_gradients,
-     point_coord, gradient_coord, scalar, num_gradients);
+     scratch, num_gradients);
 
   svd_info.location = LOC_SVD;
   svd_info.flag_conflict = false;
@@ -406,7 +623,8 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lc_intersection
 
   local_svd_compute_sharp_vertex_for_cube_lc_intersection
     (scalar_grid, gradient_grid, cube_index, cube_coord, isovalue,
-     sharpiso_param, point_coord, gradient_coord, scalar, num_gradients,
+     sharpiso_param, scratch.point_coord, scratch.gradient_coord,
+     scratch.scalar, num_gradients,
      sharp_coord, eigenvalues, num_large_eigenvalues, svd_info);
 
   postprocess_isovert_location
@@ -487,9 +705,9 @@ void SHARPISO::compute_vertex_on_line
   const COORD_TYPE snap_dist = sharpiso_param.snap_dist;
   const GRADIENT_COORD_TYPE zero_tolerance = sharpiso_param.zero_tolerance;
   VERTEX_INDEX conflicting_cube;
-  static GRID_COORD_TYPE cube_coord[DIM3];
-  static GRID_COORD_TYPE conflicting_cube_coord[DIM3];
-  static COORD_TYPE Linf_coord[DIM3];
+  GRID_COORD_TYPE cube_coord[DIM3];
+  GRID_COORD_TYPE conflicting_cube_coord[DIM3];
+  COORD_TYPE Linf_coord[DIM3];
   VERTEX_INDEX icoord;
   NUM_TYPE num_diff;
 
@@ -570,9 +788,9 @@ void SHARPISO::svd_compute_sharp_vertex_near_facet
   std::vector<COORD_TYPE> point_coord;
   std::vector<GRADIENT_COORD_TYPE> gradient_coord;
   std::vector<SCALAR_TYPE> scalar;
-  static COORD_TYPE v0_coord[DIM3];
-  static COORD_TYPE end[2][DIM3];
-  static COORD_TYPE endc[2];
+  COORD_TYPE v0_coord[DIM3];
+  COORD_TYPE end[2][DIM3];
+  COORD_TYPE endc[2];
 
   // Initialize
   sharp_vertex_location = 0;
@@ -1108,7 +1326,7 @@ void get_cube_containing_point
 (const SHARPISO_GRID & grid, const COORD_TYPE * coord,
  VERTEX_INDEX & cube_index, bool & flag_boundary)
 {
-  static COORD_TYPE coord2[DIM3];
+  COORD_TYPE coord2[DIM3];
 
   flag_boundary = false;
   for (int d = 0; d < DIM3; d++) {
@@ -1132,7 +1350,7 @@ void get_all_cubes_containing_point
 (const SHARPISO_GRID & grid, const COORD_TYPE * coord,
  std::vector<VERTEX_INDEX> & cube_list)
 {
-  static COORD_TYPE coord2[DIM3];
+  COORD_TYPE coord2[DIM3];
 
   cube_list.clear();
 
@@ -1322,6 +1540,7 @@ void SHARPISO::SHARP_ISOVERT_PARAM::Init()
   use_lindstrom = true;
   use_lindstrom2 = false;
   use_lindstrom_fast = true;
+  use_eigen_svd = true;
   flag_allow_conflict = false;
   flag_clamp_conflict = true;
   flag_clamp_far = false;
@@ -1337,6 +1556,7 @@ void SHARPISO::SHARP_ISOVERT_PARAM::Init()
   max_small_grad_coord_Linf = 0.2;
   linf_dist_thresh_merge_sharp = 1.5;
   bin_width = 5;
+  num_threads = 1;
   flag_map_extended = false;
 }
 
@@ -28,6 +28,7 @@
 #include "sharpiso_eigen.h"
 #include "sharpiso_get_gradients.h"
 #include "sharpiso_grids.h"
+#include "sharpiso_intersect.h"
 #include "sharpiso_types.h"
 
 #include "ijkgrid.txx"
@@ -63,6 +64,61 @@ namespace SHARPISO {
    NUM_TYPE & num_large_eigenvalues,
    SVD_INFO & svd_info);
 
+  /// Compute sharp isosurface vertex using singular valued decomposition.
+  /// Use Lindstrom's formula.
+  /// Use scratch memory for gradients.
+  void svd_compute_sharp_vertex_for_cube_lindstrom
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_GRID_BASE & gradient_grid,
+   const VERTEX_INDEX cube_index,
+   const SCALAR_TYPE isovalue,
+   const SHARP_ISOVERT_PARAM & sharpiso_param,
+   const OFFSET_VOXEL & voxel,
+   GET_GRADIENTS_SCRATCH & scratch,
+   COORD_TYPE sharp_coord[DIM3],
+   EIGENVALUE_TYPE eigenvalues[DIM3],
+   NUM_TYPE & num_large_eigenvalues,
+   SVD_INFO & svd_info);
+
+  /// Compute sharp isosurface vertices of a list of cubes
+  ///   using Lindstrom's formula.
+  /// Solve the normal equations of all cubes together
+  ///   with compute_lindstrom_3x3_batch().
+  /// Also post processes vertices.
+  /// @param sharp_coord[] Array of num_cubes*DIM3 coordinates.
+  /// @param eigenvalues[] Array of num_cubes*DIM3 eigenvalues.
+  /// @pre num_cubes <= LINDSTROM_BATCH_SIZE.
+  void svd_compute_sharp_vertex_for_cubes_lindstrom
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_GRID_BASE & gradient_grid,
+   const VERTEX_INDEX cube_index[],
+   const NUM_TYPE num_cubes,
+   const SCALAR_TYPE isovalue,
+   const SHARP_ISOVERT_PARAM & sharpiso_param,
+   const OFFSET_VOXEL & voxel,
+   COORD_TYPE sharp_coord[],
+   EIGENVALUE_TYPE eigenvalues[],
+   NUM_TYPE num_large_eigenvalues[],
+   SVD_INFO svd_info[]);
+
+  /// Compute sharp isosurface vertices of a list of cubes
+  ///   using Lindstrom's formula.
+  /// Use scratch memory for gradients.
+  /// @pre num_cubes <= LINDSTROM_BATCH_SIZE.
+  void svd_compute_sharp_vertex_for_cubes_lindstrom
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_GRID_BASE & gradient_grid,
+   const VERTEX_INDEX cube_index[],
+   const NUM_TYPE num_cubes,
+   const SCALAR_TYPE isovalue,
+   const SHARP_ISOVERT_PARAM & sharpiso_param,
+   const OFFSET_VOXEL & voxel,
+   GET_GRADIENTS_SCRATCH & scratch,
+   COORD_TYPE sharp_coord[],
+   EIGENVALUE_TYPE eigenvalues[],
+   NUM_TYPE num_large_eigenvalues[],
+   SVD_INFO svd_info[]);
+
   /// Compute sharp isosurface vertex using singular valued decomposition.
   /// Use input edge-isosurface intersections and normals
   ///   to position isosurface vertices on sharp features.
@@ -108,6 +164,23 @@ namespace SHARPISO {
    NUM_TYPE & num_large_eigenvalues,
    SVD_INFO & svd_info);
 
+  /// Compute sharp isosurface vertex using edge-isosurface intersections
+  ///   and normals stored in edgeI_cache.
+  /// Use scratch memory for the intersections on the cube edges.
+  /// @param icube Location of cube_index in the cube list
+  ///   used to set edgeI_cache.
+  void svd_compute_sharp_vertex_edgeI
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_GRID_BASE & gradient_grid,
+   const EDGEI_CACHE & edgeI_cache,
+   const NUM_TYPE icube,
+   const VERTEX_INDEX cube_index,
+   const SHARP_ISOVERT_PARAM & sharpiso_param,
+   GET_GRADIENTS_SCRATCH & scratch,
+   COORD_TYPE coord[DIM3], EIGENVALUE_TYPE eigenvalues[DIM3],
+   NUM_TYPE & num_large_eigenvalues,
+   SVD_INFO & svd_info);
+
 
   // ********************************************************************
   // COMPUTE SHARP ISOSURFACE VERTEX NEAR FACET
@@ -166,6 +239,23 @@ namespace SHARPISO {
    NUM_TYPE & num_large_eigenvalues,
    SVD_INFO & svd_info);
 
+  /// Compute sharp isosurface vertex using singular valued decomposition.
+  /// Use line-cube intersection to compute sharp isosurface vertex
+  ///    when number of eigenvalues is 2.
+  /// Use scratch memory for gradients.
+  void svd_compute_sharp_vertex_for_cube_lc_intersection
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_GRID_BASE & gradient_grid,
+   const VERTEX_INDEX cube_index,
+   const SCALAR_TYPE isovalue,
+   const SHARP_ISOVERT_PARAM & sharpiso_param,
+   const OFFSET_VOXEL & voxel,
+   GET_GRADIENTS_SCRATCH & scratch,
+   COORD_TYPE sharp_coord[DIM3],
+   EIGENVALUE_TYPE eigenvalues[DIM3],
+   NUM_TYPE & num_large_eigenvalues,
+   SVD_INFO & svd_info);
+
   /// Compute sharp isosurface vertex on the line
   /// @param flag_conflict True if sharp_coord conflicts with other cube.
   void compute_vertex_on_line
@@ -323,6 +413,7 @@ namespace SHARPISO {
     bool use_lindstrom;            ///< If true, use Lindstrom formula
     bool use_lindstrom2;
     bool use_lindstrom_fast;       /// use the garland heckbert approach
+    bool use_eigen_svd;            ///< If true, use Eigen JacobiSVD for Lindstrom.
     bool use_Linf_dist;            ///< If true, use Linf dist.
 	bool flag_map_extended;        ///< If true, then the extended version of mapping used.
 
@@ -364,6 +455,11 @@ namespace SHARPISO {
     /// Round to nearest 1/round_denominator
     int round_denominator;
 
+    /// Number of threads used to compute isosurface vertex positions,
+    ///   to select sharp isosurface vertices and to extract
+    ///   dual isosurface polytopes.
+    int num_threads;
+
     /// Constructor
     SHARP_ISOVERT_PARAM() { Init(); };
 
@@ -21,6 +21,7 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+#include <algorithm>
 #include <iomanip>
 
 #include "sharpiso_get_gradients.h"
@@ -29,6 +30,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "ijkcoord.txx"
 #include "ijkgrid.txx"
 #include "ijkinterpolate.txx"
+#include "ijkprofile.txx"
 #include "sharpiso_scalar.txx"
 
 
@@ -147,9 +149,8 @@ namespace {
 	{
 		typedef SHARPISO_SCALAR_GRID::DIMENSION_TYPE DTYPE;
 
-		// static so not reallocated at each call
-		static GRID_COORD_TYPE vertex_coord[DIM3];
-		static SIGNED_COORD_TYPE coord[DIM3];
+		GRID_COORD_TYPE vertex_coord[DIM3];
+		SIGNED_COORD_TYPE coord[DIM3];
 
 		GRADIENT_COORD_TYPE magnitude_squared =
 			gradient_grid.ComputeMagnitudeSquared(iv);
@@ -191,6 +192,8 @@ namespace {
 	}
 
 	/// Get selected vertices
+	/// @param vertex_flag[] Work array.
+	/// @pre Size of vertex_flag[] is at least num_vertices.
 	void get_selected_vertices
 		(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 		const GRADIENT_GRID_BASE & gradient_grid,
@@ -200,6 +203,7 @@ namespace {
 		const OFFSET_VOXEL & voxel,
 		const int num_vertices,
 		VERTEX_INDEX vertex_list[],
+		bool vertex_flag[],
 		NUM_TYPE & num_selected)
 	{
 		const GRADIENT_COORD_TYPE max_small_mag = 
@@ -207,14 +211,13 @@ namespace {
 		const GRADIENT_COORD_TYPE max_small_mag_squared = 
 			max_small_mag * max_small_mag;
 
-		// static so not reallocated at each call
-		static GRID_COORD_TYPE cube_coord[DIM3];
+		GRID_COORD_TYPE cube_coord[DIM3];
 
-		IJK::ARRAY<bool> vertex_flag(num_vertices, true);
+		std::fill(vertex_flag, vertex_flag+num_vertices, true);
 
 		deselect_vertices_with_small_gradients
 			(gradient_grid, vertex_list, num_vertices, max_small_mag_squared,
-			vertex_flag.Ptr());
+			vertex_flag);
 
 		if (sharpiso_param.use_selected_gradients &&
 			!sharpiso_param.select_based_on_grad_dir) {
@@ -223,16 +226,16 @@ namespace {
 
 				deselect_vertices_based_on_isoplanes
 					(scalar_grid, gradient_grid, cube_coord, voxel,
-					isovalue, vertex_list, num_vertices, vertex_flag.Ptr());
+					isovalue, vertex_list, num_vertices, vertex_flag);
 		}
 
 		num_selected = num_vertices;
-		get_flagged_list_elements
-			(vertex_flag.PtrConst(), vertex_list, num_selected);
+		get_flagged_list_elements(vertex_flag, vertex_list, num_selected);
 	}
 
 	/// Get selected vertices.
 	/// Resizes vector vertex_list.
+	/// Uses scratch.VertexFlag() as work array.
 	void get_selected_vertices
 		(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 		const GRADIENT_GRID_BASE & gradient_grid,
@@ -240,13 +243,15 @@ namespace {
 		const SCALAR_TYPE isovalue,
 		const GET_GRADIENTS_PARAM & sharpiso_param,
 		const OFFSET_VOXEL & voxel,
+		GET_GRADIENTS_SCRATCH & scratch,
 		std::vector<VERTEX_INDEX> & vertex_list)
 	{
-		int num_selected;
+		NUM_TYPE num_selected;
 
 		get_selected_vertices
 			(scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param, voxel,
-			vertex_list.size(), &(vertex_list[0]), num_selected);
+			vertex_list.size(), &(vertex_list[0]),
+			scratch.VertexFlag(vertex_list.size()), num_selected);
 		vertex_list.resize(num_selected);
 	}
 
@@ -288,11 +293,10 @@ namespace {
 		NUM_TYPE & num_selected)
 	{
 		// NOTE: cube_vertex_list is an array.
-		// static so not reallocated at each call
-		static GRID_COORD_TYPE cube_coord[DIM3];
+		GRID_COORD_TYPE cube_coord[DIM3];
 
 		NUM_TYPE num_vertices(0);
-		IJK::ARRAY<bool> vertex_flag(NUM_CUBE_VERTICES3D, true);
+		bool vertex_flag[NUM_CUBE_VERTICES3D];
 
 		if (sharpiso_param.use_intersected_edge_endpoint_gradients) {
 
@@ -319,7 +323,7 @@ namespace {
 
 		get_selected_vertices
 			(scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
-			voxel, num_vertices, cube_vertex_list, num_selected);
+			voxel, num_vertices, cube_vertex_list, vertex_flag, num_selected);
 	}
 
 }
@@ -336,6 +340,7 @@ void SHARPISO::get_selected_vertex_gradients
 	std::vector<SCALAR_TYPE> & scalar,
 	NUM_TYPE & num_gradients)
 {
+	IJK_PROFILE_SCOPE(gradient_timer, "get_selected_vertex_gradients");
 	num_gradients = 0;
 
 	for (NUM_TYPE i = 0; i < num_vertices; i++) {
@@ -466,139 +471,192 @@ void SHARPISO::get_cube_gradients
 }
 
 
-/// Get gradients.
-/// @param sharpiso_param Determines which gradients are selected.
-/// @param flag_sort_gradients If true, sort gradients.  
-///        Overrides flag_sort_gradients in sharpiso_param.
-void SHARPISO::get_gradients
-	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
-	const GRADIENT_GRID_BASE & gradient_grid,
-	const VERTEX_INDEX cube_index,
-	const SCALAR_TYPE isovalue,
-	const GET_GRADIENTS_PARAM & sharpiso_param,
-	const OFFSET_VOXEL & voxel,
-	const bool flag_sort_gradients,
-	std::vector<COORD_TYPE> & point_coord,
-	std::vector<GRADIENT_COORD_TYPE> & gradient_coord,
-	std::vector<SCALAR_TYPE> & scalar,
-	NUM_TYPE & num_gradients)
-{
-	//DEBUG
-	using namespace std;
+namespace {
 
-	if (sharpiso_param.use_only_cube_gradients && 
-		!sharpiso_param.allow_duplicates) 
+	/// Get gradients.
+	/// Use scratch.vertex_list and other scratch memory for temporary lists.
+	void get_gradients_local
+		(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+		const GRADIENT_GRID_BASE & gradient_grid,
+		const VERTEX_INDEX cube_index,
+		const SCALAR_TYPE isovalue,
+		const GET_GRADIENTS_PARAM & sharpiso_param,
+		const OFFSET_VOXEL & voxel,
+		const bool flag_sort_gradients,
+		GET_GRADIENTS_SCRATCH & scratch,
+		std::vector<COORD_TYPE> & point_coord,
+		std::vector<GRADIENT_COORD_TYPE> & gradient_coord,
+		std::vector<SCALAR_TYPE> & scalar,
+		NUM_TYPE & num_gradients)
 	{
+		IJK_PROFILE_SCOPE(gradient_timer, "get_gradients");
 
-		// NOTE: cube_vertex_list is an array.
-		VERTEX_INDEX cube_vertex_list[NUM_CUBE_VERTICES3D];
+		//DEBUG
+		using namespace std;
 
-		get_cube_vertices_with_selected_gradients
-			(scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
-			voxel, cube_vertex_list, num_gradients);
+		if (sharpiso_param.use_only_cube_gradients && 
+			!sharpiso_param.allow_duplicates) 
+		{
 
-		if (flag_sort_gradients) {
-			sort_vertices_by_isoplane_dist2cc
-				(scalar_grid, gradient_grid, isovalue, cube_index,
-				cube_vertex_list, num_gradients);
-		}
+			// NOTE: cube_vertex_list is an array.
+			VERTEX_INDEX cube_vertex_list[NUM_CUBE_VERTICES3D];
 
-		get_vertex_gradients
-			(scalar_grid, gradient_grid, cube_vertex_list, num_gradients, 
-			point_coord, gradient_coord, scalar);
-	}
-	else 
-	{
+			get_cube_vertices_with_selected_gradients
+				(scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
+				voxel, cube_vertex_list, num_gradients);
 
-		// NOTE: vertex_list is a C++ vector.
-		std::vector<VERTEX_INDEX> vertex_list;
-		//cube gradients
-		if (sharpiso_param.use_only_cube_gradients) 
-		{
+			if (flag_sort_gradients) {
+				sort_vertices_by_isoplane_dist2cc
+					(scalar_grid, gradient_grid, isovalue, cube_index,
+					cube_vertex_list, num_gradients);
+			}
 
-			get_cube_vertices_determining_edgeI_allow_duplicates
-				(scalar_grid, gradient_grid, cube_index, isovalue, 
-				vertex_list);
+			get_vertex_gradients
+				(scalar_grid, gradient_grid, cube_vertex_list, num_gradients, 
+				point_coord, gradient_coord, scalar);
 		}
-		//using large neighborhood
-		else if (sharpiso_param.use_large_neighborhood) 
+		else 
 		{
 
-			if (sharpiso_param.use_zero_grad_boundary) {
-
-        if (sharpiso_param.use_new_version) {
-          get_ie_endpoints_in_large_neighborhood
-            (scalar_grid, gradient_grid, isovalue, cube_index,
-             sharpiso_param, vertex_list);
-        }
-        else {
-          get_ie_endpoints_in_large_neighborhood_old_version
-            (scalar_grid, gradient_grid, isovalue, cube_index,
-             sharpiso_param, vertex_list);
-        }
+			// NOTE: vertex_list is a C++ vector.
+			std::vector<VERTEX_INDEX> & vertex_list = scratch.vertex_list;
+			vertex_list.clear();
+
+			//cube gradients
+			if (sharpiso_param.use_only_cube_gradients) 
+			{
+
+				get_cube_vertices_determining_edgeI_allow_duplicates
+					(scalar_grid, gradient_grid, cube_index, isovalue, 
+					vertex_list);
 			}
-			else {
+			//using large neighborhood
+			else if (sharpiso_param.use_large_neighborhood) 
+			{
+
+				if (sharpiso_param.use_zero_grad_boundary) {
+
+	        if (sharpiso_param.use_new_version) {
+	          get_ie_endpoints_in_large_neighborhood
+	            (scalar_grid, gradient_grid, isovalue, cube_index,
+	             sharpiso_param, scratch, vertex_list);
+	        }
+	        else {
+	          get_ie_endpoints_in_large_neighborhood_old_version
+	            (scalar_grid, gradient_grid, isovalue, cube_index,
+	             sharpiso_param, vertex_list);
+	        }
+				}
+				else {
+
+					get_vertices_with_large_gradient_magnitudes
+						(scalar_grid, gradient_grid, cube_index, sharpiso_param, vertex_list);
+				}
+			}//large neighborhood end.
+			//use intersected neighbors.
+			else if (sharpiso_param.use_intersected_edge_endpoint_gradients) 
+			{
 
-				get_vertices_with_large_gradient_magnitudes
-					(scalar_grid, gradient_grid, cube_index, sharpiso_param, vertex_list);
+				get_intersected_cube_neighbor_edge_endpoints  
+					(scalar_grid, cube_index, isovalue, vertex_list);
 			}
-		}//large neighborhood end.
-		//use intersected neighbors.
-		else if (sharpiso_param.use_intersected_edge_endpoint_gradients) 
-		{
+			else 
+			{
 
-			get_intersected_cube_neighbor_edge_endpoints  
-				(scalar_grid, cube_index, isovalue, vertex_list);
-		}
-		else 
-		{
+				get_cube_neighbor_vertices(scalar_grid, cube_index, vertex_list);
+			}
+
+			get_selected_vertices
+				(scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
+				voxel, scratch, vertex_list);
 
-			get_cube_neighbor_vertices(scalar_grid, cube_index, vertex_list);
+			if (flag_sort_gradients) {
+				sort_vertices_by_isoplane_dist2cc
+					(scalar_grid, gradient_grid, isovalue, cube_index, vertex_list);
+			}
+
+			get_vertex_gradients
+				(scalar_grid, gradient_grid, vertex_list,
+				point_coord, gradient_coord, scalar);
+			num_gradients = vertex_list.size();
 		}
 
-		get_selected_vertices
-			(scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
-			voxel, vertex_list);
+		//DEBUG
+		/* 
+		using namespace std;
+		cout <<"\ngradients: "<<endl;
+		cout <<"num large "<< gradient_coord.size()/3<<" "<< num_gradients<<endl;
 
-		if (flag_sort_gradients) {
-			sort_vertices_by_isoplane_dist2cc
-				(scalar_grid, gradient_grid, isovalue, cube_index, vertex_list);
+		if (num_gradients >0)
+		{
+		for (int i = 0; i < gradient_coord.size()/3; i++ )
+		{
+
+		float gradient_magnitude = 0.0;
+		IJK::compute_magnitude(DIM3,&(gradient_coord[DIM3 * i]), gradient_magnitude );
+		cout <<"["<<setw(7)<<point_coord[3*i+0] 
+		<<" "<<setw(7)<<point_coord[3*i+1] 
+		<<" "<<setw(4)<<point_coord[3*i+2]<<"] ["; 
+		cout <<setw(3)<<point_coord[3*i+0]/scalar_grid.Spacing(0) 
+		<<" "<<setw(3)<<point_coord[3*i+1]/scalar_grid.Spacing(1) 
+		<<" "<<setw(3)<<point_coord[3*i+2]/scalar_grid.Spacing(2)<<"]";
+
+		cout <<" s "<<scalar[i];
+		cout <<setw(12)<<" [ "<<gradient_coord[3*i+0]/gradient_magnitude 
+		<<" "<<setw(12)<<gradient_coord[3*i+1]/gradient_magnitude 
+		<<" "<<setw(12)<<gradient_coord[3*i+2]/gradient_magnitude <<"]\n";
 		}
+		cout <<"\n";
+		}*/
 
-		get_vertex_gradients
-			(scalar_grid, gradient_grid, vertex_list,
-			point_coord, gradient_coord, scalar);
-		num_gradients = vertex_list.size();
 	}
 
-	//DEBUG
-	/* 
-	using namespace std;
-	cout <<"\ngradients: "<<endl;
-	cout <<"num large "<< gradient_coord.size()/3<<" "<< num_gradients<<endl;
-
-	if (num_gradients >0)
-	{
-	for (int i = 0; i < gradient_coord.size()/3; i++ )
-	{
+}
 
-	float gradient_magnitude = 0.0;
-	IJK::compute_magnitude(DIM3,&(gradient_coord[DIM3 * i]), gradient_magnitude );
-	cout <<"["<<setw(7)<<point_coord[3*i+0] 
-	<<" "<<setw(7)<<point_coord[3*i+1] 
-	<<" "<<setw(4)<<point_coord[3*i+2]<<"] ["; 
-	cout <<setw(3)<<point_coord[3*i+0]/scalar_grid.Spacing(0) 
-	<<" "<<setw(3)<<point_coord[3*i+1]/scalar_grid.Spacing(1) 
-	<<" "<<setw(3)<<point_coord[3*i+2]/scalar_grid.Spacing(2)<<"]";
+/// Get gradients.
+/// @param sharpiso_param Determines which gradients are selected.
+/// @param flag_sort_gradients If true, sort gradients.  
+///        Overrides flag_sort_gradients in sharpiso_param.
+void SHARPISO::get_gradients
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const GRADIENT_GRID_BASE & gradient_grid,
+	const VERTEX_INDEX cube_index,
+	const SCALAR_TYPE isovalue,
+	const GET_GRADIENTS_PARAM & sharpiso_param,
+	const OFFSET_VOXEL & voxel,
+	const bool flag_sort_gradients,
+	std::vector<COORD_TYPE> & point_coord,
+	std::vector<GRADIENT_COORD_TYPE> & gradient_coord,
+	std::vector<SCALAR_TYPE> & scalar,
+	NUM_TYPE & num_gradients)
+{
+	GET_GRADIENTS_SCRATCH scratch;
 
-	cout <<" s "<<scalar[i];
-	cout <<setw(12)<<" [ "<<gradient_coord[3*i+0]/gradient_magnitude 
-	<<" "<<setw(12)<<gradient_coord[3*i+1]/gradient_magnitude 
-	<<" "<<setw(12)<<gradient_coord[3*i+2]/gradient_magnitude <<"]\n";
-	}
-	cout <<"\n";
-	}*/
+	get_gradients_local
+		(scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
+		voxel, flag_sort_gradients, scratch, point_coord, gradient_coord,
+		scalar, num_gradients);
+}
 
+/// Get gradients.
+/// Use scratch memory instead of allocating temporary lists.
+/// Return gradients in scratch.point_coord, scratch.gradient_coord
+///   and scratch.scalar.
+void SHARPISO::get_gradients
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const GRADIENT_GRID_BASE & gradient_grid,
+	const VERTEX_INDEX cube_index,
+	const SCALAR_TYPE isovalue,
+	const GET_GRADIENTS_PARAM & sharpiso_param,
+	const OFFSET_VOXEL & voxel,
+	const bool flag_sort_gradients,
+	GET_GRADIENTS_SCRATCH & scratch,
+	NUM_TYPE & num_gradients)
+{
+	get_gradients_local
+		(scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
+		voxel, flag_sort_gradients, scratch, scratch.point_coord, 
+		scratch.gradient_coord, scratch.scalar, num_gradients);
 }
 
 /// Get gradients from two cubes sharing a facet.
@@ -1360,8 +1418,7 @@ void SHARPISO::get_cube_neighbor_vertices
 {
 	typedef SHARPISO_SCALAR_GRID::DIMENSION_TYPE DTYPE;
 
-	// static so not reallocated at each call
-	static GRID_COORD_TYPE cube_coord[DIM3];
+	GRID_COORD_TYPE cube_coord[DIM3];
 
 	vertex_list.resize(NUM_CUBE_VERTICES3D);
 	get_cube_vertices(grid, cube_index, &vertex_list[0]);
@@ -1590,9 +1647,10 @@ void SHARPISO::get_vertices_with_large_gradient_magnitudes
 				}
 			}
 
+			// Start at the facet vertex on the upper cube facet.
 			iv = scalar_grid.NextVertex(iv0, d);
 			k = 0;
-			while (k+cube_coord[d]+1 < scalar_grid.AxisSize(d) && k < max_dist) {
+			while (k+cube_coord[d]+2 < scalar_grid.AxisSize(d) && k < max_dist) {
 				iv = scalar_grid.NextVertex(iv, d);
 				k++;
 
@@ -1639,15 +1697,17 @@ void SHARPISO::get_vertices_with_large_gradient_magnitudes
 						xcoef*scalar_grid.AxisIncrement(0) +
 						ycoef*scalar_grid.AxisIncrement(1) + 
 						zcoef*scalar_grid.AxisIncrement(2);
+					// xdiff, ydiff, zdiff are the numbers of grid vertices
+					//   past the upper cube facets.
 					NUM_TYPE kmax = max_grad_dist;
 					kmax = std::min(kmax, cube_coord[0]+xcoef*max_grad_dist);
 					kmax = std::min(kmax, cube_coord[1]+ycoef*max_grad_dist);
 					kmax = std::min(kmax, cube_coord[2]+zcoef*max_grad_dist);
-					GRID_COORD_TYPE xdiff = scalar_grid.AxisSize(0)-cube_coord[0]-1;
+					GRID_COORD_TYPE xdiff = scalar_grid.AxisSize(0)-cube_coord[0]-2;
 					kmax = std::min(kmax, xdiff+(1-xcoef)*max_grad_dist);
-					GRID_COORD_TYPE ydiff = scalar_grid.AxisSize(1)-cube_coord[1]-1;
+					GRID_COORD_TYPE ydiff = scalar_grid.AxisSize(1)-cube_coord[1]-2;
 					kmax = std::min(kmax, ydiff+(1-ycoef)*max_grad_dist);
-					GRID_COORD_TYPE zdiff = scalar_grid.AxisSize(2)-cube_coord[2]-1;
+					GRID_COORD_TYPE zdiff = scalar_grid.AxisSize(2)-cube_coord[2]-2;
 					kmax = std::min(kmax, zdiff+(1-zcoef)*max_grad_dist);
 
 					NUM_TYPE k = 0;
@@ -1732,6 +1792,42 @@ namespace {
 		return(false);
 	}
 
+	/// Return true if subgrid vertex kv is adjacent to a bipolar subgrid edge.
+	/// Scalar values are read from scalar_grid without copying the subgrid.
+	/// @param subgrid subgrid.Scalar(kv) is the index in scalar_grid
+	///   of subgrid vertex kv.
+	/// @param boundary_bits Boundary bits for kv in subgrid.
+	bool is_adjacent_to_bipolar_edge
+		(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+		const SHARPISO_INDEX_GRID & subgrid,
+		const SCALAR_TYPE isovalue,
+		const VERTEX_INDEX kv, const long boundary_bits)
+	{
+		typedef SHARPISO_SCALAR_GRID_BASE::DIMENSION_TYPE DTYPE;
+		const DTYPE dimension = subgrid.Dimension();
+		const VERTEX_INDEX iv = subgrid.Scalar(kv);
+
+		for (DTYPE d = 0; d < dimension; d++) {
+			long mask = (1L << (2*d));
+			long bit = (boundary_bits & mask);
+			if (bit == 0) {
+				VERTEX_INDEX iv2 = subgrid.Scalar(subgrid.PrevVertex(kv, d));
+				if (IJK::is_gt_min_le_max(scalar_grid, iv, iv2, isovalue))
+				{ return(true); }
+			}
+
+			mask = (1L << (2*d+1));
+			bit = (boundary_bits & mask);
+			if (bit == 0) {
+				VERTEX_INDEX iv2 = subgrid.Scalar(subgrid.NextVertex(kv, d));
+				if (IJK::is_gt_min_le_max(scalar_grid, iv, iv2, isovalue))
+				{ return(true); }
+			}
+		}
+
+		return(false);
+	}
+
 };
 
 // Get intersected edge endpoints in large neighborhood.
@@ -1853,6 +1949,24 @@ void SHARPISO::get_ie_endpoints_in_large_neighborhood
 	const VERTEX_INDEX cube_index,
 	const GET_GRADIENTS_PARAM & gradient_param,
 	std::vector<VERTEX_INDEX> & vertex_list)
+{
+	GET_GRADIENTS_SCRATCH scratch;
+
+	get_ie_endpoints_in_large_neighborhood
+		(scalar_grid, gradient_grid, isovalue, cube_index, gradient_param,
+		scratch, vertex_list);
+}
+
+// Get intersected edge endpoints in large neighborhood.
+// Use scratch memory for the search list and subgrids.
+void SHARPISO::get_ie_endpoints_in_large_neighborhood
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const GRADIENT_GRID_BASE & gradient_grid,
+	const SCALAR_TYPE isovalue,
+	const VERTEX_INDEX cube_index,
+	const GET_GRADIENTS_PARAM & gradient_param,
+	GET_GRADIENTS_SCRATCH & scratch,
+	std::vector<VERTEX_INDEX> & vertex_list)
 {
 	typedef SHARPISO_SCALAR_GRID_BASE::DIMENSION_TYPE DTYPE;
 
@@ -1861,11 +1975,16 @@ void SHARPISO::get_ie_endpoints_in_large_neighborhood
 	const GRADIENT_COORD_TYPE max_small_magnitude =
 		gradient_param.max_small_magnitude;
 	VERTEX_INDEX region_iv0, subgrid_cube_index;
-	IJK::ARRAY<AXIS_SIZE_TYPE> region_axis_size(dimension);
-	std::vector<VERTEX_INDEX> vlist2;
+	AXIS_SIZE_TYPE region_axis_size[DIM3];
+	GRID_COORD_TYPE cube_coord[DIM3];
+	GRID_COORD_TYPE region_iv0_coord[DIM3];
+	std::vector<VERTEX_INDEX> & vlist2 = scratch.vlist2;
+	SHARPISO_INDEX_GRID & subgrid = scratch.subgrid;
+	SHARPISO_BOOL_GRID & visited = scratch.visited;
 	long boundary_bits, boundary_bits2;
 
 	vertex_list.clear();
+	vlist2.clear();
 
 	get_cube_vertices_with_large_gradients
 		(scalar_grid, gradient_grid, cube_index, max_small_magnitude,
@@ -1873,19 +1992,19 @@ void SHARPISO::get_ie_endpoints_in_large_neighborhood
 
 	IJK::compute_region_around_cube
 		(cube_index, dimension, scalar_grid.AxisSize(), max_grad_dist,
-		region_iv0, region_axis_size.Ptr());
+		region_iv0, region_axis_size);
 
-	SHARPISO_INDEX_GRID subgrid(dimension, region_axis_size.PtrConst());
+	// SetSize() does not reallocate if the size is unchanged.
+	subgrid.SetSize(dimension, region_axis_size);
 	subgrid.SetToVertexIndices(scalar_grid, region_iv0);
 
 	// Locate subgrid_cube_index
-	subgrid_cube_index = 0;
-	for (VERTEX_INDEX iv = 0; iv < subgrid.NumVertices(); iv++) {
-		if (subgrid.Scalar(iv) == cube_index)
-		{ subgrid_cube_index = iv; }
-	}
+	scalar_grid.ComputeCoord(cube_index, cube_coord);
+	scalar_grid.ComputeCoord(region_iv0, region_iv0_coord);
+	for (DTYPE d = 0; d < dimension; d++)
+		{ cube_coord[d] -= region_iv0_coord[d]; }
+	subgrid_cube_index = subgrid.ComputeVertexIndex(cube_coord);
 
-	SHARPISO_BOOL_GRID visited;
 	visited.SetSize(subgrid);
 
 	visited.SetAll(false);
@@ -1896,12 +2015,6 @@ void SHARPISO::get_ie_endpoints_in_large_neighborhood
 		vlist2.push_back(kv);
 	}
 
-	SHARPISO_SCALAR_GRID scalar_subgrid;
-	scalar_subgrid.SetSize(subgrid);
-
-	scalar_subgrid.CopyRegion
-		(scalar_grid, region_iv0, scalar_subgrid.AxisSize(), 0);
-
 	while (vlist2.size() != 0) {
 		VERTEX_INDEX kv = vlist2.back();
 		vlist2.pop_back();
@@ -1917,7 +2030,7 @@ void SHARPISO::get_ie_endpoints_in_large_neighborhood
 				if (!visited.Scalar(kv2)) {
           subgrid.ComputeBoundaryBits(kv2, boundary_bits2);
           if (is_adjacent_to_bipolar_edge
-              (scalar_subgrid, isovalue, kv2, boundary_bits2)) {
+              (scalar_grid, subgrid, isovalue, kv2, boundary_bits2)) {
 
             VERTEX_INDEX iv2 = subgrid.Scalar(kv2);
             if (!gradient_grid.IsMagnitudeGT(iv2, max_small_magnitude)) {
@@ -1932,11 +2045,10 @@ void SHARPISO::get_ie_endpoints_in_large_neighborhood
 			bit = (boundary_bits & mask);
 			if (bit == 0) {
 				VERTEX_INDEX kv2 = subgrid.NextVertex(kv, d);
-        subgrid.ComputeBoundaryBits(kv2, boundary_bits2);
 				if (!visited.Scalar(kv2)) {
           subgrid.ComputeBoundaryBits(kv2, boundary_bits2);
           if (is_adjacent_to_bipolar_edge
-              (scalar_subgrid, isovalue, kv2, boundary_bits2)) {
+              (scalar_grid, subgrid, isovalue, kv2, boundary_bits2)) {
 
             VERTEX_INDEX iv2 = subgrid.Scalar(kv2);
             if (!gradient_grid.IsMagnitudeGT(iv2, max_small_magnitude)) {
@@ -1955,7 +2067,7 @@ void SHARPISO::get_ie_endpoints_in_large_neighborhood
 
 			if (is_adjacent_to_visited(visited, kv, boundary_bits) &&
 				is_adjacent_to_bipolar_edge
-				(scalar_subgrid, isovalue, kv, boundary_bits)) {
+				(scalar_grid, subgrid, isovalue, kv, boundary_bits)) {
 
 					VERTEX_INDEX iv = subgrid.Scalar(kv);
 					vertex_list.push_back(iv);
@@ -2029,8 +2141,7 @@ void SHARPISO::sort_vertices_by_isoplane_dist2cc
 {
 	typedef SHARPISO_SCALAR_GRID::DIMENSION_TYPE DTYPE;
 
-	// static so not reallocated at each call
-	static COORD_TYPE cube_center[DIM3];
+	COORD_TYPE cube_center[DIM3];
 
 	scalar_grid.ComputeCoord(cube_index, cube_center);
 
@@ -2149,9 +2260,8 @@ void SHARPISO::deselect_vertices_based_on_isoplanes
 {
 	typedef SHARPISO_SCALAR_GRID::DIMENSION_TYPE DTYPE;
 
-	// static so not reallocated at each call
-	static COORD_TYPE vertex_coord[DIM3];
-	static COORD_TYPE coord[DIM3];
+	COORD_TYPE vertex_coord[DIM3];
+	COORD_TYPE coord[DIM3];
 
 	for (NUM_TYPE i = 0; i < num_vertices; i++) {
 
@@ -2197,6 +2307,21 @@ void SHARPISO::deselect_vertices_based_on_isoplanes
 	}
 }
 
+// **************************************************
+// GET_GRADIENTS_SCRATCH
+// **************************************************
+
+bool * SHARPISO::GET_GRADIENTS_SCRATCH::VertexFlag(const NUM_TYPE length)
+{
+	if (length > vertex_flag_length) {
+		delete [] vertex_flag;
+		vertex_flag_length = std::max(length, 2*vertex_flag_length);
+		vertex_flag = new bool[vertex_flag_length];
+	}
+
+	return(vertex_flag);
+}
+
 // **************************************************
 // VOXEL
 // **************************************************
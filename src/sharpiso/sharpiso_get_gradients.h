@@ -44,6 +44,7 @@ namespace SHARPISO {
 
   class OFFSET_VOXEL;
   class GET_GRADIENTS_PARAM;
+  class GET_GRADIENTS_SCRATCH;
   
   // **************************************************
   // ROUTINES TO GET GRADIENTS
@@ -132,6 +133,21 @@ namespace SHARPISO {
    std::vector<SCALAR_TYPE> & scalar,
    NUM_TYPE & num_gradients);
 
+  /// Get gradients in cube and neighboring cubes.
+  /// Use memory in scratch instead of allocating temporary lists.
+  /// Gradients are returned in scratch.point_coord, scratch.gradient_coord
+  ///   and scratch.scalar.
+  void get_gradients
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_GRID_BASE & gradient_grid,
+   const VERTEX_INDEX cube_index,
+   const SCALAR_TYPE isovalue,
+   const GET_GRADIENTS_PARAM & sharpiso_param,
+   const OFFSET_VOXEL & voxel,
+   const bool flag_sort_gradients,
+   GET_GRADIENTS_SCRATCH & scratch,
+   NUM_TYPE & num_gradients);
+
   /// Get gradients from two cubes sharing a facet.
   /// Used in getting gradients around a facet.
   /// @param sharpiso_param Determines which gradients are selected.
@@ -370,6 +386,19 @@ namespace SHARPISO {
    const GET_GRADIENTS_PARAM & gradient_param,
    std::vector<VERTEX_INDEX> & vertex_list);
 
+  /// Get intersected edge endpoints in large neighborhood.
+  /// Use scratch.vlist2, scratch.subgrid and scratch.visited
+  ///   instead of allocating them.
+  /// @pre vertex_list is not scratch.vlist2.
+  void get_ie_endpoints_in_large_neighborhood
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_GRID_BASE & gradient_grid,
+   const SCALAR_TYPE isovalue,
+   const VERTEX_INDEX cube_index,
+   const GET_GRADIENTS_PARAM & gradient_param,
+   GET_GRADIENTS_SCRATCH & scratch,
+   std::vector<VERTEX_INDEX> & vertex_list);
+
   // **************************************************
   // SORT VERTICES
   // **************************************************
@@ -523,6 +552,45 @@ namespace SHARPISO {
       (const GRAD_SELECTION_METHOD grad_selection_method);
   };
 
+  // **************************************************
+  // GET_GRADIENTS_SCRATCH
+  // **************************************************
+
+  /// Temporary lists and grids used in getting gradients.
+  /// Memory is kept between calls, so getting gradients
+  ///   for a sequence of cubes stops allocating memory once the
+  ///   lists and grids reach their largest sizes.
+  /// Not thread safe.  Each thread should use its own scratch.
+  class GET_GRADIENTS_SCRATCH {
+
+  protected:
+    bool * vertex_flag;
+    NUM_TYPE vertex_flag_length;
+
+  public:
+    std::vector<VERTEX_INDEX> vertex_list;
+    std::vector<VERTEX_INDEX> vlist2;
+    std::vector<COORD_TYPE> point_coord;
+    std::vector<GRADIENT_COORD_TYPE> gradient_coord;
+    std::vector<SCALAR_TYPE> scalar;
+    SHARPISO_INDEX_GRID subgrid;
+    SHARPISO_BOOL_GRID visited;
+
+    GET_GRADIENTS_SCRATCH() 
+    { vertex_flag = NULL; vertex_flag_length = 0; };
+    ~GET_GRADIENTS_SCRATCH()
+    { delete [] vertex_flag; };
+
+    /// Return array of at least length flags.
+    /// Array contents are undefined.
+    bool * VertexFlag(const NUM_TYPE length);
+
+  private:
+    // Scratch memory is never copied.
+    GET_GRADIENTS_SCRATCH(const GET_GRADIENTS_SCRATCH &);
+    const GET_GRADIENTS_SCRATCH & operator = (const GET_GRADIENTS_SCRATCH &);
+  };
+
   // **************************************************
   // VOXEL
   // **************************************************
@@ -376,6 +376,119 @@ void SHARPISO::compute_edgeI_linear_interpolate
 }
 
 
+// *****************************************************************
+// CACHE OF ISOSURFACE-EDGE INTERSECTIONS
+// *****************************************************************
+
+const INDEX_DIFF_TYPE SHARPISO::EDGEI_CACHE::NO_INDEX;
+
+// Compute intersections of isosurface and edges of cubes in cube_list[].
+void SHARPISO::EDGEI_CACHE::Set
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const GRADIENT_GRID_BASE & gradient_grid,
+ const SCALAR_TYPE isovalue,
+ const GRADIENT_COORD_TYPE max_small_magnitude,
+ const VERTEX_INDEX cube_list[], const NUM_TYPE num_cubes,
+ const bool flag_linear_interpolate)
+{
+  const VERTEX_INDEX layer_size = scalar_grid.AxisIncrement(2);
+  // layer_edgeI_index[b] is the index of intersections on edges 
+  //   (iv0, dir) where iv0 is in z-layer layer_z[b].
+  std::vector<INDEX_DIFF_TYPE> layer_edgeI_index[2];
+  std::vector<VERTEX_INDEX> layer_set_list[2];
+  VERTEX_INDEX layer_z[2] = { -1, -1 };
+
+  this->isovalue = isovalue;
+  edgeI_coord.clear();
+  edgeI_normal_coord.clear();
+  cube_edgeI_index.assign(num_cubes*NUM_CUBE_EDGES3D, NO_INDEX);
+
+  for (int b = 0; b < 2; b++)
+    { layer_edgeI_index[b].assign(layer_size*DIM3, NO_INDEX); }
+
+  for (NUM_TYPE i = 0; i < num_cubes; i++) {
+    const VERTEX_INDEX cube_index = cube_list[i];
+    INDEX_DIFF_TYPE * cube_edgeI = &(cube_edgeI_index[i*NUM_CUBE_EDGES3D]);
+
+    for (NUM_TYPE edge_dir = 0; edge_dir < DIM3; edge_dir++) {
+      for (NUM_TYPE k = 0; k < NUM_CUBE_FACET_VERTICES3D; k++) {
+        VERTEX_INDEX iend0 =
+          scalar_grid.FacetVertex(cube_index, edge_dir, k);
+        VERTEX_INDEX iend1 = scalar_grid.NextVertex(iend0, edge_dir);
+
+        if (!is_gt_min_le_max(scalar_grid, iend0, iend1, isovalue)) 
+          { continue; }
+
+        const VERTEX_INDEX z = iend0/layer_size;
+        const int b = z%2;
+        std::vector<INDEX_DIFF_TYPE> & edgeI_index = layer_edgeI_index[b];
+        const VERTEX_INDEX jloc = (iend0-z*layer_size)*DIM3 + edge_dir;
+
+        if (layer_z[b] != z) {
+          // Clear index entries set for layer layer_z[b].
+          for (NUM_TYPE m = 0; m < NUM_TYPE(layer_set_list[b].size()); m++)
+            { edgeI_index[layer_set_list[b][m]] = NO_INDEX; }
+          layer_set_list[b].clear();
+          layer_z[b] = z;
+        }
+
+        if (edgeI_index[jloc] == NO_INDEX) {
+          NUM_TYPE num_coord = edgeI_coord.size();
+          edgeI_coord.resize(num_coord+DIM3);
+          edgeI_normal_coord.resize(num_coord+DIM3);
+
+          if (flag_linear_interpolate) {
+            compute_edgeI_linear_interpolate
+              (scalar_grid, gradient_grid, isovalue,
+               iend0, iend1, edge_dir, max_small_magnitude,
+               &(edgeI_coord.front())+num_coord,
+               &(edgeI_normal_coord.front())+num_coord);
+          }
+          else {
+            compute_isosurface_grid_edge_intersection
+              (scalar_grid, gradient_grid, isovalue,
+               iend0, iend1, edge_dir, max_small_magnitude,
+               &(edgeI_coord.front())+num_coord,
+               &(edgeI_normal_coord.front())+num_coord);
+          }
+
+          edgeI_index[jloc] = num_coord/DIM3;
+          layer_set_list[b].push_back(jloc);
+        }
+
+        cube_edgeI[edge_dir*NUM_CUBE_FACET_VERTICES3D+k] = edgeI_index[jloc];
+      }
+    }
+  }
+}
+
+
+// Get intersections of isosurface and edges of cube cube_list[i].
+void SHARPISO::EDGEI_CACHE::GetCubeEdgeI
+(const NUM_TYPE i,
+ std::vector<COORD_TYPE> & cube_edgeI_coord,
+ std::vector<GRADIENT_COORD_TYPE> & cube_edgeI_normal_coord) const
+{
+  const INDEX_DIFF_TYPE * cube_edgeI = 
+    &(cube_edgeI_index[i*NUM_CUBE_EDGES3D]);
+
+  cube_edgeI_coord.clear();
+  cube_edgeI_normal_coord.clear();
+
+  for (NUM_TYPE j = 0; j < NUM_CUBE_EDGES3D; j++) {
+    const INDEX_DIFF_TYPE jedgeI = cube_edgeI[j];
+
+    if (jedgeI != NO_INDEX) {
+      cube_edgeI_coord.insert
+        (cube_edgeI_coord.end(), EdgeICoord(jedgeI), EdgeICoord(jedgeI)+DIM3);
+      cube_edgeI_normal_coord.insert
+        (cube_edgeI_normal_coord.end(), 
+         EdgeINormal(jedgeI), EdgeINormal(jedgeI)+DIM3);
+    }
+  }
+}
+
+
 // *****************************************************************
 // LOCAL ROUTINES
 // *****************************************************************
@@ -124,6 +124,72 @@ namespace SHARPISO {
    COORD_TYPE p[DIM3],
    GRADIENT_COORD_TYPE normal[DIM3]);
 
+  // *****************************************************************
+  // CACHE OF ISOSURFACE-EDGE INTERSECTIONS
+  // *****************************************************************
+
+  /// Intersections of isosurface and the edges of a list of grid cubes,
+  ///   computed once for a single isovalue.
+  /// Each grid edge is intersected once, even though it is shared
+  ///   by up to four cubes.
+  /// Only the edgeI positioning methods (-position gradEC and gradES)
+  ///   read the cache.  The edgeI centroid routines, positioning of
+  ///   merged vertices and the ambiguity handling in mergesharp
+  ///   still intersect each edge themselves.
+  class EDGEI_CACHE {
+
+  protected:
+    SCALAR_TYPE isovalue;
+
+    /// cube_edgeI_index[i*NUM_CUBE_EDGES3D+j] is the index
+    ///   in edgeI_coord[] of the intersection of the j'th edge
+    ///   of the i'th cube in the cube list, or NO_INDEX.
+    /// Cube edges are ordered by direction and then by facet vertex,
+    ///   as in compute_cube_edgeI.
+    std::vector<INDEX_DIFF_TYPE> cube_edgeI_index;
+
+    std::vector<COORD_TYPE> edgeI_coord;
+    std::vector<GRADIENT_COORD_TYPE> edgeI_normal_coord;
+
+  public:
+    static const INDEX_DIFF_TYPE NO_INDEX = -1;  ///< Flag for no index.
+
+    EDGEI_CACHE() { isovalue = 0; };
+
+    /// Compute intersections of isosurface and edges of cubes
+    ///   in cube_list[].
+    /// Edges shared by cubes in consecutive z-layers are found
+    ///   using a two layer index, so cube_list[] should be
+    ///   in increasing order.  Otherwise, some edges are intersected
+    ///   more than once.
+    /// @param flag_linear_interpolate If true, use linear interpolation
+    ///   (compute_edgeI_linear_interpolate).  Otherwise, use sharp formula
+    ///   (compute_isosurface_grid_edge_intersection).
+    void Set(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+             const GRADIENT_GRID_BASE & gradient_grid,
+             const SCALAR_TYPE isovalue,
+             const GRADIENT_COORD_TYPE max_small_magnitude,
+             const VERTEX_INDEX cube_list[], const NUM_TYPE num_cubes,
+             const bool flag_linear_interpolate);
+
+    SCALAR_TYPE Isovalue() const { return(isovalue); };
+    NUM_TYPE NumCubes() const
+    { return(cube_edgeI_index.size()/NUM_CUBE_EDGES3D); };
+    NUM_TYPE NumEdgeI() const { return(edgeI_coord.size()/DIM3); };
+
+    const COORD_TYPE * EdgeICoord(const NUM_TYPE j) const
+    { return(&(edgeI_coord[j*DIM3])); };
+    const GRADIENT_COORD_TYPE * EdgeINormal(const NUM_TYPE j) const
+    { return(&(edgeI_normal_coord[j*DIM3])); };
+
+    /// Get intersections of isosurface and edges of cube cube_list[i].
+    /// Intersections are listed in the same order as compute_cube_edgeI.
+    void GetCubeEdgeI
+    (const NUM_TYPE i,
+     std::vector<COORD_TYPE> & cube_edgeI_coord,
+     std::vector<GRADIENT_COORD_TYPE> & cube_edgeI_normal_coord) const;
+  };
+
 };
 
 #endif
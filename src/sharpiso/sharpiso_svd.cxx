@@ -210,6 +210,205 @@ void svd_calculate_sharpiso_vertex_using_lindstrom_fast(
 }
 
 
+// **************************************************
+// BATCHED LINDSTROM 3x3 SOLVER
+// **************************************************
+
+// Add normal equations of a cube.  Return index of cube in batch.
+NUM_TYPE LINDSTROM_3x3_BATCH::AddCube(
+		const NUM_TYPE num_vert,
+		const SCALAR_TYPE isovalue,
+		const SCALAR_TYPE * vert_scalars,
+		const COORD_TYPE * vert_coords,
+		const GRADIENT_COORD_TYPE * vert_grads,
+		const COORD_TYPE * central_point)
+{
+	if (num_cubes >= LINDSTROM_BATCH_SIZE) {
+		// Construct error only when needed, since it allocates memory.
+		IJK::PROCEDURE_ERROR error ("LINDSTROM_3x3_BATCH::AddCube");
+		error.AddMessage("Programming error.  Batch is full.");
+		throw error;
+	}
+
+	// Accumulate A^t A and A^t b exactly as in
+	//   svd_calculate_sharpiso_vertex_using_lindstrom_fast.
+	SCALAR_TYPE A[6]={0.0};
+	SCALAR_TYPE B[DIM3]={0.0};
+	for (int i=0;i<num_vert;i++){
+		SCALAR_TYPE tempN[DIM3]={0.0};
+		normalize(&(vert_grads[DIM3 * i]),tempN);
+
+		A[0] += tempN[0]*tempN[0];
+		A[1] += tempN[0]*tempN[1];
+		A[2] += tempN[0]*tempN[2];
+		A[3] += tempN[1]*tempN[1];
+		A[4] += tempN[1]*tempN[2];
+		A[5] += tempN[2]*tempN[2];
+
+		SCALAR_TYPE iprod,d;
+		compute_inner_product(DIM3, tempN,&(vert_coords[DIM3 * i]), iprod);
+		SCALAR_TYPE gradient_magnitude;
+		IJK::compute_magnitude(DIM3,&(vert_grads[DIM3 * i]),gradient_magnitude );
+
+		d = -1.0*iprod + (vert_scalars[i] - isovalue)/gradient_magnitude;
+
+		for(int l=0;l<DIM3;l++)
+			B[l]+=  (tempN[l]*(-1.0)*d);
+	}
+
+	const NUM_TYPE k = num_cubes;
+	for (int j = 0; j < 6; j++)
+		{ ata[j][k] = A[j]; }
+
+	const double c0 = central_point[0];
+	const double c1 = central_point[1];
+	const double c2 = central_point[2];
+	this->central_point[0][k] = c0;
+	this->central_point[1][k] = c1;
+	this->central_point[2][k] = c2;
+	residual[0][k] = B[0] - (ata[0][k]*c0 + ata[1][k]*c1 + ata[2][k]*c2);
+	residual[1][k] = B[1] - (ata[1][k]*c0 + ata[3][k]*c1 + ata[4][k]*c2);
+	residual[2][k] = B[2] - (ata[2][k]*c0 + ata[4][k]*c1 + ata[5][k]*c2);
+
+	num_cubes++;
+	return(k);
+}
+
+namespace {
+
+	// Number of cyclic Jacobi sweeps.
+	// Off-diagonal entries of a 3x3 matrix converge quadratically
+	//   to zero, so six sweeps reach double precision.
+	const int NUM_JACOBI_SWEEPS = 6;
+
+	// Apply Jacobi rotation to zero apq for batch cubes [0,n).
+	// Index r is the third index, not p or q.
+	// vp and vq are columns p and q of the eigenvector matrices.
+	void jacobi_rotate_batch
+	(const NUM_TYPE n, double * app, double * aqq, double * apq,
+	 double * arp, double * arq, double * vp[DIM3], double * vq[DIM3])
+	{
+		for (NUM_TYPE k = 0; k < n; k++) {
+			const double a_pq = apq[k];
+			const bool flag_rotate = (a_pq != 0.0);
+			const double theta =
+				(aqq[k] - app[k])/(flag_rotate ? 2.0*a_pq : 1.0);
+			double t = 1.0/(std::abs(theta) + std::sqrt(theta*theta+1.0));
+			t = (theta < 0.0) ? -t : t;
+			t = flag_rotate ? t : 0.0;
+			const double c = 1.0/std::sqrt(t*t+1.0);
+			const double s = t*c;
+
+			app[k] -= t*a_pq;
+			aqq[k] += t*a_pq;
+			apq[k] = 0.0;
+
+			const double a_rp = arp[k];
+			const double a_rq = arq[k];
+			arp[k] = c*a_rp - s*a_rq;
+			arq[k] = s*a_rp + c*a_rq;
+
+			for (int i = 0; i < DIM3; i++) {
+				const double v_ip = vp[i][k];
+				const double v_iq = vq[i][k];
+				vp[i][k] = c*v_ip - s*v_iq;
+				vq[i][k] = s*v_ip + c*v_iq;
+			}
+		}
+	}
+
+	// Swap eigenvalues di, dj and eigenvectors vi, vj if dj > di.
+	void sort_eigen_pair_batch
+	(const NUM_TYPE n, double * di, double * dj,
+	 double * vi[DIM3], double * vj[DIM3])
+	{
+		for (NUM_TYPE k = 0; k < n; k++) {
+			const bool flag_swap = (dj[k] > di[k]);
+			const double d_i = di[k];
+			const double d_j = dj[k];
+			di[k] = flag_swap ? d_j : d_i;
+			dj[k] = flag_swap ? d_i : d_j;
+			for (int l = 0; l < DIM3; l++) {
+				const double v_i = vi[l][k];
+				const double v_j = vj[l][k];
+				vi[l][k] = flag_swap ? v_j : v_i;
+				vj[l][k] = flag_swap ? v_i : v_j;
+			}
+		}
+	}
+
+}
+
+// Solve the normal equations of all cubes in batch.
+void compute_lindstrom_3x3_batch
+(const EIGENVALUE_TYPE err_tolerance, LINDSTROM_3x3_BATCH & batch)
+{
+	const NUM_TYPE n = batch.num_cubes;
+
+	// Copy of A^t A which is diagonalized in place.
+	double a[6][LINDSTROM_BATCH_SIZE];
+	// v[i][j] is row i, column j of the eigenvector matrices.
+	double v[DIM3][DIM3][LINDSTROM_BATCH_SIZE];
+
+	for (int j = 0; j < 6; j++) {
+		for (NUM_TYPE k = 0; k < n; k++)
+			{ a[j][k] = batch.ata[j][k]; }
+	}
+	for (int i = 0; i < DIM3; i++) {
+		for (int j = 0; j < DIM3; j++) {
+			const double x = (i == j) ? 1.0 : 0.0;
+			for (NUM_TYPE k = 0; k < n; k++)
+				{ v[i][j][k] = x; }
+		}
+	}
+
+	// Columns of the eigenvector matrices.
+	double * v0[DIM3] = { v[0][0], v[1][0], v[2][0] };
+	double * v1[DIM3] = { v[0][1], v[1][1], v[2][1] };
+	double * v2[DIM3] = { v[0][2], v[1][2], v[2][2] };
+
+	for (int isweep = 0; isweep < NUM_JACOBI_SWEEPS; isweep++) {
+		// a[0..5] are entries 00, 01, 02, 11, 12, 22.
+		jacobi_rotate_batch(n, a[0], a[3], a[1], a[2], a[4], v0, v1);
+		jacobi_rotate_batch(n, a[0], a[5], a[2], a[1], a[4], v0, v2);
+		jacobi_rotate_batch(n, a[3], a[5], a[4], a[1], a[2], v1, v2);
+	}
+
+	// Sort eigenvalues in decreasing order.
+	sort_eigen_pair_batch(n, a[0], a[3], v0, v1);
+	sort_eigen_pair_batch(n, a[0], a[5], v0, v2);
+	sort_eigen_pair_batch(n, a[3], a[5], v1, v2);
+
+	double * d[DIM3] = { a[0], a[3], a[5] };
+	double ** vcol[DIM3] = { v0, v1, v2 };
+
+	for (NUM_TYPE k = 0; k < n; k++) {
+		batch.num_large_eigenvalues[k] = 0;
+		for (int i = 0; i < DIM3; i++)
+			{ batch.coord[i][k] = batch.central_point[i][k]; }
+	}
+
+	for (int j = 0; j < DIM3; j++) {
+		double * dj = d[j];
+		double ** vj = vcol[j];
+		for (NUM_TYPE k = 0; k < n; k++) {
+			const double scaled_error_tolerance = err_tolerance*d[0][k];
+			const bool flag_large =
+				(dj[k] > 0.0 && dj[k] >= scaled_error_tolerance);
+			const double vr =
+				vj[0][k]*batch.residual[0][k] + vj[1][k]*batch.residual[1][k] +
+				vj[2][k]*batch.residual[2][k];
+			const double w = flag_large ? vr/dj[k] : 0.0;
+
+			for (int i = 0; i < DIM3; i++)
+				{ batch.coord[i][k] += w*vj[i][k]; }
+			batch.eigenvalues[j][k] = flag_large ? dj[k] : 0.0;
+			batch.num_large_eigenvalues[k] += (flag_large ? 1 : 0);
+		}
+	}
+}
+
+
 // Calculate the sharp iso vertex using SVD,
 // and the lindstrom approach
 // this is called from svd_compute_sharp_vertex_for_cube in sharpiso_feature.cxx
@@ -606,7 +805,7 @@ void compute_sigma
 		const int max_num_singular,
 		MatrixXf & sigma_plus,
 		MatrixXf & sigma,
-		int & num_large_singular)
+		NUM_TYPE & num_large_singular)
 {
 	int num_sval = singular_values.rows();
 
@@ -639,7 +838,7 @@ void compute_sigma
 // it calculates the sigma interms of the given tolerance
 // debug change this to error type.
 void compute_A_pseudoinverse(const MatrixXf &A, MatrixXf & singular_values,
-		const float err_tolerance, int & num_large_singular,
+		const float err_tolerance, NUM_TYPE & num_large_singular,
 		MatrixXf &pseudoinverseA) {
 	// Compute the singular values for the matrix
 	JacobiSVD<MatrixXf> svd(A, ComputeThinU | ComputeThinV);
@@ -662,7 +861,7 @@ void compute_A_pseudoinverse(const MatrixXf &A, MatrixXf & singular_values,
 void compute_cube_vertex
 (const MatrixXf &A, const RowVectorXf &b,
 		MatrixXf &singular_values, const float err_tolerance,
-		int & num_large_sval, const RowVectorXf &centroid, float * sharp_point)
+		NUM_TYPE & num_large_sval, const RowVectorXf &centroid, float * sharp_point)
 {
 	// Compute the singular values for the matrix
 	JacobiSVD<MatrixXf> svd(A, ComputeThinU | ComputeThinV);
@@ -692,7 +891,7 @@ void compute_cube_vertex_lind2
 (const MatrixXf &A, const RowVectorXf &b,
 		MatrixXf &singular_values,
 		const float err_tolerance,
-		int & num_large_sval,
+		NUM_TYPE & num_large_sval,
 		const RowVectorXf &centroid,
 		float * sharp_point)
 {
@@ -721,7 +920,7 @@ void compute_cube_vertex_lind2
 // it calculates the sigma interms of the given tolerance
 void compute_A_pseudoinverse_top_2(const MatrixXf &A,
 		MatrixXf &singular_values, const float err_tolerance,
-		int & num_large_singular, MatrixXf & inA) {
+		NUM_TYPE & num_large_singular, MatrixXf & inA) {
 	// Compute the singular values for the matrix
 	JacobiSVD<MatrixXf> svd(A, ComputeThinU | ComputeThinV);
 	singular_values = svd.singularValues();
@@ -111,6 +111,59 @@ void svd_calculate_sharpiso_vertex_using_lindstrom_fast(
 		COORD_TYPE * mass_point,
 		COORD_TYPE * isoVertcoords);
 
+// Lindstrom normal equations (A^t A) x = A^t b for a batch of cubes.
+// Structure of arrays.  Entry k of each array belongs to batch cube k.
+// Arrays have fixed size, so no memory is allocated.
+class LINDSTROM_3x3_BATCH {
+
+public:
+	NUM_TYPE num_cubes;
+
+	// Entries 00, 01, 02, 11, 12, 22 of A^t A.
+	double ata[6][LINDSTROM_BATCH_SIZE];
+
+	// A^t b - (A^t A) c where c is the central point.
+	double residual[DIM3][LINDSTROM_BATCH_SIZE];
+	double central_point[DIM3][LINDSTROM_BATCH_SIZE];
+
+	// Output.
+	// Large eigenvalues of A^t A in decreasing order.
+	// Small eigenvalues are set to zero.
+	double coord[DIM3][LINDSTROM_BATCH_SIZE];
+	double eigenvalues[DIM3][LINDSTROM_BATCH_SIZE];
+	NUM_TYPE num_large_eigenvalues[LINDSTROM_BATCH_SIZE];
+
+	LINDSTROM_3x3_BATCH() { num_cubes = 0; };
+
+	// Add normal equations of a cube.  Return index of cube in batch.
+	// Gradients are normalized as in
+	//   svd_calculate_sharpiso_vertex_using_lindstrom_fast.
+	// @pre num_cubes < LINDSTROM_BATCH_SIZE.
+	NUM_TYPE AddCube(
+		const NUM_TYPE num_vert,
+		const SCALAR_TYPE isovalue,
+		const SCALAR_TYPE * vert_scalars,
+		const COORD_TYPE * vert_coords,
+		const GRADIENT_COORD_TYPE * vert_grads,
+		const COORD_TYPE * central_point);
+
+	// Remove all cubes.
+	void Clear() { num_cubes = 0; };
+};
+
+// Solve the normal equations of all cubes in batch.
+// Uses a fixed number of cyclic Jacobi sweeps on each 3x3 symmetric
+//   matrix A^t A.  Loops run over the batch cubes so that the
+//   compiler can vectorize them.
+// Eigenvalues less than err_tolerance times the largest eigenvalue
+//   are ignored, the same cutoff as the Eigen JacobiSVD path.
+// Computation is in double precision while the Eigen path is in float,
+//   so results differ by rounding.  A cube with an eigenvalue
+//   near the cutoff may get a different number of large eigenvalues.
+// Used only with -batch_svd.  Eigen JacobiSVD is the default.
+void compute_lindstrom_3x3_batch
+(const EIGENVALUE_TYPE err_tolerance, LINDSTROM_3x3_BATCH & batch);
+
 // Calculate the svd based sharp isovertex but force it to have 2 singular values.
 void svd_calculate_sharpiso_vertex_2_svals_unit_normals
 (const COORD_TYPE * vert_coords,
@@ -127,13 +180,13 @@ void svd_calculate_sharpiso_vertex_2_svals_unit_normals
 
 void compute_cube_vertex
 (const MatrixXf &A, const RowVectorXf &b, MatrixXf &singular_values,
-		const float  err_tolerance, int &num_singular_vals,
+		const float  err_tolerance, NUM_TYPE &num_singular_vals,
 		const RowVectorXf &centroid, float * sharp_point);
 
 // Compute Cube Vertex using the modified Lindstrom formula
 void compute_cube_vertex_lind2(const MatrixXf &A, const RowVectorXf &b,
 		MatrixXf &singular_values, const float err_tolerance,
-		int & num_large_sval, const RowVectorXf &centroid, float * sharp_point);
+		NUM_TYPE & num_large_sval, const RowVectorXf &centroid, float * sharp_point);
 
 // Compute A inverse using svd
 /*
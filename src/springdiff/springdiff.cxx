@@ -21,7 +21,12 @@
  Foundation, Inc., 89 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+#include <atomic>
 #include <iomanip>
+#include <thread>
+#include <vector>
+
 #include "springdiff.h"
 #include "ijkscalar_grid.txx"
 #include "sharpiso_scalar.txx"
@@ -250,6 +255,278 @@ void compute_spring_diffusion
 };
 
 
+
+// **************************************************
+// TILED SPRING DIFFUSION
+// **************************************************
+
+namespace {
+
+  // Number of vertices along each axis of a tile.
+  const GRID_COORD_TYPE SPRING_TILE_SIZE = 32;
+
+  // Number of diffusion iterations computed on a tile
+  //   before moving to the next tile.
+  const int SPRING_ITER_PER_TILE = 2;
+
+  // Return true if coord is on the boundary of scalar_grid.
+  bool is_boundary_coord
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRID_COORD_TYPE coord[DIM3])
+  {
+    for (int d = 0; d < DIM3; d++) {
+      if (coord[d] == 0 || coord[d]+1 == scalar_grid.AxisSize(d))
+        { return(true); }
+    }
+    return(false);
+  }
+
+  // Return squared magnitude of vector grad, summed in the same order
+  //   as GRADIENT_GRID::ComputeMagnitudeSquared.
+  GRADIENT_COORD_TYPE compute_magnitude_squared
+  (const GRADIENT_COORD_TYPE * grad)
+  {
+    GRADIENT_COORD_TYPE magnitude_squared = 0;
+    for (int d = 0; d < DIM3; d++)
+      { magnitude_squared += grad[d]*grad[d]; }
+    return(magnitude_squared);
+  }
+
+  // Add the spring force from neighbor u to gdiff.
+  // Same computation as compute_dist_for_v and update_gdiff,
+  //   but with gradients and coordinates passed directly.
+  void add_spring_force
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const float lambda, const float mu,
+   const VERTEX_INDEX iv, const GRID_COORD_TYPE coord_iv[DIM3],
+   const GRADIENT_COORD_TYPE * grad_iv,
+   const VERTEX_INDEX u, const GRID_COORD_TYPE coord_u[DIM3],
+   const GRADIENT_COORD_TYPE * grad_u,
+   GRADIENT_COORD_TYPE gdiff[DIM3])
+  {
+    float distance = 0.0;
+    float weighted_dist = 0.0;
+
+    compute_distance_to_gfield_plane
+      (grad_u, coord_u, scalar_grid.Scalar(u), coord_iv,
+       scalar_grid.Scalar(iv), distance);
+    f(lambda, mu, distance, weighted_dist);
+
+    for (int d = 0; d < DIM3; d++)
+      { gdiff[d] = gdiff[d] + weighted_dist*(grad_u[d] - grad_iv[d]); }
+  }
+
+  // Compute the new gradient at interior vertex iv.
+  // @param grad_iv Gradient at iv in a local buffer.
+  // @param local_inc Axis increments (in vertices) of the local buffer.
+  void compute_spring_gradient
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const float lambda, const float mu,
+   const VERTEX_INDEX iv, const GRID_COORD_TYPE coord_iv[DIM3],
+   const GRADIENT_COORD_TYPE * grad_iv, const VERTEX_INDEX local_inc[DIM3],
+   GRADIENT_COORD_TYPE new_grad[DIM3])
+  {
+    GRADIENT_COORD_TYPE gdiff[DIM3] = {0.0};
+    GRID_COORD_TYPE coord_u[DIM3];
+
+    std::copy(coord_iv, coord_iv+DIM3, coord_u);
+
+    for (int d = 0; d < DIM3; d++) {
+      const VERTEX_INDEX inc = scalar_grid.AxisIncrement(d);
+
+      // prev vertex to iv
+      const GRADIENT_COORD_TYPE * grad_prev = grad_iv - DIM3*local_inc[d];
+      if (compute_magnitude_squared(grad_prev) > EPSILON) {
+        coord_u[d] = coord_iv[d]-1;
+        add_spring_force(scalar_grid, lambda, mu, iv, coord_iv, grad_iv,
+                         iv-inc, coord_u, grad_prev, gdiff);
+      }
+
+      // next vertex to iv
+      const GRADIENT_COORD_TYPE * grad_next = grad_iv + DIM3*local_inc[d];
+      if (compute_magnitude_squared(grad_next) > EPSILON) {
+        coord_u[d] = coord_iv[d]+1;
+        add_spring_force(scalar_grid, lambda, mu, iv, coord_iv, grad_iv,
+                         iv+inc, coord_u, grad_next, gdiff);
+      }
+
+      coord_u[d] = coord_iv[d];
+    }
+
+    for (int d = 0; d < DIM3; d++)
+      { new_grad[d] = grad_iv[d] + gdiff[d]; }
+  }
+
+  // Run num_tile_iter diffusion iterations on a single tile.
+  // Gradients in the tile and a halo of width num_tile_iter are copied
+  //   into buffer0, and each iteration computes the new gradients on
+  //   the tile and a halo one vertex narrower than the previous one.
+  // Results in the tile are written to new_gradient_grid.
+  void spring_diffusion_tile
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const int num_tile_iter, const float lambda, const float mu,
+   const GRID_COORD_TYPE tile_min[DIM3], const GRID_COORD_TYPE tile_max[DIM3],
+   const GRADIENT_GRID & gradient_grid,
+   std::vector<GRADIENT_COORD_TYPE> & buffer0,
+   std::vector<GRADIENT_COORD_TYPE> & buffer1,
+   GRADIENT_GRID & new_gradient_grid)
+  {
+    GRID_COORD_TYPE ext_min[DIM3], ext_max[DIM3];
+    GRID_COORD_TYPE region_min[DIM3], region_max[DIM3];
+    VERTEX_INDEX local_inc[DIM3];
+    GRID_COORD_TYPE coord[DIM3];
+
+    for (int d = 0; d < DIM3; d++) {
+      ext_min[d] = std::max(tile_min[d]-num_tile_iter, 0);
+      ext_max[d] =
+        std::min(tile_max[d]+num_tile_iter, scalar_grid.AxisSize(d));
+    }
+    local_inc[0] = 1;
+    local_inc[1] = ext_max[0]-ext_min[0];
+    local_inc[2] = local_inc[1]*(ext_max[1]-ext_min[1]);
+    const VERTEX_INDEX num_local = local_inc[2]*(ext_max[2]-ext_min[2]);
+    buffer0.resize(DIM3*num_local);
+    buffer1.resize(DIM3*num_local);
+
+    // Copy gradients in the tile and its halo into buffer0.
+    for (coord[2] = ext_min[2]; coord[2] < ext_max[2]; coord[2]++) {
+      for (coord[1] = ext_min[1]; coord[1] < ext_max[1]; coord[1]++) {
+        coord[0] = ext_min[0];
+        const VERTEX_INDEX iv = scalar_grid.ComputeVertexIndex(coord);
+        const VERTEX_INDEX jv =
+          (coord[1]-ext_min[1])*local_inc[1] + (coord[2]-ext_min[2])*local_inc[2];
+        const GRADIENT_COORD_TYPE * grad_row = gradient_grid.VectorPtrConst(iv);
+        std::copy(grad_row, grad_row+DIM3*local_inc[1], &(buffer0[DIM3*jv]));
+      }
+    }
+
+    GRADIENT_COORD_TYPE * grad_in = &(buffer0[0]);
+    GRADIENT_COORD_TYPE * grad_out = &(buffer1[0]);
+
+    for (int k = 1; k <= num_tile_iter; k++) {
+
+      for (int d = 0; d < DIM3; d++) {
+        region_min[d] = std::max(tile_min[d]-(num_tile_iter-k), 0);
+        region_max[d] =
+          std::min(tile_max[d]+(num_tile_iter-k), scalar_grid.AxisSize(d));
+      }
+
+      for (coord[2] = region_min[2]; coord[2] < region_max[2]; coord[2]++) {
+        for (coord[1] = region_min[1]; coord[1] < region_max[1]; coord[1]++) {
+          coord[0] = region_min[0];
+          const VERTEX_INDEX iv_row = scalar_grid.ComputeVertexIndex(coord);
+          const VERTEX_INDEX jv_row =
+            (coord[0]-ext_min[0]) + (coord[1]-ext_min[1])*local_inc[1] +
+            (coord[2]-ext_min[2])*local_inc[2];
+
+          for (; coord[0] < region_max[0]; coord[0]++) {
+            const VERTEX_INDEX iv = iv_row + (coord[0]-region_min[0]);
+            const VERTEX_INDEX jv = jv_row + (coord[0]-region_min[0]);
+
+            if (is_boundary_coord(scalar_grid, coord)) {
+              compute_boundary_gradient(scalar_grid, iv, grad_out+DIM3*jv);
+            }
+            else {
+              compute_spring_gradient
+                (scalar_grid, lambda, mu, iv, coord, grad_in+DIM3*jv,
+                 local_inc, grad_out+DIM3*jv);
+            }
+          }
+        }
+      }
+
+      std::swap(grad_in, grad_out);
+    }
+
+    // Copy gradients in the tile to new_gradient_grid.
+    const VERTEX_INDEX tile_row_length = tile_max[0]-tile_min[0];
+    for (coord[2] = tile_min[2]; coord[2] < tile_max[2]; coord[2]++) {
+      for (coord[1] = tile_min[1]; coord[1] < tile_max[1]; coord[1]++) {
+        coord[0] = tile_min[0];
+        const VERTEX_INDEX iv = scalar_grid.ComputeVertexIndex(coord);
+        const VERTEX_INDEX jv =
+          (coord[0]-ext_min[0]) + (coord[1]-ext_min[1])*local_inc[1] +
+          (coord[2]-ext_min[2])*local_inc[2];
+        std::copy(grad_in+DIM3*jv, grad_in+DIM3*(jv+tile_row_length),
+                  new_gradient_grid.VectorPtr(iv));
+      }
+    }
+  }
+
+}
+
+
+// Spring based diffusion computed on tiles.
+void compute_spring_diffusion_tiled
+(const SHARPISO_SCALAR_GRID_BASE &scalar_grid,
+ const int num_iter,
+ const float lambda,
+ const float mu,
+ const int num_threads,
+ GRADIENT_GRID & gradient_grid)
+{
+  const int dimension = scalar_grid.Dimension();
+  GRID_COORD_TYPE num_tiles_along_axis[DIM3];
+
+  GRADIENT_GRID buffer_grid;
+  buffer_grid.SetSize(scalar_grid, dimension);
+
+  int num_tiles = 1;
+  for (int d = 0; d < DIM3; d++) {
+    num_tiles_along_axis[d] =
+      (scalar_grid.AxisSize(d)+SPRING_TILE_SIZE-1)/SPRING_TILE_SIZE;
+    num_tiles *= num_tiles_along_axis[d];
+  }
+  const int nthreads = std::max(1, std::min(num_threads, num_tiles));
+
+  GRADIENT_GRID * current_grid = &gradient_grid;
+  GRADIENT_GRID * next_grid = &buffer_grid;
+
+  int iter = 0;
+  while (iter < num_iter) {
+    const int num_tile_iter = std::min(SPRING_ITER_PER_TILE, num_iter-iter);
+    std::atomic<int> next_tile(0);
+
+    auto process_tiles = [&]() {
+      std::vector<GRADIENT_COORD_TYPE> buffer0, buffer1;
+      GRID_COORD_TYPE tile_min[DIM3], tile_max[DIM3];
+      int itile;
+
+      while ((itile = next_tile++) < num_tiles) {
+        int j = itile;
+        for (int d = 0; d < DIM3; d++) {
+          tile_min[d] = (j%num_tiles_along_axis[d])*SPRING_TILE_SIZE;
+          tile_max[d] = std::min(tile_min[d]+SPRING_TILE_SIZE,
+                                 scalar_grid.AxisSize(d));
+          j = j/num_tiles_along_axis[d];
+        }
+
+        spring_diffusion_tile
+          (scalar_grid, num_tile_iter, lambda, mu, tile_min, tile_max,
+           *current_grid, buffer0, buffer1, *next_grid);
+      }
+    };
+
+    if (nthreads <= 1) {
+      process_tiles();
+    }
+    else {
+      std::vector<std::thread> thread_list;
+      for (int i = 0; i < nthreads; i++)
+        { thread_list.push_back(std::thread(process_tiles)); }
+      for (int i = 0; i < nthreads; i++)
+        { thread_list[i].join(); }
+    }
+
+    std::swap(current_grid, next_grid);
+    iter += num_tile_iter;
+  }
+
+  if (current_grid != &gradient_grid)
+    { gradient_grid.CopyVector(*current_grid); }
+}
+
+
 //local routines 
 // Calculate vector magnitude.
 void vector_magnitude (const float * vec, const int num_elements, float & mag)
@@ -37,4 +37,15 @@ void compute_spring_diffusion
  const float mu,
  SHARPISO::GRADIENT_GRID & gradient_grid);
 
+// Spring based diffusion computed on cache sized tiles.
+// Several iterations are computed on each tile before moving
+//   to the next tile, and tiles are split among num_threads threads.
+// Returns the same gradients as compute_spring_diffusion.
+void compute_spring_diffusion_tiled
+(const SHARPISO::SHARPISO_SCALAR_GRID_BASE &scalar_grid,
+ const int num_iter,
+ const float lambda,
+ const float mu,
+ const int num_threads,
+ SHARPISO::GRADIENT_GRID & gradient_grid);
 
@@ -44,6 +44,8 @@ bool flag_gzip = false;
 int num_iter=20;
 float lambda = 0.25;
 float mu = 0.1;
+int num_threads = 1;
+bool flag_sweep = false;
 
 
 using namespace std;
@@ -83,7 +85,14 @@ int main(int argc, char **argv)
 		// compute the central difference
 		compute_gradient_central_difference(full_scalar_grid, gradient_grid);
 		// compute the spring diffusion
-		compute_spring_diffusion(full_scalar_grid, num_iter, lambda, mu, gradient_grid);
+		if (flag_sweep) {
+			compute_spring_diffusion
+			(full_scalar_grid, num_iter, lambda, mu, gradient_grid);
+		}
+		else {
+			compute_spring_diffusion_tiled
+			(full_scalar_grid, num_iter, lambda, mu, num_threads, gradient_grid);
+		}
 
 
 		if (flag_gzip) {
@@ -161,6 +170,14 @@ void parse_command_line(int argc, char **argv, INFO &inf)
 			sscanf(argv[iarg], "%f", &mu);
 			inf.in_info.mu=atof(argv[iarg]);
 		}
+		else if (string(argv[iarg]) == "-threads")
+		{
+			iarg++;
+			if (iarg >= argc) { usage_error(); };
+			sscanf(argv[iarg], "%d", &num_threads);
+		}
+		else if (string(argv[iarg]) == "-sweep")
+		{ flag_sweep = true; }
 		else
 		{ usage_error(); }
 		iarg++;
@@ -178,7 +195,9 @@ void usage_msg()
 	cerr <<"options: "<<endl;
 	cerr <<"\t\t-num_iter <n>  number of iterations."<<endl;
 	cerr <<"\t\t-lambda <f>"<<endl;
-	cerr<<"\t\t-mu <f>\n" << endl;
+	cerr <<"\t\t-mu <f>"<<endl;
+	cerr <<"\t\t-threads <n>  number of threads."<<endl;
+	cerr<<"\t\t-sweep  diffuse with full grid sweeps instead of tiles.\n" << endl;
 }
 
 void usage_error()